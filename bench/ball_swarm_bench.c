@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/types.h"
+#include "../src/simd.h"
+#include "../src/ball_swarm.h"
+
+/*
+ * Microbenchmark for the chaos mode ball swarm in src/ball_swarm.c, how the
+ * update time per frame scales with ball count for each kernel level.
+ *
+ * The AoS row runs the same integrate + bounce over an array of our
+ * struct ball (float position, int velocity) as a baseline for the layout.
+ */
+
+#define BENCH_MIN_SECONDS 0.25
+#define BENCH_VERIFY_BALLS 1001 // not a whole number of lanes on purpose
+#define BENCH_VERIFY_FRAMES 2000
+
+static double seconds_since(Uint64 start_counter)
+{
+	return (double)(SDL_GetPerformanceCounter() - start_counter) / (double)SDL_GetPerformanceFrequency();
+}
+
+static void update_aos(struct ball* balls, int count, float step_ticks)
+{
+	float max_x = (float)(WINDOW_WIDTH - BALL_SIZE);
+	float max_y = (float)(WINDOW_HEIGHT - BALL_SIZE);
+
+	for (int i = 0; i < count; i++)
+	{
+		struct ball* ball = &balls[i];
+		ball->x += ball->dx * step_ticks;
+		ball->y += ball->dy * step_ticks;
+
+		if (ball->x < 0.0f) { ball->x = -ball->x; ball->dx = -ball->dx; }
+		else if (ball->x > max_x) { ball->x = (max_x * 2.0f) - ball->x; ball->dx = -ball->dx; }
+
+		if (ball->y < 0.0f) { ball->y = -ball->y; ball->dy = -ball->dy; }
+		else if (ball->y > max_y) { ball->y = (max_y * 2.0f) - ball->y; ball->dy = -ball->dy; }
+	}
+}
+
+/// <summary>
+///		Runs the swarm for a while on every level and checks they all end up bit for bit where scalar does
+/// </summary>
+static int verify_kernels()
+{
+	struct ball_swarm expected;
+	struct ball_swarm actual;
+	int is_ok = TRUE;
+
+	init_ball_swarm(&expected, BENCH_VERIFY_BALLS);
+	init_ball_swarm(&actual, BENCH_VERIFY_BALLS);
+
+	ball_swarm_set_simd_level(SIMD_LEVEL_SCALAR);
+	spawn_ball_swarm(&expected, BENCH_VERIFY_BALLS, 7);
+
+	for (int frame = 0; frame < BENCH_VERIFY_FRAMES; frame++)
+		update_ball_swarm(&expected, (frame % 5) + 0.5f);
+
+	for (int level = SIMD_LEVEL_SSE2; level <= SIMD_LEVEL_AVX2; level++)
+	{
+		if (ball_swarm_set_simd_level(level) != level)
+			continue;
+
+		spawn_ball_swarm(&actual, BENCH_VERIFY_BALLS, 7);
+
+		for (int frame = 0; frame < BENCH_VERIFY_FRAMES; frame++)
+			update_ball_swarm(&actual, (frame % 5) + 0.5f);
+
+		size_t array_size = BENCH_VERIFY_BALLS * sizeof(float);
+
+		if (memcmp(expected.x, actual.x, array_size) != 0 || memcmp(expected.y, actual.y, array_size) != 0 ||
+			memcmp(expected.dx, actual.dx, array_size) != 0 || memcmp(expected.dy, actual.dy, array_size) != 0)
+		{
+			printf("MISMATCH: %s swarm update differs from scalar\n", simd_level_name(level));
+			is_ok = FALSE;
+		}
+	}
+
+	release_ball_swarm(&expected);
+	release_ball_swarm(&actual);
+
+	return is_ok;
+}
+
+/// <returns>Nanoseconds per frame</returns>
+static double time_swarm(struct ball_swarm* swarm)
+{
+	int frames = 0;
+
+	// warm up caches
+	update_ball_swarm(swarm, 1.0f);
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	while (seconds_since(start_counter) < BENCH_MIN_SECONDS)
+	{
+		update_ball_swarm(swarm, 1.0f);
+		frames++;
+	}
+
+	return seconds_since(start_counter) * 1e9 / frames;
+}
+
+static double time_aos(struct ball* balls, int count)
+{
+	int frames = 0;
+	update_aos(balls, count, 1.0f);
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	while (seconds_since(start_counter) < BENCH_MIN_SECONDS)
+	{
+		update_aos(balls, count, 1.0f);
+		frames++;
+	}
+
+	return seconds_since(start_counter) * 1e9 / frames;
+}
+
+int main(int argc, char* args[])
+{
+	const int ball_counts[] = { 100, 1000, 10000, 100000, 1000000 };
+	int best_level = simd_detect_level();
+
+	if (!verify_kernels())
+		return 1;
+
+	printf("Ball swarm update (best level on this CPU: %s), per frame and per ball\n", simd_level_name(best_level));
+
+	for (size_t count_index = 0; count_index < SDL_arraysize(ball_counts); count_index++)
+	{
+		int count = ball_counts[count_index];
+		struct ball_swarm swarm;
+		init_ball_swarm(&swarm, count);
+		spawn_ball_swarm(&swarm, count, 1);
+
+		// same starting balls for the baseline
+		struct ball* balls = SDL_malloc(count * sizeof(struct ball));
+
+		for (int i = 0; i < count; i++)
+		{
+			balls[i].x = swarm.x[i];
+			balls[i].y = swarm.y[i];
+			balls[i].dx = (int)swarm.dx[i];
+			balls[i].dy = (int)swarm.dy[i];
+		}
+
+		double aos_ns = time_aos(balls, count);
+		printf("  %8d  aos    %12.1f us %7.2f ns/ball\n", count, aos_ns / 1000.0, aos_ns / count);
+
+		for (int level = SIMD_LEVEL_SCALAR; level <= best_level; level++)
+		{
+			if (ball_swarm_set_simd_level(level) != level)
+				continue;
+
+			double ns = time_swarm(&swarm);
+			printf("  %8d  %-6s %12.1f us %7.2f ns/ball (%.2fx)\n", count, simd_level_name(level), ns / 1000.0, ns / count, aos_ns / ns);
+		}
+
+		SDL_free(balls);
+		release_ball_swarm(&swarm);
+	}
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/ball_swarm.h"
+#include "../src/broadphase.h"
+
+/*
+ * Microbenchmark for the ball vs paddle broadphase in src/broadphase.c.
+ *
+ * Every frame the swarm moves, then we find every ball touching a paddle
+ * either by testing every ball against every paddle (what update() did) or
+ * by refiling the balls by cell and only testing the balls in the cells
+ * around each paddle. Both have to find the same hits.
+ */
+
+#define BENCH_MIN_SECONDS 0.25
+#define BENCH_FRAMES_MIN 16
+
+struct bench_paddle
+{
+	float x;
+	float y;
+};
+
+struct bench_query
+{
+	const struct ball_swarm* swarm;
+	const struct bench_paddle* paddle;
+	Uint64 num_hits;
+};
+
+/// <summary>
+///		Same test as are_ball_paddle_touching() in main.c
+/// </summary>
+static int is_ball_touching_paddle(const struct bench_paddle* paddle, float ball_x, float ball_y)
+{
+	return ball_x + BALL_SIZE >= paddle->x && ball_x <= paddle->x + PADDLE_WIDTH &&
+		ball_y + BALL_SIZE >= paddle->y && ball_y <= paddle->y + PADDLE_HEIGHT;
+}
+
+static void count_hit(int ball_index, void* user_data)
+{
+	struct bench_query* query = user_data;
+
+	if (is_ball_touching_paddle(query->paddle, query->swarm->x[ball_index], query->swarm->y[ball_index]))
+		query->num_hits++;
+}
+
+static Uint64 collide_brute_force(const struct ball_swarm* swarm, const struct bench_paddle* paddles, int num_paddles)
+{
+	Uint64 num_hits = 0;
+
+	for (int p = 0; p < num_paddles; p++)
+		for (int i = 0; i < swarm->count; i++)
+			num_hits += is_ball_touching_paddle(&paddles[p], swarm->x[i], swarm->y[i]);
+
+	return num_hits;
+}
+
+static Uint64 collide_grid(struct broadphase_grid* grid, const struct ball_swarm* swarm, const struct bench_paddle* paddles, int num_paddles)
+{
+	struct bench_query query = { swarm, NULL, 0 };
+	update_broadphase_grid(grid, swarm->x, swarm->y, swarm->count);
+
+	for (int p = 0; p < num_paddles; p++)
+	{
+		query.paddle = &paddles[p];
+		query_broadphase_grid(grid, paddles[p].x - BALL_SIZE, paddles[p].y - BALL_SIZE, paddles[p].x + PADDLE_WIDTH, paddles[p].y + PADDLE_HEIGHT, count_hit, &query);
+	}
+
+	return query.num_hits;
+}
+
+/// <summary>
+///		Runs frames of the swarm moving then colliding, only the collision part is timed
+/// </summary>
+/// <returns>Nanoseconds of collision per frame</returns>
+static double time_collision(int use_grid, int num_balls, const struct bench_paddle* paddles, int num_paddles, int* num_frames, Uint64* num_hits)
+{
+	struct ball_swarm swarm;
+	struct broadphase_grid grid;
+	init_ball_swarm(&swarm, num_balls);
+	init_broadphase_grid(&grid, swarm.capacity);
+	spawn_ball_swarm(&swarm, num_balls, 1);
+
+	Uint64 collision_counter = 0;
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+	int frames = 0;
+	*num_hits = 0;
+
+	// the brute force run decides how many frames, the grid run does exactly the same ones
+	while (use_grid ? frames < *num_frames : (frames < BENCH_FRAMES_MIN || (double)(SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency() < BENCH_MIN_SECONDS))
+	{
+		update_ball_swarm(&swarm, 1.0f);
+
+		Uint64 frame_counter = SDL_GetPerformanceCounter();
+		*num_hits += use_grid ? collide_grid(&grid, &swarm, paddles, num_paddles) : collide_brute_force(&swarm, paddles, num_paddles);
+		collision_counter += SDL_GetPerformanceCounter() - frame_counter;
+
+		frames++;
+	}
+
+	*num_frames = frames;
+	release_broadphase_grid(&grid);
+	release_ball_swarm(&swarm);
+
+	return (double)collision_counter * 1e9 / SDL_GetPerformanceFrequency() / frames;
+}
+
+int main(int argc, char* args[])
+{
+	const int ball_counts[] = { 10, 1000, 100000 };
+	const int paddle_counts[] = { PADDLES_NUM_MAX, 16 };
+	struct bench_paddle paddles[16];
+
+	// two columns of paddles down each side, like a multi-paddle variant would have
+	for (int p = 0; p < (int)SDL_arraysize(paddles); p++)
+	{
+		paddles[p].x = (p & 1) ? (float)(WINDOW_WIDTH - PADDLE_WIDTH - PADDLES_X_OFFSET - (p / 2) * 3 * PADDLE_WIDTH) : (float)(PADDLES_X_OFFSET + (p / 2) * 3 * PADDLE_WIDTH);
+		paddles[p].y = (float)((p * 97) % (WINDOW_HEIGHT - PADDLE_HEIGHT));
+	}
+
+	printf("Ball vs paddle collision per frame, brute force vs %dpx grid broadphase\n", BROADPHASE_CELL_SIZE);
+
+	for (size_t paddle_index = 0; paddle_index < SDL_arraysize(paddle_counts); paddle_index++)
+	{
+		for (size_t ball_index = 0; ball_index < SDL_arraysize(ball_counts); ball_index++)
+		{
+			int num_balls = ball_counts[ball_index];
+			int num_paddles = paddle_counts[paddle_index];
+			int num_frames = 0;
+			Uint64 brute_force_hits;
+			Uint64 grid_hits;
+
+			double brute_force_ns = time_collision(FALSE, num_balls, paddles, num_paddles, &num_frames, &brute_force_hits);
+			double grid_ns = time_collision(TRUE, num_balls, paddles, num_paddles, &num_frames, &grid_hits);
+
+			if (brute_force_hits != grid_hits)
+			{
+				printf("MISMATCH: %d balls, %d paddles: brute force found %llu hits, grid found %llu\n",
+					num_balls, num_paddles, (unsigned long long)brute_force_hits, (unsigned long long)grid_hits);
+				return 1;
+			}
+
+			printf("  %6d balls %2d paddles  brute force %10.2f us  grid %10.2f us (%.2fx)  %.1f hits/frame\n",
+				num_balls, num_paddles, brute_force_ns / 1000.0, grid_ns / 1000.0, brute_force_ns / grid_ns, (double)grid_hits / num_frames);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "../env/pong_env.h"
+
+/*
+ * Steps/sec through the batched environment in env/pong_env.c, the way a
+ * trainer would drive it: one agent on the left paddle taking random
+ * actions against the AI, observations and rewards every step, then the
+ * same again with pixel observations rasterized every step.
+ *
+ * Every thread count plays exactly the same matches with the same
+ * actions, so they all have to end up with the same observations.
+ */
+
+#define BENCH_ENVS 4096
+#define BENCH_STEPS 500
+#define BENCH_PIXEL_SCALE 8 // 100x75
+#define BENCH_SEED 1
+
+static float observations[BENCH_ENVS * PONG_ENV_OBSERVATION_SIZE];
+static float rewards[BENCH_ENVS];
+static unsigned char dones[BENCH_ENVS];
+static int actions[BENCH_ENVS];
+
+static Uint32 hash_bytes(Uint32 hash, const void* bytes, size_t size)
+{
+	const Uint8* data = bytes;
+
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ data[i]) * 16777619u;
+
+	return hash;
+}
+
+/// <returns>Env steps per second (one match stepping once is one step)</returns>
+static double time_env(int num_threads, int pixel_scale, Uint32* hash, double* points_per_match)
+{
+	struct pong_env_config config = { BENCH_ENVS, 1, 1, 1, num_threads, pixel_scale, BENCH_SEED };
+	struct pong_env* env = pong_env_create(&config);
+
+	if (!env)
+		exit(1);
+
+	size_t pixels_size = (size_t)BENCH_ENVS * pong_env_get_pixel_width(env) * pong_env_get_pixel_height(env);
+	unsigned char* pixels = pixels_size > 0 ? malloc(pixels_size) : NULL;
+	Uint32 random_state = BENCH_SEED;
+	double total_points = 0.0;
+
+	*hash = 2166136261u;
+	pong_env_reset(env, observations);
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	for (int step = 0; step < BENCH_STEPS; step++)
+	{
+		for (int i = 0; i < BENCH_ENVS; i++)
+		{
+			random_state ^= random_state << 13;
+			random_state ^= random_state >> 17;
+			random_state ^= random_state << 5;
+			actions[i] = random_state % 3;
+		}
+
+		pong_env_step(env, actions, observations, rewards, dones);
+
+		if (pixels)
+			pong_env_render_pixels(env, pixels);
+
+		for (int i = 0; i < BENCH_ENVS; i++)
+			total_points += rewards[i] != 0.0f;
+	}
+
+	double elapsed_s = (double)(SDL_GetPerformanceCounter() - start_counter) / (double)SDL_GetPerformanceFrequency();
+
+	*hash = hash_bytes(*hash, observations, sizeof(observations));
+
+	if (pixels)
+		*hash = hash_bytes(*hash, pixels, pixels_size);
+
+	*points_per_match = total_points / BENCH_ENVS;
+
+	free(pixels);
+	pong_env_destroy(env);
+
+	return (double)BENCH_ENVS * BENCH_STEPS / elapsed_s;
+}
+
+int main(int argc, char* args[])
+{
+	int num_cpus = argc > 1 ? SDL_max(atoi(args[1]), 1) : SDL_GetCPUCount();
+
+	printf("Env: %d matches x %d steps, 1 random agent vs the AI, up to %d thread(s)\n", BENCH_ENVS, BENCH_STEPS, num_cpus);
+
+	for (int pixel_scale = 0; pixel_scale <= BENCH_PIXEL_SCALE; pixel_scale += BENCH_PIXEL_SCALE)
+	{
+		Uint32 expected_hash = 0;
+
+		printf("  %s\n", pixel_scale ? "with 100x75 pixel observations" : "vector observations");
+
+		// powers of 2 then every core
+		for (int num_threads = 1; ; num_threads = SDL_min(num_threads * 2, num_cpus))
+		{
+			Uint32 hash;
+			double points_per_match;
+			double rate = time_env(num_threads, pixel_scale, &hash, &points_per_match);
+
+			if (num_threads == 1)
+				expected_hash = hash;
+			else if (hash != expected_hash)
+			{
+				printf("MISMATCH: %d threads ended up at %08x, 1 thread at %08x\n", num_threads, hash, expected_hash);
+				return 1;
+			}
+
+			printf("    %3d thread(s) %12.0f steps/sec  (%.1f points a match)\n", num_threads, rate, points_per_match);
+
+			if (num_threads >= num_cpus)
+				break;
+		}
+	}
+
+	return 0;
+}
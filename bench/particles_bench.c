@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/types.h"
+#include "../src/simd.h"
+#include "../src/particles.h"
+
+/*
+ * Microbenchmark for the hit and goal particles in src/particles.c, the
+ * update (integrate kernel + compaction) and render cost per frame at
+ * 10k and 100k live particles, for each kernel level.
+ *
+ * Gravity would have everything off the bottom of the screen in a couple
+ * of seconds, so the update is timed in short batches from a fresh top
+ * half of the screen full of long lived particles, so the count holds
+ * steady (only the odd one drifting off the sides dies). Rendering goes into an 800x600 surface like the
+ * window's at 100% render scale.
+ */
+
+#define BENCH_MIN_SECONDS 0.25
+#define BENCH_VERIFY_PARTICLES 1001 // not a whole number of lanes on purpose
+#define BENCH_VERIFY_FRAMES 200
+#define BENCH_BATCH_FRAMES 30 // a particle falls ~70px in this many, none of them get to the bottom
+#define BENCH_LIFE_TICKS 1000000.0f
+
+static double seconds_since(Uint64 start_counter)
+{
+	return (double)(SDL_GetPerformanceCounter() - start_counter) / (double)SDL_GetPerformanceFrequency();
+}
+
+/// <summary>
+///		Scatters count long lived particles over the screen, the same seed gives the same particles
+/// </summary>
+static void fill_particles(struct particle_system* system, int count, Uint32 seed)
+{
+	Uint32 random_state = seed;
+	clear_particles(system);
+
+	for (int i = 0; i < count; i++)
+	{
+		random_state ^= random_state << 13;
+		random_state ^= random_state >> 17;
+		random_state ^= random_state << 5;
+
+		struct particle_burst burst = {
+			(float)(random_state % (WINDOW_WIDTH - PARTICLES_SIZE)),
+			(float)((random_state >> 16) % (WINDOW_HEIGHT / 2)),
+			0.0f,
+			0.0f,
+			0.5f,
+			BENCH_LIFE_TICKS,
+			0.0f,
+			1
+		};
+
+		spawn_particle_burst(system, &burst);
+	}
+}
+
+/// <summary>
+///		Runs a pool for a while on every level and checks they all end up bit for bit where scalar does
+/// </summary>
+static int verify_kernels()
+{
+	struct particle_system expected;
+	struct particle_system actual;
+	int is_ok = TRUE;
+
+	init_particle_system(&expected, BENCH_VERIFY_PARTICLES, 7);
+
+	// short lives and a big spread so plenty die and get swapped out along the way
+	struct particle_burst burst = { 400.0f, 300.0f, 0.0f, -2.0f, 8.0f, 20.0f, 100.0f, BENCH_VERIFY_PARTICLES };
+
+	particles_set_simd_level(SIMD_LEVEL_SCALAR);
+	spawn_particle_burst(&expected, &burst);
+
+	for (int frame = 0; frame < BENCH_VERIFY_FRAMES; frame++)
+		update_particles(&expected, (frame % 5) * 0.25f + 0.5f);
+
+	for (int level = SIMD_LEVEL_SSE2; level <= SIMD_LEVEL_AVX2; level++)
+	{
+		if (particles_set_simd_level(level) != level)
+			continue;
+
+		init_particle_system(&actual, BENCH_VERIFY_PARTICLES, 7);
+		spawn_particle_burst(&actual, &burst);
+
+		for (int frame = 0; frame < BENCH_VERIFY_FRAMES; frame++)
+			update_particles(&actual, (frame % 5) * 0.25f + 0.5f);
+
+		size_t array_size = expected.count * sizeof(float);
+
+		if (expected.count != actual.count || memcmp(&expected.bounds, &actual.bounds, sizeof(SDL_Rect)) != 0 ||
+			memcmp(expected.x, actual.x, array_size) != 0 || memcmp(expected.y, actual.y, array_size) != 0 ||
+			memcmp(expected.dx, actual.dx, array_size) != 0 || memcmp(expected.dy, actual.dy, array_size) != 0 ||
+			memcmp(expected.life, actual.life, array_size) != 0)
+		{
+			printf("MISMATCH: %s particle update differs from scalar\n", simd_level_name(level));
+			is_ok = FALSE;
+		}
+
+		release_particle_system(&actual);
+	}
+
+	release_particle_system(&expected);
+
+	return is_ok;
+}
+
+/// <returns>Nanoseconds per frame</returns>
+static double time_update(struct particle_system* system, int count, int* live_count)
+{
+	double elapsed_s = 0.0;
+	int frames = 0;
+
+	*live_count = count;
+
+	while (elapsed_s < BENCH_MIN_SECONDS)
+	{
+		fill_particles(system, count, 1);
+
+		// warm up caches
+		update_particles(system, 1.0f);
+
+		Uint64 start_counter = SDL_GetPerformanceCounter();
+
+		for (int frame = 0; frame < BENCH_BATCH_FRAMES; frame++)
+			update_particles(system, 1.0f);
+
+		elapsed_s += seconds_since(start_counter);
+		frames += BENCH_BATCH_FRAMES;
+		*live_count = SDL_min(*live_count, system->count);
+	}
+
+	return elapsed_s * 1e9 / frames;
+}
+
+static double time_render(struct particle_system* system, SDL_Surface* target)
+{
+	int frames = 0;
+	render_particles(system, target, 100);
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	while (seconds_since(start_counter) < BENCH_MIN_SECONDS)
+	{
+		render_particles(system, target, 100);
+		frames++;
+	}
+
+	return seconds_since(start_counter) * 1e9 / frames;
+}
+
+int main(int argc, char* args[])
+{
+	const int particle_counts[] = { 10000, 100000 };
+	int best_level = simd_detect_level();
+
+	if (!verify_kernels())
+		return 1;
+
+	SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+
+	if (!target)
+	{
+		printf("Could not create the render target. SDL Err: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	printf("Particles (best level on this CPU: %s), per frame and per particle\n", simd_level_name(best_level));
+
+	for (size_t count_index = 0; count_index < SDL_arraysize(particle_counts); count_index++)
+	{
+		int count = particle_counts[count_index];
+		struct particle_system system;
+
+		if (!init_particle_system(&system, count, 1))
+			return 1;
+
+		for (int level = SIMD_LEVEL_SCALAR; level <= best_level; level++)
+		{
+			if (particles_set_simd_level(level) != level)
+				continue;
+
+			int live_count;
+			double ns = time_update(&system, count, &live_count);
+			printf("  %8d  update %-6s %10.1f us %7.2f ns/particle (%d still live)\n", count, simd_level_name(level), ns / 1000.0, ns / count, live_count);
+		}
+
+		fill_particles(&system, count, 1);
+		double render_ns = time_render(&system, target);
+		printf("  %8d  render        %10.1f us %7.2f ns/particle\n", count, render_ns / 1000.0, render_ns / count);
+
+		release_particle_system(&system);
+	}
+
+	SDL_FreeSurface(target);
+
+	return 0;
+}
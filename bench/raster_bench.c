@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/raster.h"
+
+/*
+ * Microbenchmark for the raster kernels in src/raster.c against SDL's own
+ * SDL_FillRect/SDL_BlitSurface, at our 800x600 framebuffer and at 4K.
+ *
+ * Each case fills/blits the whole framebuffer, the blit tiles a colour keyed
+ * sprite (half key, half opaque like our bitmaps) across it.
+ */
+
+#define BENCH_SPRITE_WIDTH 64
+#define BENCH_SPRITE_HEIGHT 64
+#define BENCH_MIN_SECONDS 0.25
+
+struct framebuffer_size
+{
+	const char* name;
+	int w;
+	int h;
+};
+
+static double seconds_since(Uint64 start_counter)
+{
+	return (double)(SDL_GetPerformanceCounter() - start_counter) / (double)SDL_GetPerformanceFrequency();
+}
+
+static SDL_Surface* create_sprite(Uint32 colour_key)
+{
+	SDL_Surface* sprite = SDL_CreateRGBSurfaceWithFormat(0, BENCH_SPRITE_WIDTH, BENCH_SPRITE_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+	Uint32* pixels = (Uint32*)sprite->pixels;
+
+	// checker of key and opaque runs so neither the SIMD masks nor branch prediction get an easy ride
+	for (int y = 0; y < sprite->h; y++)
+		for (int x = 0; x < sprite->w; x++)
+			pixels[(y * sprite->pitch / 4) + x] = ((x / 3 + y) & 1) ? colour_key : 0xFF00FF00 | (Uint32)(x * 4);
+
+	SDL_SetColorKey(sprite, SDL_TRUE, colour_key);
+	return sprite;
+}
+
+static void sdl_fill(SDL_Surface* dest, SDL_Surface* sprite, Uint32 colour_key)
+{
+	SDL_FillRect(dest, NULL, 0xFF202020);
+}
+
+static void raster_fill(SDL_Surface* dest, SDL_Surface* sprite, Uint32 colour_key)
+{
+	raster_fill_rect(dest, NULL, 0xFF202020);
+}
+
+static void sdl_keyed_blit(SDL_Surface* dest, SDL_Surface* sprite, Uint32 colour_key)
+{
+	for (int y = 0; y < dest->h; y += sprite->h)
+	{
+		for (int x = 0; x < dest->w; x += sprite->w)
+		{
+			SDL_Rect dest_rect = { x, y, sprite->w, sprite->h };
+			SDL_BlitSurface(sprite, NULL, dest, &dest_rect);
+		}
+	}
+}
+
+static void raster_keyed_blit(SDL_Surface* dest, SDL_Surface* sprite, Uint32 colour_key)
+{
+	for (int y = 0; y < dest->h; y += sprite->h)
+		for (int x = 0; x < dest->w; x += sprite->w)
+			raster_blit_keyed(sprite, NULL, dest, x, y, colour_key);
+}
+
+/// <summary>
+///		Runs a kernel over the framebuffer until enough time has passed to trust the number
+/// </summary>
+/// <returns>Megapixels per second</returns>
+static double time_kernel(void (*kernel)(SDL_Surface*, SDL_Surface*, Uint32), SDL_Surface* dest, SDL_Surface* sprite, Uint32 colour_key)
+{
+	int iterations = 0;
+
+	// warm up caches and page in the framebuffer
+	kernel(dest, sprite, colour_key);
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	while (seconds_since(start_counter) < BENCH_MIN_SECONDS)
+	{
+		kernel(dest, sprite, colour_key);
+		iterations++;
+	}
+
+	return ((double)dest->w * dest->h * iterations) / seconds_since(start_counter) / 1e6;
+}
+
+/// <summary>
+///		Checks every kernel level draws exactly what SDL draws
+/// </summary>
+static int verify_kernels(SDL_Surface* sprite, Uint32 colour_key)
+{
+	SDL_Surface* expected = SDL_CreateRGBSurfaceWithFormat(0, 203, 101, 32, SDL_PIXELFORMAT_RGBA32);
+	SDL_Surface* actual = SDL_CreateRGBSurfaceWithFormat(0, 203, 101, 32, SDL_PIXELFORMAT_RGBA32);
+	int is_ok = TRUE;
+
+	SDL_FillRect(expected, NULL, 0xFF123456);
+	sdl_keyed_blit(expected, sprite, colour_key);
+
+	for (int level = RASTER_SIMD_SCALAR; level <= RASTER_SIMD_AVX2; level++)
+	{
+		if (raster_set_simd_level(level) != level)
+			continue;
+
+		raster_fill_rect(actual, NULL, 0xFF123456);
+		raster_keyed_blit(actual, sprite, colour_key);
+
+		for (int y = 0; y < actual->h; y++)
+		{
+			if (memcmp((Uint8*)expected->pixels + y * expected->pitch, (Uint8*)actual->pixels + y * actual->pitch, actual->w * sizeof(Uint32)) != 0)
+			{
+				printf("MISMATCH: %s keyed blit differs from SDL_BlitSurface on row %d\n", raster_simd_level_name(level), y);
+				is_ok = FALSE;
+				break;
+			}
+		}
+	}
+
+	SDL_FreeSurface(expected);
+	SDL_FreeSurface(actual);
+
+	return is_ok;
+}
+
+int main(int argc, char* args[])
+{
+	const struct framebuffer_size sizes[] = {
+		{ "800x600", WINDOW_WIDTH, WINDOW_HEIGHT },
+		{ "3840x2160", 3840, 2160 },
+	};
+
+	const struct {
+		const char* name;
+		void (*sdl_kernel)(SDL_Surface*, SDL_Surface*, Uint32);
+		void (*raster_kernel)(SDL_Surface*, SDL_Surface*, Uint32);
+	} cases[] = {
+		{ "fill", sdl_fill, raster_fill },
+		{ "keyed blit", sdl_keyed_blit, raster_keyed_blit },
+	};
+
+	init_raster();
+	int best_level = raster_get_simd_level();
+
+	SDL_PixelFormat* format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA32);
+	Uint32 colour_key = SDL_MapRGB(format, 255, 0, 255);
+	SDL_FreeFormat(format);
+	SDL_Surface* sprite = create_sprite(colour_key);
+
+	if (!verify_kernels(sprite, colour_key))
+		return 1;
+
+	printf("Raster kernels vs SDL (best level on this CPU: %s), Mpixels/s\n", raster_simd_level_name(best_level));
+
+	for (size_t size_index = 0; size_index < SDL_arraysize(sizes); size_index++)
+	{
+		SDL_Surface* framebuffer = SDL_CreateRGBSurfaceWithFormat(0, sizes[size_index].w, sizes[size_index].h, 32, SDL_PIXELFORMAT_RGBA32);
+
+		for (size_t case_index = 0; case_index < SDL_arraysize(cases); case_index++)
+		{
+			double sdl_mpix = time_kernel(cases[case_index].sdl_kernel, framebuffer, sprite, colour_key);
+			printf("  %-9s %-10s SDL    %9.1f\n", sizes[size_index].name, cases[case_index].name, sdl_mpix);
+
+			for (int level = RASTER_SIMD_SCALAR; level <= best_level; level++)
+			{
+				if (raster_set_simd_level(level) != level)
+					continue;
+
+				double raster_mpix = time_kernel(cases[case_index].raster_kernel, framebuffer, sprite, colour_key);
+				printf("  %-9s %-10s %-6s %9.1f (%.2fx)\n", sizes[size_index].name, cases[case_index].name, raster_simd_level_name(level), raster_mpix, raster_mpix / sdl_mpix);
+			}
+		}
+
+		SDL_FreeSurface(framebuffer);
+	}
+
+	SDL_FreeSurface(sprite);
+	return 0;
+}
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/telemetry.h"
+
+/*
+ * What a telemetry record costs the game loop (src/telemetry.c). Writes
+ * enough records to go round the default ring several times, timing
+ * them in batches, and reports the mean per record and the p50/p99/worst
+ * batch. The same records go into a plain array in memory as a floor
+ * (the worst batches there are the OS taking the CPU away, not I/O), and
+ * through fwrite with a flush per record (what the loop would be waiting
+ * on if we logged to a plain file) for comparison.
+ *
+ *   telemetry_bench [file]   (telemetry_bench.tlm in the current directory by default)
+ */
+
+#define BENCH_RECORDS (TELEMETRY_CAPACITY_DEFAULT * 32)
+#define BENCH_BATCH_RECORDS 1024
+#define BENCH_BATCHES (BENCH_RECORDS / BENCH_BATCH_RECORDS)
+#define BENCH_FWRITE_RECORDS 100000
+
+static struct telemetry_record memory_ring[TELEMETRY_CAPACITY_DEFAULT];
+static double batch_ns[BENCH_BATCHES];
+
+static double ns_since(Uint64 start_counter)
+{
+	return (double)(SDL_GetPerformanceCounter() - start_counter) * 1e9 / (double)SDL_GetPerformanceFrequency();
+}
+
+static void fill_record(struct telemetry_record* record, Uint32 tick)
+{
+	SDL_zerop(record);
+	record->tick = tick;
+	record->elapsed_ms = tick * 1000 / SIM_TICKS_PER_SECOND;
+	record->type = (Uint8)(tick % TELEMETRY_RECORD_TYPES_NUM);
+	record->hit_pos = (Sint16)(tick % PADDLE_HEIGHT);
+	record->ball_x = (float)(tick % WINDOW_WIDTH);
+	record->ball_y = (float)(tick % WINDOW_HEIGHT);
+	record->ball_dx = 3.0f;
+	record->ball_dy = -2.0f;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+	double lhs = *(const double*)a;
+	double rhs = *(const double*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+static void write_memory_ring(const struct telemetry_record* record)
+{
+	memory_ring[record->tick & (TELEMETRY_CAPACITY_DEFAULT - 1)] = *record;
+}
+
+/// <summary>
+///		Times BENCH_RECORDS records through write_func a batch at a time and prints ns per record
+/// </summary>
+static void time_writes(const char* name, void (*write_func)(const struct telemetry_record*))
+{
+	struct telemetry_record record;
+	double total_ns = 0.0;
+
+	for (int batch = 0; batch < BENCH_BATCHES; batch++)
+	{
+		Uint32 batch_begin = (Uint32)batch * BENCH_BATCH_RECORDS;
+		Uint64 start_counter = SDL_GetPerformanceCounter();
+
+		for (Uint32 tick = batch_begin; tick < batch_begin + BENCH_BATCH_RECORDS; tick++)
+		{
+			fill_record(&record, tick);
+			write_func(&record);
+		}
+
+		batch_ns[batch] = ns_since(start_counter);
+		total_ns += batch_ns[batch];
+	}
+
+	qsort(batch_ns, BENCH_BATCHES, sizeof(double), compare_doubles);
+	printf("  %-16s %6.1f ns/record mean, batches of %d p50 %6.1f p99 %6.1f worst %7.1f ns/record\n",
+		name,
+		total_ns / BENCH_RECORDS,
+		BENCH_BATCH_RECORDS,
+		batch_ns[BENCH_BATCHES / 2] / BENCH_BATCH_RECORDS,
+		batch_ns[(BENCH_BATCHES * 99) / 100] / BENCH_BATCH_RECORDS,
+		batch_ns[BENCH_BATCHES - 1] / BENCH_BATCH_RECORDS);
+}
+
+int main(int argc, char* args[])
+{
+	const char* path = argc > 1 ? args[1] : "telemetry_bench.tlm";
+	struct telemetry_record record;
+
+	Uint64 open_counter = SDL_GetPerformanceCounter();
+
+	if (!telemetry_open(path, TELEMETRY_CAPACITY_DEFAULT))
+		return 1;
+
+	double open_ms = ns_since(open_counter) / 1e6;
+
+	printf("Telemetry: %d records through a %d record ring (opening and touching the file took %.2f ms)\n", BENCH_RECORDS, TELEMETRY_CAPACITY_DEFAULT, open_ms);
+	time_writes("memory ring", write_memory_ring);
+	time_writes("mapped ring", telemetry_write);
+	telemetry_close();
+
+	// the same records through stdio, flushed each time so they'd survive a crash like the mapped ones do
+	FILE* file = fopen(path, "wb");
+
+	if (!file)
+	{
+		printf("Could not open %s.\n", path);
+		return 1;
+	}
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	for (Uint32 tick = 0; tick < BENCH_FWRITE_RECORDS; tick++)
+	{
+		fill_record(&record, tick);
+		fwrite(&record, sizeof(record), 1, file);
+		fflush(file);
+	}
+
+	double fwrite_ns = ns_since(start_counter);
+	printf("  %-16s %6.1f ns/record mean (%d records)\n", "fwrite + fflush", fwrite_ns / BENCH_FWRITE_RECORDS, BENCH_FWRITE_RECORDS);
+
+	fclose(file);
+	remove(path);
+
+	return 0;
+}
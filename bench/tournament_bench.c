@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/types.h"
+#include "../src/replay.h"
+#include "../src/match.h"
+#include "../src/scheduler.h"
+
+/*
+ * Throughput of the work stealing scheduler in src/scheduler.c stepping a
+ * tournament's worth of bot matches, for 1 thread up to one per core.
+ *
+ * Finished matches are restarted straight away so every pass has the same
+ * number of matches to step. Each thread count plays exactly the same
+ * matches, so they all have to end up in the same state.
+ */
+
+#define BENCH_MATCHES 4096
+#define BENCH_PASSES 600 // 10 simulated seconds of every match
+#define BENCH_SEED 1
+
+static void step_matches(int begin, int end, void* user_data)
+{
+	struct match* matches = user_data;
+
+	for (int i = begin; i < end; i++)
+	{
+		struct match* match = &matches[i];
+
+		if (!is_bot_match_running(match))
+			start_bot_match(match);
+
+		step_bot_match(match);
+	}
+}
+
+static Uint32 hash_matches(const struct match* matches, int num_matches)
+{
+	Uint32 hash = 2166136261u;
+
+	for (int i = 0; i < num_matches; i++)
+	{
+		struct game_snapshot snapshot;
+		capture_match_snapshot(&matches[i], &snapshot);
+		hash = (hash ^ replay_hash_snapshot(&snapshot)) * 16777619u;
+	}
+
+	return hash;
+}
+
+/// <returns>Match steps per second</returns>
+static double time_tournament(int num_threads, Uint32* hash, Uint64* num_steals)
+{
+	static struct match matches[BENCH_MATCHES];
+
+	for (int i = 0; i < BENCH_MATCHES; i++)
+	{
+		init_bot_match(&matches[i], BENCH_SEED + ((Uint32)i * HEADLESS_SEED_STRIDE), 1, get_ai_difficulty(AI_DIFFICULTY_DEFAULT));
+		start_bot_match(&matches[i]);
+	}
+
+	init_scheduler(num_threads);
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	for (int pass = 0; pass < BENCH_PASSES; pass++)
+		scheduler_parallel_for(BENCH_MATCHES, HEADLESS_MATCHES_PER_JOB, step_matches, matches);
+
+	double elapsed_s = (double)(SDL_GetPerformanceCounter() - start_counter) / (double)SDL_GetPerformanceFrequency();
+
+	*num_steals = scheduler_get_num_steals();
+	*hash = hash_matches(matches, BENCH_MATCHES);
+	release_scheduler();
+
+	return (double)BENCH_MATCHES * BENCH_PASSES / elapsed_s;
+}
+
+int main(int argc, char* args[])
+{
+	// more threads than cores can be asked for to check the results still match
+	int num_cpus = argc > 1 ? SDL_max(atoi(args[1]), 1) : SDL_GetCPUCount();
+	double single_thread_rate = 0.0;
+	Uint32 expected_hash = 0;
+
+	printf("Tournament: %d matches x %d passes, up to %d thread(s)\n", BENCH_MATCHES, BENCH_PASSES, num_cpus);
+
+	// powers of 2 then every core
+	for (int num_threads = 1; ; num_threads = SDL_min(num_threads * 2, num_cpus))
+	{
+		Uint32 hash;
+		Uint64 num_steals;
+		double rate = time_tournament(num_threads, &hash, &num_steals);
+
+		if (num_threads == 1)
+		{
+			single_thread_rate = rate;
+			expected_hash = hash;
+		}
+		else if (hash != expected_hash)
+		{
+			printf("MISMATCH: %d threads ended up at %08x, 1 thread at %08x\n", num_threads, hash, expected_hash);
+			return 1;
+		}
+
+		double speedup = rate / single_thread_rate;
+		printf("  %3d thread(s) %12.0f match steps/sec  %5.2fx (%3.0f%% of linear)  %8llu steals\n",
+			num_threads, rate, speedup, speedup * 100.0 / num_threads, (unsigned long long)num_steals);
+
+		if (num_threads >= num_cpus)
+			break;
+	}
+
+	return 0;
+}
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/types.h"
+#include "../src/match.h"
+#include "../src/raster.h"
+#include "../src/scheduler.h"
+#include "pong_env.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct pong_env
+{
+	struct pong_env_config config;
+	struct match* matches;
+
+	// Pixel observations at 1/pixel_scale size. The net never moves so it's rasterized and packed down to a byte
+	// a pixel once, like the game's static layer, then each match is that copied over with its ball and paddles on top.
+	unsigned char* net_pixels;
+	int pixel_width;
+	int pixel_height;
+
+	// What the current pong_env_step/pong_env_render_pixels was called with, for the scheduler jobs
+	const int* actions;
+	float* observations;
+	float* rewards;
+	unsigned char* dones;
+	unsigned char* pixels;
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int is_env_created = FALSE;
+
+/// <summary>
+///		The rect a rect given in court pixels covers at 1/scale size, anything it touches gets at least a pixel
+/// </summary>
+static SDL_Rect get_scaled_rect(float x, float y, float w, float h, int scale)
+{
+	int min_x = (int)x / scale;
+	int min_y = (int)y / scale;
+	int max_x = ((int)(x + w) + scale - 1) / scale;
+	int max_y = ((int)(y + h) + scale - 1) / scale;
+	SDL_Rect rect = { min_x, min_y, SDL_max(max_x - min_x, 1), SDL_max(max_y - min_y, 1) };
+
+	return rect;
+}
+
+static int create_net_pixels(struct pong_env* env)
+{
+	int scale = env->config.pixel_scale;
+	env->pixel_width = (WINDOW_WIDTH + scale - 1) / scale;
+	env->pixel_height = (WINDOW_HEIGHT + scale - 1) / scale;
+
+	int num_pixels = env->pixel_width * env->pixel_height;
+	SDL_Surface* net_surface = SDL_CreateRGBSurfaceWithFormat(0, env->pixel_width, env->pixel_height, 32, SDL_PIXELFORMAT_RGBA32);
+	env->net_pixels = SDL_malloc(num_pixels);
+
+	if (!net_surface || !env->net_pixels)
+	{
+		SDL_FreeSurface(net_surface);
+		return FALSE;
+	}
+
+	// same dashes as render_net() in the game
+	int dash_h = WINDOW_HEIGHT / (NET_NUM_DASHES * 2);
+	raster_fill_rect(net_surface, NULL, 0x00000000);
+
+	for (int i = 0; i < NET_NUM_DASHES; i++)
+	{
+		SDL_Rect dash = get_scaled_rect(WINDOW_WIDTH / 2, (float)(dash_h + (i * dash_h * 2)), NET_DASH_WIDTH, (float)dash_h, scale);
+		raster_fill_rect(net_surface, &dash, 0xFFFFFFFF);
+	}
+
+	// everything's black or white so any one channel will do, the surface has no row padding
+	const Uint32* source = net_surface->pixels;
+
+	for (int p = 0; p < num_pixels; p++)
+		env->net_pixels[p] = (unsigned char)(source[p] & 0xFF);
+
+	SDL_FreeSurface(net_surface);
+
+	return TRUE;
+}
+
+struct pong_env* pong_env_create(const struct pong_env_config* config)
+{
+	if (is_env_created)
+	{
+		printf("Only one pong_env can exist at a time.\n");
+		return NULL;
+	}
+
+	if (config->num_envs < 1 || config->num_agents < 0 || config->num_agents > PADDLES_NUM_MAX || config->pixel_scale < 0)
+	{
+		printf("A pong_env needs at least 1 env, 0 to %d agents and a pixel_scale of 0 or more.\n", PADDLES_NUM_MAX);
+		return NULL;
+	}
+
+	struct pong_env* env = SDL_calloc(1, sizeof(struct pong_env));
+
+	if (!env)
+	{
+		printf("Could not allocate the pong_env.\n");
+		return NULL;
+	}
+
+	// the net's drawn with the game's raster kernels so they need picking first
+	init_raster();
+
+	env->config = *config;
+	env->config.step_ticks = SDL_max(config->step_ticks, 1);
+	env->matches = SDL_calloc(config->num_envs, sizeof(struct match));
+
+	if (!env->matches || (config->pixel_scale > 0 && !create_net_pixels(env)))
+	{
+		printf("Could not allocate %d environments. SDL Err: %s\n", config->num_envs, SDL_GetError());
+		SDL_free(env->net_pixels);
+		SDL_free(env->matches);
+		SDL_free(env);
+		return NULL;
+	}
+
+	if (!init_scheduler(config->num_threads))
+	{
+		SDL_free(env->net_pixels);
+		SDL_free(env->matches);
+		SDL_free(env);
+		return NULL;
+	}
+
+	is_env_created = TRUE;
+
+	pong_env_reset(env, NULL);
+
+	return env;
+}
+
+void pong_env_destroy(struct pong_env* env)
+{
+	if (!env)
+		return;
+
+	for (int i = 0; i < env->config.num_envs; i++)
+		release_match(&env->matches[i]);
+
+	release_scheduler();
+	SDL_free(env->net_pixels);
+	SDL_free(env->matches);
+	SDL_free(env);
+
+	is_env_created = FALSE;
+}
+
+int pong_env_get_num_envs(const struct pong_env* env)
+{
+	return env->config.num_envs;
+}
+
+int pong_env_get_pixel_width(const struct pong_env* env)
+{
+	return env->pixel_width;
+}
+
+int pong_env_get_pixel_height(const struct pong_env* env)
+{
+	return env->pixel_height;
+}
+
+static void write_observation(const struct match* match, float* observation)
+{
+	observation[PONG_ENV_OBSERVATION_BALL_X] = match->ball.x / WINDOW_WIDTH;
+	observation[PONG_ENV_OBSERVATION_BALL_Y] = match->ball.y / WINDOW_HEIGHT;
+	observation[PONG_ENV_OBSERVATION_BALL_DX] = (float)match->ball.dx / BALL_DX_MAX;
+	observation[PONG_ENV_OBSERVATION_BALL_DY] = (float)match->ball.dy / BALL_DX_MAX;
+	observation[PONG_ENV_OBSERVATION_PADDLE_0_Y] = (match->paddles[0].y + (match->paddles[0].height / 2)) / WINDOW_HEIGHT;
+	observation[PONG_ENV_OBSERVATION_PADDLE_1_Y] = (match->paddles[1].y + (match->paddles[1].height / 2)) / WINDOW_HEIGHT;
+	observation[PONG_ENV_OBSERVATION_SCORE_0] = (float)match->round.players[0].score.points / SCORE_MAX;
+	observation[PONG_ENV_OBSERVATION_SCORE_1] = (float)match->round.players[1].score.points / SCORE_MAX;
+}
+
+void pong_env_reset(struct pong_env* env, float* observations)
+{
+	for (int i = 0; i < env->config.num_envs; i++)
+	{
+		struct match* match = &env->matches[i];
+
+		// every match has its own seed off the env's, same as the headless runner
+		init_bot_match(match, env->config.seed + ((Uint32)i * HEADLESS_SEED_STRIDE), env->config.step_ticks, get_ai_difficulty(env->config.ai_difficulty));
+		start_bot_match(match);
+
+		if (observations)
+			write_observation(match, &observations[i * PONG_ENV_OBSERVATION_SIZE]);
+	}
+}
+
+static void set_agent_button(struct game_button_state* button, int is_down)
+{
+	button->half_transition_count = button->ended_down != is_down ? 1 : 0;
+	button->ended_down = is_down;
+}
+
+/// <summary>
+///		Scheduler job, steps matches [begin, end) with the agents' actions
+/// </summary>
+static void step_envs(int begin, int end, void* user_data)
+{
+	struct pong_env* env = user_data;
+	int num_agents = env->config.num_agents;
+
+	for (int i = begin; i < end; i++)
+	{
+		struct match* match = &env->matches[i];
+		const int* actions = &env->actions[i * num_agents];
+		struct game_controller_input controllers[PADDLES_NUM_MAX];
+		int points_before[PADDLES_NUM_MAX];
+
+		for (int p = 0; p < PADDLES_NUM_MAX; p++)
+			points_before[p] = match->round.players[p].score.points;
+
+		// last step's buttons are still in the match's input, transitions are against those
+		for (int a = 0; a < num_agents; a++)
+		{
+			controllers[a] = match->bot_input.controllers[a];
+			controllers[a].is_connected = TRUE;
+			controllers[a].is_analogue = FALSE;
+			set_agent_button(&controllers[a].move_up, actions[a] == PONG_ENV_ACTION_UP);
+			set_agent_button(&controllers[a].move_down, actions[a] == PONG_ENV_ACTION_DOWN);
+		}
+
+		step_agent_match(match, controllers, num_agents);
+
+		for (int a = 0; a < num_agents; a++)
+		{
+			int points_won = match->round.players[a].score.points - points_before[a];
+			int points_lost = match->round.players[1 - a].score.points - points_before[1 - a];
+			env->rewards[(i * num_agents) + a] = (float)(points_won - points_lost);
+		}
+
+		int is_done = !is_bot_match_running(match);
+		env->dones[i] = (unsigned char)is_done;
+
+		if (is_done)
+			start_bot_match(match);
+
+		write_observation(match, &env->observations[i * PONG_ENV_OBSERVATION_SIZE]);
+	}
+}
+
+void pong_env_step(struct pong_env* env, const int* actions, float* observations, float* rewards, unsigned char* dones)
+{
+	env->actions = actions;
+	env->observations = observations;
+	env->rewards = rewards;
+	env->dones = dones;
+
+	scheduler_parallel_for(env->config.num_envs, HEADLESS_MATCHES_PER_JOB, step_envs, env);
+}
+
+/// <summary>
+///		Sets a rect of a match's pixels to white, clipped to the court since the ball goes off the sides
+/// </summary>
+static void fill_pixel_rect(const struct pong_env* env, unsigned char* pixels, SDL_Rect rect)
+{
+	SDL_Rect court = { 0, 0, env->pixel_width, env->pixel_height };
+
+	if (!SDL_IntersectRect(&rect, &court, &rect))
+		return;
+
+	for (int y = rect.y; y < rect.y + rect.h; y++)
+		SDL_memset(&pixels[(y * env->pixel_width) + rect.x], 0xFF, rect.w);
+}
+
+/// <summary>
+///		Scheduler job, draws matches [begin, end) over the net
+/// </summary>
+static void render_envs(int begin, int end, void* user_data)
+{
+	struct pong_env* env = user_data;
+	int scale = env->config.pixel_scale;
+	int num_pixels = env->pixel_width * env->pixel_height;
+
+	for (int i = begin; i < end; i++)
+	{
+		const struct match* match = &env->matches[i];
+		unsigned char* pixels = &env->pixels[(size_t)i * num_pixels];
+
+		SDL_memcpy(pixels, env->net_pixels, num_pixels);
+		fill_pixel_rect(env, pixels, get_scaled_rect(match->ball.x, match->ball.y, match->ball.width, match->ball.height, scale));
+
+		for (int p = 0; p < PADDLES_NUM_MAX; p++)
+			fill_pixel_rect(env, pixels, get_scaled_rect(match->paddles[p].x, match->paddles[p].y, match->paddles[p].width, match->paddles[p].height, scale));
+	}
+}
+
+int pong_env_render_pixels(struct pong_env* env, unsigned char* pixels)
+{
+	if (!env->net_pixels)
+		return FALSE;
+
+	env->pixels = pixels;
+	scheduler_parallel_for(env->config.num_envs, HEADLESS_MATCHES_PER_JOB, render_envs, env);
+
+	return TRUE;
+}
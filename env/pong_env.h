@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+ * #############################################
+ *  PONG ENVIRONMENT
+ *  The game as a batched environment for training paddle agents, built
+ *  into libpong_env by `make env`. One pong_env steps num_envs matches
+ *  at once across a thread pool with nothing allocated after create:
+ *  actions come in and observations, rewards and done flags go out
+ *  through contiguous buffers the caller owns. Plain C types only so it
+ *  can be loaded from anything with a C FFI (Python's ctypes and so on).
+ *
+ *  Agents play the first num_agents paddles (0 = left, 1 = right), the
+ *  built-in AI plays the rest. A match that finishes (someone reaches
+ *  10) or times out is flagged done and restarted in the same step, so
+ *  the observation written for it is already the new match's.
+ *
+ *  Only one pong_env can exist at a time, it owns the game's scheduler.
+ * #############################################
+ */
+
+#define PONG_ENV_ACTION_STAY 0
+#define PONG_ENV_ACTION_UP 1
+#define PONG_ENV_ACTION_DOWN 2
+
+// Floats per match in the observation buffer, positions are 0 to 1 across the court
+#define PONG_ENV_OBSERVATION_BALL_X 0 // top left corner
+#define PONG_ENV_OBSERVATION_BALL_Y 1
+#define PONG_ENV_OBSERVATION_BALL_DX 2 // px a tick over the ball's top speed, so -1 to 1
+#define PONG_ENV_OBSERVATION_BALL_DY 3
+#define PONG_ENV_OBSERVATION_PADDLE_0_Y 4 // middle of the paddle
+#define PONG_ENV_OBSERVATION_PADDLE_1_Y 5
+#define PONG_ENV_OBSERVATION_SCORE_0 6 // points over the points needed to win
+#define PONG_ENV_OBSERVATION_SCORE_1 7
+#define PONG_ENV_OBSERVATION_SIZE 8
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct pong_env_config
+{
+	int num_envs;
+	int num_agents; // 1 to play the AI, 2 for self play
+	int ai_difficulty; // 0 easy, 1 normal, 2 hard (AI_DIFFICULTY_*) for any paddle an agent isn't playing
+	int step_ticks; // 60Hz ticks a step covers, the ball's swept so even big steps don't tunnel
+	int num_threads; // 0 for one per core
+	int pixel_scale; // 0 for no pixel observations, otherwise the court is rasterized at 1/pixel_scale size
+	unsigned int seed; // the same seed and actions always play out the same way whatever num_threads is
+};
+
+struct pong_env;
+
+struct pong_env* pong_env_create(const struct pong_env_config* config);
+void pong_env_destroy(struct pong_env* env);
+
+int pong_env_get_num_envs(const struct pong_env* env);
+int pong_env_get_pixel_width(const struct pong_env* env);
+int pong_env_get_pixel_height(const struct pong_env* env);
+
+/// <param name="observations">num_envs * PONG_ENV_OBSERVATION_SIZE floats</param>
+void pong_env_reset(struct pong_env* env, float* observations);
+
+/// <param name="actions">num_envs * num_agents PONG_ENV_ACTION_*, match by match</param>
+/// <param name="observations">num_envs * PONG_ENV_OBSERVATION_SIZE floats</param>
+/// <param name="rewards">num_envs * num_agents floats, +1 for a point won and -1 for a point lost</param>
+/// <param name="dones">num_envs flags</param>
+void pong_env_step(struct pong_env* env, const int* actions, float* observations, float* rewards, unsigned char* dones);
+
+/// <summary>
+///		Rasterizes every match as it is now into 8 bit greyscale (net, ball and paddles in white)
+/// </summary>
+/// <param name="pixels">num_envs * pixel width * pixel height bytes, match by match with rows top to bottom</param>
+/// <returns>0 if the env was created without pixel observations</returns>
+int pong_env_render_pixels(struct pong_env* env, unsigned char* pixels);
@@ -0,0 +1,473 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/types.h"
+#include "server_protocol.h"
+
+/*
+ * Load generator for server/match_server.c (Linux only).
+ *
+ * Every simulated player is its own UDP socket on loopback, so the server
+ * sees thousands of separate clients. All of them run on one epoll loop
+ * with a 60Hz timerfd that sends each player's input (chase the ball from
+ * the last state we got). Sessions are added step by step. After each step
+ * has run for a while the server is asked for its stats, and the ramp stops
+ * at the first step where the tick p99 blows the tick budget or too many
+ * state broadcasts went missing. The server is one thread, so the last step
+ * that held is how many sessions a core can take.
+ */
+
+#define LOAD_CLIENT_EPOLL_EVENTS_MAX 1024
+#define LOAD_CLIENT_TIMER_ID UINT32_MAX // epoll user data for the tick timer, sessions use their index
+#define LOAD_CLIENT_CONTROL_ID (UINT32_MAX - 1) // and the stats socket
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct load_session
+{
+	int socket_handle;
+	int is_joined;
+	int is_rejected;
+	Uint32 session_index;
+	Uint32 session_token;
+	int seat;
+	Uint32 input_sequence;
+	struct game_controller_input controller;
+	struct game_snapshot snapshot; // latest state from the server
+	Uint64 num_states;
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static struct sockaddr_in server_address;
+static int epoll_handle = -1;
+static int timer_handle = -1;
+static int control_handle = -1;
+
+static struct load_session* sessions = NULL;
+static int num_sessions = 0;
+static Uint64 tick = 0;
+
+static int has_stats_reply = FALSE;
+static struct server_stats stats_reply;
+
+/// <summary>
+///		Thousands of sockets need more than the usual 1024 handles, go as high as we're allowed
+/// </summary>
+static void raise_handle_limit()
+{
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+		return;
+
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+}
+
+/// <summary>
+///		A non-blocking UDP socket connected to the server, on the epoll loop under id
+/// </summary>
+static int open_connected_socket(Uint32 id)
+{
+	int handle = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+
+	if (handle < 0)
+		return -1;
+
+	struct epoll_event event;
+	SDL_zero(event);
+	event.events = EPOLLIN;
+	event.data.u32 = id;
+
+	if (connect(handle, (const struct sockaddr*)&server_address, sizeof(server_address)) != 0 || epoll_ctl(epoll_handle, EPOLL_CTL_ADD, handle, &event) != 0)
+	{
+		close(handle);
+		return -1;
+	}
+
+	return handle;
+}
+
+static int open_event_loop()
+{
+	epoll_handle = epoll_create1(0);
+	timer_handle = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+
+	if (epoll_handle < 0 || timer_handle < 0)
+	{
+		printf("Could not create the epoll instance or tick timer.\n");
+		return FALSE;
+	}
+
+	struct itimerspec interval;
+	SDL_zero(interval);
+	interval.it_interval.tv_nsec = 1000000000L / SIM_TICKS_PER_SECOND;
+	interval.it_value = interval.it_interval;
+
+	struct epoll_event event;
+	SDL_zero(event);
+	event.events = EPOLLIN;
+	event.data.u32 = LOAD_CLIENT_TIMER_ID;
+
+	if (timerfd_settime(timer_handle, 0, &interval, NULL) != 0 || epoll_ctl(epoll_handle, EPOLL_CTL_ADD, timer_handle, &event) != 0)
+	{
+		printf("Could not start the tick timer.\n");
+		return FALSE;
+	}
+
+	control_handle = open_connected_socket(LOAD_CLIENT_CONTROL_ID);
+
+	if (control_handle < 0)
+	{
+		printf("Could not open the stats socket.\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void fill_header(struct server_packet_header* header, Uint32 type, const struct load_session* session)
+{
+	header->magic = SERVER_PACKET_MAGIC;
+	header->type = type;
+	header->session_index = session ? session->session_index : 0;
+	header->session_token = session ? session->session_token : 0;
+}
+
+static void send_join(struct load_session* session)
+{
+	struct server_packet_header join;
+	fill_header(&join, SERVER_PACKET_JOIN, NULL);
+	send(session->socket_handle, &join, sizeof(join), 0);
+}
+
+/// <summary>
+///		Opens sockets until there are num_target_sessions, each one asks for a seat straight away
+/// </summary>
+static int open_sessions(int num_target_sessions)
+{
+	while (num_sessions < num_target_sessions)
+	{
+		struct load_session* session = &sessions[num_sessions];
+		SDL_zerop(session);
+		session->socket_handle = open_connected_socket((Uint32)num_sessions);
+
+		if (session->socket_handle < 0)
+		{
+			printf("Could not open socket %d (out of file handles?)\n", num_sessions);
+			return FALSE;
+		}
+
+		send_join(session);
+		num_sessions++;
+	}
+
+	return TRUE;
+}
+
+static void close_sessions()
+{
+	for (int i = 0; i < num_sessions; i++)
+	{
+		struct load_session* session = &sessions[i];
+
+		if (session->is_joined)
+		{
+			struct server_packet_header leave;
+			fill_header(&leave, SERVER_PACKET_LEAVE, session);
+			send(session->socket_handle, &leave, sizeof(leave), 0);
+		}
+
+		close(session->socket_handle);
+	}
+
+	num_sessions = 0;
+}
+
+static void set_button(struct game_button_state* button, int is_down)
+{
+	button->half_transition_count = button->ended_down != is_down ? 1 : 0;
+	button->ended_down = is_down;
+}
+
+/// <summary>
+///		Same idea as the bots, move the paddle towards the ball as of the last state
+/// </summary>
+static void send_input(struct load_session* session)
+{
+	const struct paddle* paddle = &session->snapshot.paddles[session->seat];
+	const struct ball* ball = &session->snapshot.ball;
+	float paddle_centre_y = paddle->y + (paddle->height / 2);
+	float target_y = ball->y + (BALL_SIZE / 2);
+
+	struct game_controller_input* controller = &session->controller;
+	controller->is_connected = TRUE;
+	set_button(&controller->move_up, target_y < paddle_centre_y - BOT_DEAD_ZONE);
+	set_button(&controller->move_down, target_y > paddle_centre_y + BOT_DEAD_ZONE);
+
+	struct server_input_packet packet;
+	fill_header(&packet.header, SERVER_PACKET_INPUT, session);
+	packet.sequence = ++session->input_sequence;
+	packet.controller = *controller;
+	send(session->socket_handle, &packet, sizeof(packet), 0);
+}
+
+static void handle_tick_timer()
+{
+	Uint64 num_expirations;
+
+	if (read(timer_handle, &num_expirations, sizeof(num_expirations)) != sizeof(num_expirations))
+		return;
+
+	tick++;
+
+	for (int i = 0; i < num_sessions; i++)
+	{
+		struct load_session* session = &sessions[i];
+
+		if (session->is_joined)
+			send_input(session);
+		else if (!session->is_rejected && tick % SIM_TICKS_PER_SECOND == 0)
+			send_join(session); // the JOIN or the WELCOME got lost
+	}
+}
+
+static void receive_session_packets(struct load_session* session)
+{
+	Uint8 buffer[UDP_PACKET_SIZE_MAX];
+	const struct server_packet_header* header = (const struct server_packet_header*)buffer;
+	int size;
+
+	while ((size = (int)recv(session->socket_handle, buffer, sizeof(buffer), 0)) >= (int)sizeof(*header))
+	{
+		if (header->magic != SERVER_PACKET_MAGIC)
+			continue;
+
+		if (header->type == SERVER_PACKET_WELCOME && size >= (int)sizeof(struct server_welcome_packet) && !session->is_joined)
+		{
+			const struct server_welcome_packet* welcome = (const struct server_welcome_packet*)buffer;
+			session->is_joined = TRUE;
+			session->session_index = header->session_index;
+			session->session_token = header->session_token;
+			session->seat = (int)welcome->seat;
+		}
+		else if (header->type == SERVER_PACKET_STATE && size >= (int)sizeof(struct server_state_packet) && session->is_joined)
+		{
+			session->snapshot = ((const struct server_state_packet*)buffer)->snapshot;
+			session->num_states++;
+		}
+		else if (header->type == SERVER_PACKET_FULL)
+		{
+			session->is_rejected = TRUE;
+		}
+	}
+}
+
+static void receive_control_packets()
+{
+	struct server_stats_packet packet;
+
+	while (recv(control_handle, &packet, sizeof(packet), 0) == sizeof(packet))
+	{
+		if (packet.header.magic == SERVER_PACKET_MAGIC && packet.header.type == SERVER_PACKET_STATS)
+		{
+			stats_reply = packet.stats;
+			has_stats_reply = TRUE;
+		}
+	}
+}
+
+/// <summary>
+///		Runs the event loop for duration_ms, or until is_done says so
+/// </summary>
+static void run_event_loop(int duration_ms, int (*is_done)())
+{
+	static struct epoll_event events[LOAD_CLIENT_EPOLL_EVENTS_MAX];
+	Uint64 end_counter = SDL_GetPerformanceCounter() + SDL_GetPerformanceFrequency() * duration_ms / 1000;
+
+	while (SDL_GetPerformanceCounter() < end_counter && !(is_done && is_done()))
+	{
+		int num_events = epoll_wait(epoll_handle, events, LOAD_CLIENT_EPOLL_EVENTS_MAX, 10);
+
+		for (int i = 0; i < num_events; i++)
+		{
+			Uint32 id = events[i].data.u32;
+
+			if (id == LOAD_CLIENT_TIMER_ID)
+				handle_tick_timer();
+			else if (id == LOAD_CLIENT_CONTROL_ID)
+				receive_control_packets();
+			else
+				receive_session_packets(&sessions[id]);
+		}
+	}
+}
+
+static int are_all_sessions_seated()
+{
+	for (int i = 0; i < num_sessions; i++)
+	{
+		if (!sessions[i].is_joined && !sessions[i].is_rejected)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static int has_stats_arrived()
+{
+	return has_stats_reply;
+}
+
+/// <summary>
+///		Asks the server for its stats since the last ask, which also starts its next window
+/// </summary>
+static int request_server_stats(struct server_stats* stats)
+{
+	for (int attempt = 0; attempt < 3; attempt++)
+	{
+		struct server_packet_header request;
+		fill_header(&request, SERVER_PACKET_STATS_REQUEST, NULL);
+		has_stats_reply = FALSE;
+		send(control_handle, &request, sizeof(request), 0);
+
+		run_event_loop(1000, has_stats_arrived);
+
+		if (has_stats_reply)
+		{
+			*stats = stats_reply;
+			return TRUE;
+		}
+	}
+
+	printf("The server didn't answer a stats request, is it running?\n");
+	return FALSE;
+}
+
+int main(int argc, char* args[])
+{
+	int port = SERVER_PORT_DEFAULT;
+	int num_sessions_max = SERVER_SESSIONS_MAX;
+	int num_sessions_step = LOAD_CLIENT_STEP_DEFAULT;
+	int hold_ms = LOAD_CLIENT_HOLD_MS_DEFAULT;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(args[i], "--port") == 0 && i + 1 < argc)
+			port = atoi(args[++i]);
+		else if (strcmp(args[i], "--sessions") == 0 && i + 1 < argc)
+			num_sessions_max = atoi(args[++i]);
+		else if (strcmp(args[i], "--step") == 0 && i + 1 < argc)
+			num_sessions_step = atoi(args[++i]);
+		else if (strcmp(args[i], "--hold") == 0 && i + 1 < argc)
+			hold_ms = atoi(args[++i]);
+	}
+
+	num_sessions_max = SDL_max(num_sessions_max, 1);
+	num_sessions_step = SDL_max(num_sessions_step, 1);
+	hold_ms = SDL_max(hold_ms, 100);
+
+	raise_handle_limit();
+
+	SDL_zero(server_address);
+	server_address.sin_family = AF_INET;
+	server_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	server_address.sin_port = htons((Uint16)port);
+
+	sessions = SDL_calloc(num_sessions_max, sizeof(struct load_session));
+
+	if (!sessions || !open_event_loop())
+	{
+		SDL_free(sessions);
+		return 1;
+	}
+
+	printf("Load test against 127.0.0.1:%d, up to %d sessions in steps of %d, %d ms a step\n", port, num_sessions_max, num_sessions_step, hold_ms);
+	printf("  sessions  tick p50    p99     max  missed  busy  states\n");
+
+	int num_sessions_held = 0;
+	struct server_stats stats;
+
+	for (int num_target = SDL_min(num_sessions_step, num_sessions_max); ; num_target = SDL_min(num_target + num_sessions_step, num_sessions_max))
+	{
+		if (!open_sessions(num_target))
+			break;
+
+		run_event_loop(LOAD_CLIENT_JOIN_WAIT_MS, are_all_sessions_seated);
+
+		// throw away the window that covers the joins
+		if (!request_server_stats(&stats))
+			break;
+
+		int num_joined = 0;
+		int num_rejected = 0;
+
+		for (int i = 0; i < num_sessions; i++)
+		{
+			sessions[i].num_states = 0;
+			num_joined += sessions[i].is_joined;
+			num_rejected += sessions[i].is_rejected;
+		}
+
+		run_event_loop(hold_ms, NULL);
+
+		if (!request_server_stats(&stats))
+			break;
+
+		Uint64 num_states = 0;
+
+		for (int i = 0; i < num_sessions; i++)
+			num_states += sessions[i].num_states;
+
+		// every seated player should have had a state every tick the server ran
+		Uint64 num_expected_states = (Uint64)num_joined * stats.num_ticks;
+		double delivered_percent = num_expected_states ? 100.0 * (double)num_states / (double)num_expected_states : 0.0;
+
+		printf("  %8d  %5.2f ms %5.2f ms %5.2f ms  %6u  %3u%%  %5.1f%%\n",
+			num_joined, stats.tick_p50_us / 1000.0, stats.tick_p99_us / 1000.0, stats.tick_max_us / 1000.0,
+			stats.num_missed_ticks, stats.busy_percent, delivered_percent);
+		fflush(stdout);
+
+		int has_held = num_rejected == 0 && num_joined == num_sessions
+			&& stats.tick_p99_us <= SERVER_TICK_BUDGET_US
+			&& delivered_percent >= LOAD_CLIENT_DELIVERY_MIN_PERCENT;
+
+		if (!has_held)
+			break;
+
+		num_sessions_held = num_joined;
+
+		if (num_target >= num_sessions_max)
+			break;
+	}
+
+	printf("Max sessions per core: %d (server is single threaded, tick p99 within %.1f ms and %d%% of states delivered)\n",
+		num_sessions_held, SERVER_TICK_BUDGET_US / 1000.0, LOAD_CLIENT_DELIVERY_MIN_PERCENT);
+
+	close_sessions();
+	close(control_handle);
+	close(timer_handle);
+	close(epoll_handle);
+	SDL_free(sessions);
+
+	return 0;
+}
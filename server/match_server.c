@@ -0,0 +1,870 @@
+#define _GNU_SOURCE // recvmmsg/sendmmsg
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/types.h"
+#include "../src/match.h"
+#include "server_protocol.h"
+
+/*
+ * Headless authoritative match server (Linux only, it's built on epoll).
+ *
+ * One thread, one UDP socket and one timerfd on a single epoll loop. Input
+ * packets are drained in batches with recvmmsg as they arrive and merged
+ * into each session's controller. When the timer fires every match with a
+ * player in it is stepped with update_match() and its state is sent to both
+ * seats in batches with sendmmsg. No SDL subsystems are started, the
+ * simulation only needs the SDL headers and the performance counter.
+ *
+ * Players are paired up into matches in the order they join. A full match
+ * starts itself, goes back to the title when it ends and starts again.
+ */
+
+#define SERVER_EPOLL_EVENTS_MAX 2 // the socket and the tick timer
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct server_session
+{
+	int is_active;
+	Uint32 token;
+	struct sockaddr_in address;
+	int match_index;
+	int seat;
+	Uint32 last_input_sequence;
+	Uint64 last_heard_tick;
+	struct game_controller_input controller; // every input packet since the last tick merged together
+};
+
+struct server_match
+{
+	struct match match;
+	struct game_input input;
+	int session_indices[PADDLES_NUM_MAX]; // -1 for an empty seat
+	int num_players;
+	int active_slot; // index into active_matches, -1 if nobody is in it
+	int waiting_slot; // index into waiting_matches, -1 if it isn't waiting on a second player
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int socket_handle = -1;
+static int timer_handle = -1;
+static int epoll_handle = -1;
+static volatile sig_atomic_t should_quit = FALSE;
+
+static struct server_session sessions[SERVER_SESSIONS_MAX];
+static int free_sessions[SERVER_SESSIONS_MAX]; // stack of unused session indices
+static int num_free_sessions = 0;
+
+static struct server_match matches[SERVER_MATCHES_MAX];
+static int free_matches[SERVER_MATCHES_MAX]; // stack of empty matches
+static int num_free_matches = 0;
+static int active_matches[SERVER_MATCHES_MAX]; // dense so a tick only touches matches someone is playing
+static int num_active_matches = 0;
+static int waiting_matches[SERVER_MATCHES_MAX]; // matches with one player, new players fill these first
+static int num_waiting_matches = 0;
+
+static Uint64 tick = 0;
+static Uint32 token_random_state = 1;
+
+// Stats window, reset every report
+static Uint32 tick_samples_us[SERVER_TICK_SAMPLES_MAX];
+static int num_tick_samples = 0;
+static Uint32 num_window_ticks = 0;
+static Uint32 num_missed_ticks = 0;
+static Uint64 window_start_counter = 0;
+static Uint64 window_busy_counts = 0;
+static Uint64 busy_start_counter = 0; // when the loop last woke up
+static Uint64 num_packets_received = 0;
+static Uint64 num_packets_sent = 0;
+static Uint64 num_packets_dropped = 0;
+
+// Batched socket IO
+static Uint8 receive_buffers[SERVER_IO_BATCH][UDP_PACKET_SIZE_MAX];
+static struct sockaddr_in receive_addresses[SERVER_IO_BATCH];
+static struct iovec receive_vectors[SERVER_IO_BATCH];
+static struct mmsghdr receive_messages[SERVER_IO_BATCH];
+
+static struct server_state_packet send_packets[SERVER_IO_BATCH];
+static struct iovec send_vectors[SERVER_IO_BATCH];
+static struct mmsghdr send_messages[SERVER_IO_BATCH];
+static int num_queued_packets = 0;
+
+static void handle_quit_signal(int signal_number)
+{
+	should_quit = TRUE;
+}
+
+static Uint32 next_token()
+{
+	token_random_state ^= token_random_state << 13;
+	token_random_state ^= token_random_state >> 17;
+	token_random_state ^= token_random_state << 5;
+	return token_random_state;
+}
+
+static double counts_to_us(Uint64 counts)
+{
+	return (double)counts * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+/// <summary>
+///		Every session and match starts out on the free stacks, lowest index on top
+/// </summary>
+static void init_server_state()
+{
+	for (int i = 0; i < SERVER_SESSIONS_MAX; i++)
+		free_sessions[i] = SERVER_SESSIONS_MAX - 1 - i;
+
+	num_free_sessions = SERVER_SESSIONS_MAX;
+
+	for (int i = 0; i < SERVER_MATCHES_MAX; i++)
+	{
+		struct server_match* server_match = &matches[i];
+		init_match(&server_match->match);
+
+		for (int seat = 0; seat < PADDLES_NUM_MAX; seat++)
+			server_match->session_indices[seat] = -1;
+
+		server_match->num_players = 0;
+		server_match->active_slot = -1;
+		server_match->waiting_slot = -1;
+		free_matches[i] = SERVER_MATCHES_MAX - 1 - i;
+	}
+
+	num_free_matches = SERVER_MATCHES_MAX;
+
+	for (int i = 0; i < SERVER_IO_BATCH; i++)
+	{
+		receive_vectors[i].iov_base = receive_buffers[i];
+		receive_vectors[i].iov_len = UDP_PACKET_SIZE_MAX;
+		receive_messages[i].msg_hdr.msg_iov = &receive_vectors[i];
+		receive_messages[i].msg_hdr.msg_iovlen = 1;
+
+		send_vectors[i].iov_base = &send_packets[i];
+		send_vectors[i].iov_len = sizeof(send_packets[i]);
+		send_messages[i].msg_hdr.msg_iov = &send_vectors[i];
+		send_messages[i].msg_hdr.msg_iovlen = 1;
+		send_messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+	}
+
+	token_random_state = (Uint32)SDL_GetPerformanceCounter() | 1;
+	window_start_counter = busy_start_counter = SDL_GetPerformanceCounter();
+}
+
+/// <summary>
+///		Non-blocking UDP socket on every interface, with big buffers so a tick's worth of packets fits
+/// </summary>
+static int open_server_socket(Uint16 port)
+{
+	socket_handle = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+
+	if (socket_handle < 0)
+	{
+		printf("Could not create the server socket.\n");
+		return FALSE;
+	}
+
+	int buffer_bytes = SERVER_SOCKET_BUFFER_BYTES;
+	setsockopt(socket_handle, SOL_SOCKET, SO_RCVBUF, &buffer_bytes, sizeof(buffer_bytes));
+	setsockopt(socket_handle, SOL_SOCKET, SO_SNDBUF, &buffer_bytes, sizeof(buffer_bytes));
+
+	struct sockaddr_in address;
+	SDL_zero(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+
+	if (bind(socket_handle, (const struct sockaddr*)&address, sizeof(address)) != 0)
+	{
+		printf("Could not bind UDP port %d (is another server using it?)\n", port);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/// <summary>
+///		The fixed tick, a timerfd so it wakes the same epoll_wait as the socket
+/// </summary>
+static int open_tick_timer()
+{
+	timer_handle = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+
+	if (timer_handle < 0)
+	{
+		printf("Could not create the tick timer.\n");
+		return FALSE;
+	}
+
+	struct itimerspec interval;
+	SDL_zero(interval);
+	interval.it_interval.tv_nsec = 1000000000L / SIM_TICKS_PER_SECOND;
+	interval.it_value = interval.it_interval;
+
+	if (timerfd_settime(timer_handle, 0, &interval, NULL) != 0)
+	{
+		printf("Could not start the tick timer.\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static int open_event_loop()
+{
+	epoll_handle = epoll_create1(0);
+
+	if (epoll_handle < 0)
+	{
+		printf("Could not create the epoll instance.\n");
+		return FALSE;
+	}
+
+	int handles[] = { socket_handle, timer_handle };
+
+	for (int i = 0; i < SDL_arraysize(handles); i++)
+	{
+		struct epoll_event event;
+		SDL_zero(event);
+		event.events = EPOLLIN;
+		event.data.fd = handles[i];
+
+		if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, handles[i], &event) != 0)
+		{
+			printf("Could not add a handle to the epoll instance.\n");
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static void close_server()
+{
+	if (epoll_handle >= 0)
+		close(epoll_handle);
+
+	if (timer_handle >= 0)
+		close(timer_handle);
+
+	if (socket_handle >= 0)
+		close(socket_handle);
+
+	epoll_handle = timer_handle = socket_handle = -1;
+}
+
+static void send_packet_now(const void* data, int size, const struct sockaddr_in* address)
+{
+	if (sendto(socket_handle, data, size, 0, (const struct sockaddr*)address, sizeof(*address)) == size)
+		num_packets_sent++;
+	else
+		num_packets_dropped++;
+}
+
+/// <summary>
+///		Sends every queued state packet, whatever the socket won't take right now is dropped (the next tick replaces it)
+/// </summary>
+static void flush_queued_packets()
+{
+	int num_flushed = 0;
+
+	while (num_flushed < num_queued_packets)
+	{
+		int num_sent = sendmmsg(socket_handle, &send_messages[num_flushed], num_queued_packets - num_flushed, 0);
+
+		if (num_sent <= 0)
+		{
+			if (num_sent < 0 && errno == EINTR)
+				continue;
+
+			break;
+		}
+
+		num_flushed += num_sent;
+	}
+
+	num_packets_sent += num_flushed;
+	num_packets_dropped += num_queued_packets - num_flushed;
+	num_queued_packets = 0;
+}
+
+/// <summary>
+///		Hands back the next send slot, flushing the batch first if it's full
+/// </summary>
+static struct server_state_packet* queue_state_packet(struct sockaddr_in* address)
+{
+	if (num_queued_packets == SERVER_IO_BATCH)
+		flush_queued_packets();
+
+	send_messages[num_queued_packets].msg_hdr.msg_name = address;
+	return &send_packets[num_queued_packets++];
+}
+
+static void fill_header(struct server_packet_header* header, Uint32 type, int session_index)
+{
+	header->magic = SERVER_PACKET_MAGIC;
+	header->type = type;
+	header->session_index = session_index >= 0 ? (Uint32)session_index : 0;
+	header->session_token = session_index >= 0 ? sessions[session_index].token : 0;
+}
+
+static int is_same_address(const struct sockaddr_in* a, const struct sockaddr_in* b)
+{
+	return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+// ####################################
+//  SEATS
+// ####################################
+
+static void add_active_match(int match_index)
+{
+	matches[match_index].active_slot = num_active_matches;
+	active_matches[num_active_matches++] = match_index;
+}
+
+static void remove_active_match(int match_index)
+{
+	struct server_match* server_match = &matches[match_index];
+	int slot = server_match->active_slot;
+
+	// swap the last one into the hole
+	int moved_match_index = active_matches[--num_active_matches];
+	active_matches[slot] = moved_match_index;
+	matches[moved_match_index].active_slot = slot;
+	server_match->active_slot = -1;
+}
+
+static void add_waiting_match(int match_index)
+{
+	matches[match_index].waiting_slot = num_waiting_matches;
+	waiting_matches[num_waiting_matches++] = match_index;
+}
+
+static void remove_waiting_match(int match_index)
+{
+	struct server_match* server_match = &matches[match_index];
+	int slot = server_match->waiting_slot;
+
+	// swap the last one into the hole
+	int moved_match_index = waiting_matches[--num_waiting_matches];
+	waiting_matches[slot] = moved_match_index;
+	matches[moved_match_index].waiting_slot = slot;
+	server_match->waiting_slot = -1;
+}
+
+/// <summary>
+///		Sits the session down in a match someone is already waiting in, or an empty one if nobody is
+/// </summary>
+static void take_seat(int session_index)
+{
+	struct server_session* session = &sessions[session_index];
+	int match_index = num_waiting_matches > 0 ? waiting_matches[num_waiting_matches - 1] : free_matches[--num_free_matches];
+	struct server_match* server_match = &matches[match_index];
+
+	if (server_match->num_players == 0)
+		add_active_match(match_index);
+
+	int seat = 0;
+
+	while (server_match->session_indices[seat] != -1)
+		seat++;
+
+	server_match->session_indices[seat] = session_index;
+	server_match->num_players++;
+	session->match_index = match_index;
+	session->seat = seat;
+
+	if (server_match->num_players == PADDLES_NUM_MAX)
+		remove_waiting_match(match_index);
+	else if (server_match->waiting_slot == -1)
+		add_waiting_match(match_index);
+}
+
+/// <summary>
+///		Frees the session's seat, whoever is left goes back to the title and waits for a new opponent
+/// </summary>
+static void leave_seat(int session_index)
+{
+	struct server_session* session = &sessions[session_index];
+	struct server_match* server_match = &matches[session->match_index];
+
+	server_match->session_indices[session->seat] = -1;
+	server_match->num_players--;
+	init_match(&server_match->match);
+
+	if (server_match->num_players == 0)
+	{
+		if (server_match->waiting_slot != -1)
+			remove_waiting_match(session->match_index);
+
+		remove_active_match(session->match_index);
+		free_matches[num_free_matches++] = session->match_index;
+	}
+	else if (server_match->waiting_slot == -1)
+	{
+		add_waiting_match(session->match_index);
+	}
+}
+
+// ####################################
+//  SESSIONS
+// ####################################
+
+/// <returns>The session already playing from this address and port, -1 if there isn't one</returns>
+static int find_address_session(const struct sockaddr_in* address)
+{
+	// every active session has a seat, so only the matches someone is in need looking at
+	for (int i = 0; i < num_active_matches; i++)
+	{
+		const struct server_match* server_match = &matches[active_matches[i]];
+
+		for (int seat = 0; seat < PADDLES_NUM_MAX; seat++)
+		{
+			int session_index = server_match->session_indices[seat];
+
+			if (session_index != -1 && is_same_address(&sessions[session_index].address, address))
+				return session_index;
+		}
+	}
+
+	return -1;
+}
+
+static void join_session(const struct sockaddr_in* address)
+{
+	// a JOIN we've already seated means the WELCOME got lost, send it again rather than take up a second seat
+	int session_index = find_address_session(address);
+
+	if (session_index == -1)
+	{
+		if (num_free_sessions == 0)
+		{
+			struct server_packet_header full;
+			fill_header(&full, SERVER_PACKET_FULL, -1);
+			send_packet_now(&full, sizeof(full), address);
+			return;
+		}
+
+		session_index = free_sessions[--num_free_sessions];
+		struct server_session* new_session = &sessions[session_index];
+
+		SDL_zerop(new_session);
+		new_session->is_active = TRUE;
+		new_session->token = next_token();
+		new_session->address = *address;
+		take_seat(session_index);
+	}
+
+	struct server_session* session = &sessions[session_index];
+	session->last_heard_tick = tick;
+
+	struct server_welcome_packet welcome;
+	fill_header(&welcome.header, SERVER_PACKET_WELCOME, session_index);
+	welcome.match_index = session->match_index;
+	welcome.seat = session->seat;
+	send_packet_now(&welcome, sizeof(welcome), address);
+}
+
+static void leave_session(int session_index)
+{
+	leave_seat(session_index);
+	sessions[session_index].is_active = FALSE;
+	free_sessions[num_free_sessions++] = session_index;
+}
+
+/// <returns>The session the packet belongs to, -1 if it doesn't check out</returns>
+static int find_packet_session(const struct server_packet_header* header, const struct sockaddr_in* address)
+{
+	if (header->session_index >= SERVER_SESSIONS_MAX)
+		return -1;
+
+	const struct server_session* session = &sessions[header->session_index];
+
+	if (!session->is_active || session->token != header->session_token || !is_same_address(&session->address, address))
+		return -1;
+
+	return (int)header->session_index;
+}
+
+/// <summary>
+///		Folds an input packet into what the session's next tick sees, transitions add up and the latest held state wins
+/// </summary>
+static void merge_input(struct server_session* session, const struct server_input_packet* packet)
+{
+	// a late or duplicated packet, the newer one already went in
+	if (session->last_input_sequence != 0 && (Sint32)(packet->sequence - session->last_input_sequence) <= 0)
+		return;
+
+	struct game_controller_input* controller = &session->controller;
+	const struct game_controller_input* new_controller = &packet->controller;
+
+	controller->is_connected = TRUE;
+	controller->is_analogue = new_controller->is_analogue != 0;
+	controller->stick_average_x = new_controller->stick_average_x;
+	controller->stick_average_y = new_controller->stick_average_y;
+
+	for (int i = 0; i < SDL_arraysize(controller->buttons); i++)
+	{
+		// it comes off the network, so nothing gets more presses in than a real player could
+		int transitions = SDL_max(0, SDL_min(new_controller->buttons[i].half_transition_count, SERVER_BUTTON_TRANSITIONS_MAX));
+		controller->buttons[i].half_transition_count = SDL_min(controller->buttons[i].half_transition_count + transitions, SERVER_BUTTON_TRANSITIONS_MAX);
+		controller->buttons[i].ended_down = new_controller->buttons[i].ended_down != 0;
+	}
+
+	session->last_input_sequence = packet->sequence;
+}
+
+static void send_stats(const struct sockaddr_in* address);
+
+static void handle_packet(const Uint8* data, int size, const struct sockaddr_in* address)
+{
+	const struct server_packet_header* header = (const struct server_packet_header*)data;
+
+	if (size < (int)sizeof(*header) || header->magic != SERVER_PACKET_MAGIC)
+		return;
+
+	if (header->type == SERVER_PACKET_JOIN)
+	{
+		join_session(address);
+		return;
+	}
+
+	if (header->type == SERVER_PACKET_STATS_REQUEST)
+	{
+		send_stats(address);
+		return;
+	}
+
+	int session_index = find_packet_session(header, address);
+
+	if (session_index < 0)
+		return;
+
+	sessions[session_index].last_heard_tick = tick;
+
+	if (header->type == SERVER_PACKET_INPUT && size >= (int)sizeof(struct server_input_packet))
+		merge_input(&sessions[session_index], (const struct server_input_packet*)data);
+	else if (header->type == SERVER_PACKET_LEAVE)
+		leave_session(session_index);
+}
+
+/// <summary>
+///		Takes everything waiting on the socket, SERVER_IO_BATCH packets a syscall
+/// </summary>
+static void receive_packets()
+{
+	for (;;)
+	{
+		for (int i = 0; i < SERVER_IO_BATCH; i++)
+		{
+			receive_messages[i].msg_hdr.msg_name = &receive_addresses[i];
+			receive_messages[i].msg_hdr.msg_namelen = sizeof(receive_addresses[i]);
+		}
+
+		int num_received = recvmmsg(socket_handle, receive_messages, SERVER_IO_BATCH, 0, NULL);
+
+		if (num_received <= 0)
+			return;
+
+		num_packets_received += num_received;
+
+		for (int i = 0; i < num_received; i++)
+			handle_packet(receive_buffers[i], (int)receive_messages[i].msg_len, &receive_addresses[i]);
+
+		if (num_received < SERVER_IO_BATCH)
+			return;
+	}
+}
+
+// ####################################
+//  TICK
+// ####################################
+
+static void press_button(struct game_button_state* button)
+{
+	button->half_transition_count = 1;
+	button->ended_down = TRUE;
+}
+
+/// <summary>
+///		Builds the match's input from its seats, and starts a full match or sends a finished one back to the title
+/// </summary>
+static void gather_match_input(struct server_match* server_match)
+{
+	struct game_input* input = &server_match->input;
+	SDL_zero(input->start);
+	SDL_zero(input->reset);
+	input->dt_for_frame = (float)SIM_DT_S;
+
+	for (int seat = 0; seat < PADDLES_NUM_MAX; seat++)
+	{
+		int session_index = server_match->session_indices[seat];
+
+		if (session_index == -1)
+		{
+			SDL_zero(input->controllers[seat]);
+			continue;
+		}
+
+		struct game_controller_input* controller = &sessions[session_index].controller;
+		input->controllers[seat] = *controller;
+
+		// transitions are used up, what's held stays held until the client says otherwise
+		for (int i = 0; i < SDL_arraysize(controller->buttons); i++)
+			controller->buttons[i].half_transition_count = 0;
+	}
+
+	if (server_match->num_players == PADDLES_NUM_MAX && server_match->match.screen.index == GAME_SCREEN_TITLE_INDEX)
+		press_button(&input->start);
+	else if (server_match->match.screen.index == GAME_SCREEN_GAME_OVER_INDEX)
+		press_button(&input->reset);
+}
+
+static void broadcast_match_state(int match_index)
+{
+	const struct server_match* server_match = &matches[match_index];
+
+	for (int seat = 0; seat < PADDLES_NUM_MAX; seat++)
+	{
+		int session_index = server_match->session_indices[seat];
+
+		if (session_index == -1)
+			continue;
+
+		struct server_session* session = &sessions[session_index];
+		struct server_state_packet* packet = queue_state_packet(&session->address);
+		fill_header(&packet->header, SERVER_PACKET_STATE, session_index);
+		packet->tick = (Uint32)tick;
+		packet->last_input_sequence = session->last_input_sequence;
+		capture_match_snapshot(&server_match->match, &packet->snapshot);
+	}
+}
+
+/// <summary>
+///		Drops sessions that have gone quiet, once a second is plenty
+/// </summary>
+static void expire_sessions()
+{
+	Uint64 timeout_ticks = (Uint64)SERVER_SESSION_TIMEOUT_MS * SIM_TICKS_PER_SECOND / 1000;
+
+	// backwards, a match whose last player times out gets swapped out of the list
+	for (int i = num_active_matches - 1; i >= 0; i--)
+	{
+		const struct server_match* server_match = &matches[active_matches[i]];
+
+		for (int seat = 0; seat < PADDLES_NUM_MAX; seat++)
+		{
+			int session_index = server_match->session_indices[seat];
+
+			if (session_index != -1 && tick - sessions[session_index].last_heard_tick > timeout_ticks)
+				leave_session(session_index);
+		}
+	}
+}
+
+/// <summary>
+///		Steps every match with a player in it and sends each player the result
+/// </summary>
+static void run_tick()
+{
+	tick++;
+
+	for (int i = 0; i < num_active_matches; i++)
+	{
+		struct server_match* server_match = &matches[active_matches[i]];
+
+		gather_match_input(server_match);
+		save_match_previous_state(&server_match->match);
+		update_match(&server_match->match, &server_match->input);
+		broadcast_match_state(active_matches[i]);
+	}
+
+	flush_queued_packets();
+
+	if (tick % SIM_TICKS_PER_SECOND == 0)
+		expire_sessions();
+}
+
+// ####################################
+//  STATS
+// ####################################
+
+static int compare_uint32s(const void* a, const void* b)
+{
+	Uint32 lhs = *(const Uint32*)a;
+	Uint32 rhs = *(const Uint32*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+/// <summary>
+///		Fills in the stats since the last report and starts a new window
+/// </summary>
+static void take_stats(struct server_stats* stats)
+{
+	Uint64 now_counter = SDL_GetPerformanceCounter();
+
+	// the wake up this report is happening in counts towards the window it closes
+	window_busy_counts += now_counter - busy_start_counter;
+	busy_start_counter = now_counter;
+
+	SDL_zerop(stats);
+	stats->num_sessions = SERVER_SESSIONS_MAX - num_free_sessions;
+	stats->num_matches = num_active_matches;
+	stats->num_ticks = num_window_ticks;
+	stats->num_missed_ticks = num_missed_ticks;
+	stats->num_packets_received = num_packets_received;
+	stats->num_packets_sent = num_packets_sent;
+	stats->num_packets_dropped = num_packets_dropped;
+
+	if (now_counter > window_start_counter)
+		stats->busy_percent = (Uint32)(window_busy_counts * 100 / (now_counter - window_start_counter));
+
+	if (num_tick_samples > 0)
+	{
+		qsort(tick_samples_us, num_tick_samples, sizeof(Uint32), compare_uint32s);
+		stats->tick_p50_us = tick_samples_us[(num_tick_samples * 50) / 100];
+		stats->tick_p99_us = tick_samples_us[(num_tick_samples * 99) / 100];
+		stats->tick_max_us = tick_samples_us[num_tick_samples - 1];
+	}
+
+	num_tick_samples = 0;
+	num_window_ticks = num_missed_ticks = 0;
+	num_packets_received = num_packets_sent = num_packets_dropped = 0;
+	window_busy_counts = 0;
+	window_start_counter = now_counter;
+}
+
+static void print_stats(const struct server_stats* stats)
+{
+	printf("%5u sessions %5u matches | tick p50 %5u us p99 %5u us max %5u us | %u ticks %u missed | busy %3u%% | packets in %llu out %llu dropped %llu\n",
+		stats->num_sessions, stats->num_matches,
+		stats->tick_p50_us, stats->tick_p99_us, stats->tick_max_us,
+		stats->num_ticks, stats->num_missed_ticks, stats->busy_percent,
+		(unsigned long long)stats->num_packets_received, (unsigned long long)stats->num_packets_sent, (unsigned long long)stats->num_packets_dropped);
+	fflush(stdout);
+}
+
+static void send_stats(const struct sockaddr_in* address)
+{
+	struct server_stats_packet packet;
+	fill_header(&packet.header, SERVER_PACKET_STATS, -1);
+	take_stats(&packet.stats);
+	print_stats(&packet.stats);
+	send_packet_now(&packet, sizeof(packet), address);
+}
+
+/// <summary>
+///		Runs a tick for the timer going off, a backed up timer is counted as missed ticks rather than caught up on
+/// </summary>
+static void handle_tick_timer()
+{
+	Uint64 num_expirations = 0;
+
+	if (read(timer_handle, &num_expirations, sizeof(num_expirations)) != sizeof(num_expirations) || num_expirations == 0)
+		return;
+
+	num_missed_ticks += (Uint32)(num_expirations - 1);
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+	run_tick();
+	Uint32 tick_us = (Uint32)counts_to_us(SDL_GetPerformanceCounter() - start_counter);
+
+	num_window_ticks++;
+
+	if (num_tick_samples < SERVER_TICK_SAMPLES_MAX)
+		tick_samples_us[num_tick_samples++] = tick_us;
+}
+
+int main(int argc, char* args[])
+{
+	int port = SERVER_PORT_DEFAULT;
+	int duration_s = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(args[i], "--port") == 0 && i + 1 < argc)
+			port = atoi(args[++i]);
+		else if (strcmp(args[i], "--duration") == 0 && i + 1 < argc)
+			duration_s = atoi(args[++i]);
+	}
+
+	signal(SIGINT, handle_quit_signal);
+	signal(SIGTERM, handle_quit_signal);
+
+	init_server_state();
+
+	if (!open_server_socket((Uint16)port) || !open_tick_timer() || !open_event_loop())
+	{
+		close_server();
+		return 1;
+	}
+
+	printf("Match server on UDP port %d, %d Hz, up to %d sessions\n", port, SIM_TICKS_PER_SECOND, SERVER_SESSIONS_MAX);
+	fflush(stdout);
+
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+	Uint64 report_interval_counts = frequency * SERVER_REPORT_INTERVAL_MS / 1000;
+
+	while (!should_quit)
+	{
+		struct epoll_event events[SERVER_EPOLL_EVENTS_MAX];
+		int num_events = epoll_wait(epoll_handle, events, SERVER_EPOLL_EVENTS_MAX, -1);
+		busy_start_counter = SDL_GetPerformanceCounter();
+
+		if (num_events < 0 && errno != EINTR)
+		{
+			printf("epoll_wait failed.\n");
+			break;
+		}
+
+		for (int i = 0; i < num_events; i++)
+		{
+			if (events[i].data.fd == socket_handle)
+				receive_packets();
+			else if (events[i].data.fd == timer_handle)
+				handle_tick_timer();
+		}
+
+		Uint64 now_counter = SDL_GetPerformanceCounter();
+		window_busy_counts += now_counter - busy_start_counter;
+		busy_start_counter = now_counter;
+
+		if (now_counter - window_start_counter >= report_interval_counts)
+		{
+			struct server_stats stats;
+			take_stats(&stats);
+			print_stats(&stats);
+		}
+
+		if (duration_s > 0 && now_counter - start_counter >= frequency * duration_s)
+			break;
+	}
+
+	struct server_stats stats;
+	take_stats(&stats);
+	print_stats(&stats);
+	close_server();
+
+	return 0;
+}
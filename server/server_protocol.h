@@ -0,0 +1,82 @@
+#pragma once
+
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/types.h"
+
+/*
+ * #############################################
+ *  MATCH SERVER PROTOCOL
+ *  UDP packets between server/match_server.c and its clients. A client
+ *  sends JOIN and gets a session and a seat in a match back, then sends its
+ *  controller every tick and gets the match state every tick. Both ends
+ *  are the same build on the same architecture so structs go over as is.
+ * #############################################
+ */
+
+#define SERVER_PACKET_JOIN 1 // client -> server, asks for a seat
+#define SERVER_PACKET_WELCOME 2 // server -> client, the session and seat it got
+#define SERVER_PACKET_FULL 3 // server -> client, no sessions left
+#define SERVER_PACKET_INPUT 4 // client -> server, the controller as of the client's latest tick
+#define SERVER_PACKET_STATE 5 // server -> client, the match after a tick
+#define SERVER_PACKET_LEAVE 6 // client -> server, frees the seat straight away instead of timing out
+#define SERVER_PACKET_STATS_REQUEST 7 // anyone -> server, replies with the stats since the last request and starts a new window
+#define SERVER_PACKET_STATS 8 // server -> whoever asked
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+
+// Starts every packet, the session fields are 0 until the server hands them out
+struct server_packet_header
+{
+	Uint32 magic;
+	Uint32 type;
+	Uint32 session_index;
+	Uint32 session_token; // random per session, so a stale or spoofed index gets ignored
+};
+
+struct server_welcome_packet
+{
+	struct server_packet_header header;
+	Uint32 match_index;
+	Uint32 seat; // paddle index
+};
+
+struct server_input_packet
+{
+	struct server_packet_header header;
+	Uint32 sequence; // anything not newer than the last one the server took is dropped
+	struct game_controller_input controller; // half transitions are since the previous packet
+};
+
+struct server_state_packet
+{
+	struct server_packet_header header;
+	Uint32 tick;
+	Uint32 last_input_sequence; // lets the client work out its input latency
+	struct game_snapshot snapshot;
+};
+
+struct server_stats
+{
+	Uint32 num_sessions;
+	Uint32 num_matches; // with at least one player
+	Uint32 num_ticks;
+	Uint32 num_missed_ticks; // the tick timer fired more than once before the loop got back to it
+	Uint32 tick_p50_us;
+	Uint32 tick_p99_us;
+	Uint32 tick_max_us;
+	Uint32 busy_percent; // of the window spent outside epoll_wait
+	Uint64 num_packets_received;
+	Uint64 num_packets_sent;
+	Uint64 num_packets_dropped; // the socket's send buffer was full
+};
+
+struct server_stats_packet
+{
+	struct server_packet_header header;
+	struct server_stats stats;
+};
@@ -0,0 +1,125 @@
+#include <string.h>
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+#include "ai.h"
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+
+// The paddle's half height plus half a ball (67.5px) either side of the aim is a hit, so the aim error sets
+// how many returns get missed. Even hard has to miss some or two of them would rally forever.
+static const struct ai_difficulty ai_difficulties[AI_DIFFICULTIES_NUM] = {
+	{ "easy", 24.0f, 120.0f, FALSE }, // ~44% of returns missed, and it waits wherever it last went
+	{ "normal", 10.0f, 90.0f, TRUE }, // ~25%
+	{ "hard", 4.0f, 75.0f, TRUE }, // ~10%
+};
+
+/// <summary>
+///		Gets one of the AI_DIFFICULTY_* presets
+/// </summary>
+const struct ai_difficulty* get_ai_difficulty(int level)
+{
+	if (level < 0 || level >= AI_DIFFICULTIES_NUM)
+		level = AI_DIFFICULTY_DEFAULT;
+
+	return &ai_difficulties[level];
+}
+
+/// <returns>The AI_DIFFICULTY_* level with that name, -1 if there isn't one</returns>
+int find_ai_difficulty(const char* name)
+{
+	for (int i = 0; i < AI_DIFFICULTIES_NUM; i++)
+	{
+		if (strcmp(ai_difficulties[i].name, name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/// <summary>
+///		Cheap xorshift so an AI plays the same way for a given seed
+/// </summary>
+static Uint32 next_ai_random(struct ai_controller* ai)
+{
+	ai->random_state ^= ai->random_state << 13;
+	ai->random_state ^= ai->random_state >> 17;
+	ai->random_state ^= ai->random_state << 5;
+	return ai->random_state;
+}
+
+void init_ai_controller(struct ai_controller* ai, const struct ai_difficulty* difficulty, Uint32 seed)
+{
+	SDL_zerop(ai);
+	ai->difficulty = *difficulty;
+	ai->random_state = seed ? seed : 1;
+	ai->target_y = WINDOW_HEIGHT / 2;
+}
+
+/// <summary>
+///		Where the ball's top edge will be after some ticks. Off the walls the ball moves up and down
+///		a triangle wave, so instead of stepping it bounce by bounce the straight line path is folded
+///		back into the court.
+/// </summary>
+float predict_ball_y(const struct ball* ball, float ticks)
+{
+	float range = WINDOW_HEIGHT - BALL_SIZE; // the top edge goes from 0 to here
+	float period = range * 2.0f; // down to the bottom and back up again
+
+	float y = ball->y + (ball->dy * ticks);
+	y -= period * (int)(y / period);
+
+	if (y < 0.0f)
+		y += period;
+
+	return y > range ? period - y : y;
+}
+
+static void set_ai_button(struct game_button_state* button, int is_down)
+{
+	button->half_transition_count = button->ended_down != is_down ? 1 : 0;
+	button->ended_down = is_down;
+}
+
+/// <summary>
+///		Runs the AI for one simulation step and presses the paddle's buttons, transitions are against whatever is in controller already
+/// </summary>
+/// <param name="step_ticks">60Hz ticks this step covers</param>
+void update_ai_controller(struct ai_controller* ai, const struct ball* ball, const struct paddle* paddle, float step_ticks, struct game_controller_input* controller)
+{
+	// the ball's left edge meets the left paddle's face and its right edge the right paddle's
+	int is_left_paddle = paddle->x < WINDOW_WIDTH / 2;
+	float face_x = is_left_paddle ? paddle->x + paddle->width : paddle->x - BALL_SIZE;
+	int is_approaching = is_left_paddle ? ball->dx < 0 : ball->dx > 0;
+	float ticks_to_face = is_approaching ? SDL_max((face_x - ball->x) / ball->dx, 0.0f) : 0.0f;
+
+	// a return turns the ball round, a serve puts it further away than it was
+	if (is_approaching && (!ai->is_approaching || ticks_to_face > ai->ticks_to_face))
+	{
+		float spread = ai->difficulty.aim_error * 2.0f;
+		ai->aim_offset = spread > 0.0f ? ((float)(next_ai_random(ai) % 10001) / 10000.0f * spread) - ai->difficulty.aim_error : 0.0f;
+		ai->reaction_ticks_left = ai->difficulty.reaction_ticks;
+	}
+
+	ai->is_approaching = is_approaching;
+	ai->ticks_to_face = ticks_to_face;
+
+	// still reacting it keeps going for wherever it was going before
+	if (ai->reaction_ticks_left > 0.0f)
+		ai->reaction_ticks_left -= step_ticks;
+	else if (is_approaching)
+		ai->target_y = predict_ball_y(ball, ticks_to_face) + (BALL_SIZE / 2.0f) + ai->aim_offset;
+	else if (ai->difficulty.is_recentring)
+		ai->target_y = WINDOW_HEIGHT / 2;
+
+	float paddle_centre_y = paddle->y + (paddle->height / 2);
+
+	controller->is_connected = TRUE;
+	controller->is_analogue = FALSE;
+	set_ai_button(&controller->move_up, ai->target_y < paddle_centre_y - BOT_DEAD_ZONE);
+	set_ai_button(&controller->move_down, ai->target_y > paddle_centre_y + BOT_DEAD_ZONE);
+}
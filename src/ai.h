@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+
+/*
+ * #############################################
+ *  AI OPPONENT
+ *  Drives a paddle through a game_controller_input like a player would.
+ *  Where the ball will cross the paddle's face is worked out in one go from
+ *  its position and velocity, with the top/bottom bounces folded out of the
+ *  straight line path, so a tick costs the same few flops however far away
+ *  the ball is. Difficulty is how late it reacts to a new approach and how
+ *  far off the spot on the paddle it aims for can be.
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct ai_difficulty
+{
+	const char* name;
+	float reaction_ticks; // how long after the ball turns towards it before it moves
+	float aim_error; // the spot on the paddle it aims the ball at is off by up to this many px either way (past the paddle's half height + half a ball is a miss)
+	int is_recentring; // heads back to the middle while the ball is going away
+};
+
+struct ai_controller
+{
+	struct ai_difficulty difficulty;
+	Uint32 random_state;
+	float target_y; // where it wants the middle of the paddle
+	float aim_offset; // picked once an approach
+	float reaction_ticks_left;
+	float ticks_to_face; // as of the last update
+	int is_approaching;
+};
+
+const struct ai_difficulty* get_ai_difficulty(int level);
+int find_ai_difficulty(const char* name);
+
+void init_ai_controller(struct ai_controller* ai, const struct ai_difficulty* difficulty, Uint32 seed);
+void update_ai_controller(struct ai_controller* ai, const struct ball* ball, const struct paddle* paddle, float step_ticks, struct game_controller_input* controller);
+
+float predict_ball_y(const struct ball* ball, float ticks);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  BAKED ASSETS
+ *  The title, number map and game over bitmaps plus a white block for solid
+ *  shapes and the HUD font, baked at build time by tools/bake_assets.c into
+ *  one atlas that's compiled into the binary (src/baked_assets.c is generated,
+ *  not checked in).
+ *  Pixels are already in screen_surface's format with the colour key cleared
+ *  to 0, so startup doesn't touch the disk and drawing them is a straight copy.
+ * #############################################
+ */
+
+// RGBA32 on little endian, the packed Uint32 values in baked_atlas_pixels are laid out this way whatever the byte order
+#define BAKED_ATLAS_FORMAT SDL_PIXELFORMAT_ABGR8888
+
+extern const int baked_atlas_width;
+extern const int baked_atlas_height;
+extern const Uint32 baked_atlas_pixels[];
+
+// Where each sprite is in the atlas
+extern const SDL_Rect baked_title_rect;
+extern const SDL_Rect baked_num_map_rect;
+extern const SDL_Rect baked_game_over_rect;
+extern const SDL_Rect baked_white_rect;
+extern const SDL_Rect baked_hud_font_rect;
@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <SDL.h>
+#include "constants.h"
+#include "simd.h"
+#include "ball_swarm.h"
+
+// Where a ball's top left corner can go and stay inside the window
+#define BALL_SWARM_MAX_X ((float)(WINDOW_WIDTH - BALL_SIZE))
+#define BALL_SWARM_MAX_Y ((float)(WINDOW_HEIGHT - BALL_SIZE))
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+typedef void (*ball_swarm_kernel_func)(float* x, float* y, float* dx, float* dy, int count, float step_ticks);
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int simd_level = SIMD_LEVEL_SCALAR;
+static ball_swarm_kernel_func update_kernel;
+
+/*
+ * #############################################
+ *  SCALAR
+ * #############################################
+ */
+
+/// <summary>
+///		Moves one axis and reflects it off the walls, anything still outside after that (a huge step) is clamped
+/// </summary>
+static void integrate_axis_scalar(float* pos, float* vel, float step_ticks, float max_pos)
+{
+	float p = *pos + (*vel * step_ticks);
+
+	if (p < 0.0f)
+	{
+		p = 0.0f - p;
+		*vel = -*vel;
+	}
+	else if (p > max_pos)
+	{
+		p = (max_pos * 2.0f) - p;
+		*vel = -*vel;
+	}
+
+	*pos = SDL_min(SDL_max(p, 0.0f), max_pos);
+}
+
+static void update_kernel_scalar(float* x, float* y, float* dx, float* dy, int count, float step_ticks)
+{
+	for (int i = 0; i < count; i++)
+	{
+		integrate_axis_scalar(&x[i], &dx[i], step_ticks, BALL_SWARM_MAX_X);
+		integrate_axis_scalar(&y[i], &dy[i], step_ticks, BALL_SWARM_MAX_Y);
+	}
+}
+
+#if SIMD_HAS_X86
+/*
+ * #############################################
+ *  SSE2 (4 balls at a time)
+ * #############################################
+ */
+SIMD_TARGET_SSE2 static void integrate_axis_sse2(float* pos, float* vel, __m128 step_x4, __m128 max_x4)
+{
+	__m128 zero_x4 = _mm_setzero_ps();
+	__m128 sign_x4 = _mm_set1_ps(-0.0f);
+
+	__m128 v = _mm_load_ps(vel);
+	__m128 p = _mm_add_ps(_mm_load_ps(pos), _mm_mul_ps(v, step_x4));
+
+	// no blendv in SSE2 so the selects are and/andnot/or
+	__m128 is_below = _mm_cmplt_ps(p, zero_x4);
+	__m128 is_above = _mm_cmpgt_ps(p, max_x4);
+	__m128 below_reflected = _mm_sub_ps(zero_x4, p);
+	__m128 above_reflected = _mm_sub_ps(_mm_add_ps(max_x4, max_x4), p);
+
+	p = _mm_or_ps(_mm_and_ps(is_below, below_reflected), _mm_andnot_ps(is_below, p));
+	p = _mm_or_ps(_mm_and_ps(is_above, above_reflected), _mm_andnot_ps(is_above, p));
+	v = _mm_xor_ps(v, _mm_and_ps(_mm_or_ps(is_below, is_above), sign_x4));
+
+	_mm_store_ps(pos, _mm_min_ps(_mm_max_ps(p, zero_x4), max_x4));
+	_mm_store_ps(vel, v);
+}
+
+SIMD_TARGET_SSE2 static void update_kernel_sse2(float* x, float* y, float* dx, float* dy, int count, float step_ticks)
+{
+	__m128 step_x4 = _mm_set1_ps(step_ticks);
+	__m128 max_x_x4 = _mm_set1_ps(BALL_SWARM_MAX_X);
+	__m128 max_y_x4 = _mm_set1_ps(BALL_SWARM_MAX_Y);
+
+	for (int i = 0; i < count; i += 4)
+	{
+		integrate_axis_sse2(&x[i], &dx[i], step_x4, max_x_x4);
+		integrate_axis_sse2(&y[i], &dy[i], step_x4, max_y_x4);
+	}
+}
+
+/*
+ * #############################################
+ *  AVX2 (8 balls at a time)
+ * #############################################
+ */
+SIMD_TARGET_AVX2 static void integrate_axis_avx2(float* pos, float* vel, __m256 step_x8, __m256 max_x8)
+{
+	__m256 zero_x8 = _mm256_setzero_ps();
+	__m256 sign_x8 = _mm256_set1_ps(-0.0f);
+
+	__m256 v = _mm256_load_ps(vel);
+	__m256 p = _mm256_add_ps(_mm256_load_ps(pos), _mm256_mul_ps(v, step_x8));
+
+	__m256 is_below = _mm256_cmp_ps(p, zero_x8, _CMP_LT_OQ);
+	__m256 is_above = _mm256_cmp_ps(p, max_x8, _CMP_GT_OQ);
+
+	p = _mm256_blendv_ps(p, _mm256_sub_ps(zero_x8, p), is_below);
+	p = _mm256_blendv_ps(p, _mm256_sub_ps(_mm256_add_ps(max_x8, max_x8), p), is_above);
+	v = _mm256_xor_ps(v, _mm256_and_ps(_mm256_or_ps(is_below, is_above), sign_x8));
+
+	_mm256_store_ps(pos, _mm256_min_ps(_mm256_max_ps(p, zero_x8), max_x8));
+	_mm256_store_ps(vel, v);
+}
+
+SIMD_TARGET_AVX2 static void update_kernel_avx2(float* x, float* y, float* dx, float* dy, int count, float step_ticks)
+{
+	__m256 step_x8 = _mm256_set1_ps(step_ticks);
+	__m256 max_x_x8 = _mm256_set1_ps(BALL_SWARM_MAX_X);
+	__m256 max_y_x8 = _mm256_set1_ps(BALL_SWARM_MAX_Y);
+
+	for (int i = 0; i < count; i += 8)
+	{
+		integrate_axis_avx2(&x[i], &dx[i], step_x8, max_x_x8);
+		integrate_axis_avx2(&y[i], &dy[i], step_x8, max_y_x8);
+	}
+}
+#endif
+
+int ball_swarm_get_simd_level()
+{
+	return simd_level;
+}
+
+/// <summary>
+///		Forces a kernel level (for benchmarking), falls back a level at a time if the CPU can't do it
+/// </summary>
+/// <returns>The level actually in use</returns>
+int ball_swarm_set_simd_level(int level)
+{
+	simd_level = simd_supported_level(level);
+
+	switch (simd_level) {
+#if SIMD_HAS_X86
+		case SIMD_LEVEL_AVX2:
+			update_kernel = update_kernel_avx2;
+			break;
+
+		case SIMD_LEVEL_SSE2:
+			update_kernel = update_kernel_sse2;
+			break;
+#endif
+
+		default:
+			update_kernel = update_kernel_scalar;
+			break;
+	}
+
+	return simd_level;
+}
+
+/// <summary>
+///		Allocates room for capacity balls (rounded up to a whole number of SIMD lanes) and picks the kernels
+/// </summary>
+int init_ball_swarm(struct ball_swarm* swarm, int capacity)
+{
+	SDL_zerop(swarm);
+
+	if (!update_kernel)
+		ball_swarm_set_simd_level(simd_detect_level());
+
+	capacity = (capacity + BALL_SWARM_LANES - 1) / BALL_SWARM_LANES * BALL_SWARM_LANES;
+
+	if (capacity <= 0)
+		return TRUE;
+
+	size_t array_size = capacity * sizeof(float);
+	swarm->x = SDL_SIMDAlloc(array_size);
+	swarm->y = SDL_SIMDAlloc(array_size);
+	swarm->dx = SDL_SIMDAlloc(array_size);
+	swarm->dy = SDL_SIMDAlloc(array_size);
+
+	if (!swarm->x || !swarm->y || !swarm->dx || !swarm->dy)
+	{
+		printf("Could not allocate a swarm of %d balls.\n", capacity);
+		release_ball_swarm(swarm);
+		return FALSE;
+	}
+
+	// the padding lanes get run through the kernels too, zeros just sit in the corner
+	SDL_memset(swarm->x, 0, array_size);
+	SDL_memset(swarm->y, 0, array_size);
+	SDL_memset(swarm->dx, 0, array_size);
+	SDL_memset(swarm->dy, 0, array_size);
+
+	swarm->capacity = capacity;
+
+	return TRUE;
+}
+
+void release_ball_swarm(struct ball_swarm* swarm)
+{
+	SDL_SIMDFree(swarm->x);
+	SDL_SIMDFree(swarm->y);
+	SDL_SIMDFree(swarm->dx);
+	SDL_SIMDFree(swarm->dy);
+	SDL_zerop(swarm);
+}
+
+/// <summary>
+///		Scatters count balls over the playfield heading off in random directions, the same seed gives the same swarm
+/// </summary>
+void spawn_ball_swarm(struct ball_swarm* swarm, int count, Uint32 seed)
+{
+	Uint32 random_state = seed ? seed : 1;
+	swarm->count = SDL_min(count, swarm->capacity);
+
+	for (int i = 0; i < swarm->count; i++)
+	{
+		// xorshift, same as the bots
+		Uint32 random[4];
+
+		for (int r = 0; r < 4; r++)
+		{
+			random_state ^= random_state << 13;
+			random_state ^= random_state >> 17;
+			random_state ^= random_state << 5;
+			random[r] = random_state;
+		}
+
+		swarm->x[i] = (float)(random[0] % (WINDOW_WIDTH - BALL_SIZE));
+		swarm->y[i] = (float)(random[1] % (WINDOW_HEIGHT - BALL_SIZE));
+		swarm->dx[i] = (float)(BALL_DX_DEFAULT + (random[2] % BALL_DX_MAX)) * ((random[2] >> 16) & 1 ? 1.0f : -1.0f);
+		swarm->dy[i] = (float)(1 + (random[3] % BALL_DX_MAX)) * ((random[3] >> 16) & 1 ? 1.0f : -1.0f);
+	}
+}
+
+/// <summary>
+///		Moves every ball in the swarm by step_ticks worth of its velocity, bouncing off all four walls
+/// </summary>
+void update_ball_swarm(struct ball_swarm* swarm, float step_ticks)
+{
+	if (swarm->count == 0)
+		return;
+
+	// the hot-reloaded game library has its own copy of this file, and the executable's copy made the swarm
+	if (!update_kernel)
+		ball_swarm_set_simd_level(simd_detect_level());
+
+	// whole lanes only, the arrays are padded out to a multiple of BALL_SWARM_LANES
+	int lane_count = (swarm->count + BALL_SWARM_LANES - 1) / BALL_SWARM_LANES * BALL_SWARM_LANES;
+	update_kernel(swarm->x, swarm->y, swarm->dx, swarm->dy, lane_count, step_ticks);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  BALL SWARM
+ *  Lots of extra balls for chaos mode and load testing (hundreds up to 100k),
+ *  kept as structure of arrays so the integrate + wall bounce kernel can run
+ *  4 (SSE2) or 8 (AVX2) balls at a time. Velocities are floats in pixels per
+ *  60Hz tick, same units as the main ball.
+ * #############################################
+ */
+
+struct ball_swarm
+{
+	int count;
+	int capacity; // always a multiple of BALL_SWARM_LANES, the kernels run over the padding too
+	float* x;
+	float* y;
+	float* dx;
+	float* dy;
+};
+
+int init_ball_swarm(struct ball_swarm* swarm, int capacity);
+void release_ball_swarm(struct ball_swarm* swarm);
+void spawn_ball_swarm(struct ball_swarm* swarm, int count, Uint32 seed);
+
+void update_ball_swarm(struct ball_swarm* swarm, float step_ticks);
+
+int ball_swarm_get_simd_level();
+int ball_swarm_set_simd_level(int level);
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <SDL.h>
+#include "constants.h"
+#include "broadphase.h"
+
+/// <summary>
+///		Which cell a point is in, anything off the playfield goes in the nearest edge cell
+/// </summary>
+static int get_cell_index(const struct broadphase_grid* grid, float x, float y)
+{
+	// the cell size is a power of two so the multiply is exact, clamping as floats lets the refiling loop vectorize
+	float column = SDL_min(SDL_max(x * (1.0f / BROADPHASE_CELL_SIZE), 0.0f), (float)(grid->columns - 1));
+	float row = SDL_min(SDL_max(y * (1.0f / BROADPHASE_CELL_SIZE), 0.0f), (float)(grid->rows - 1));
+
+	return ((int)row * grid->columns) + (int)column;
+}
+
+int init_broadphase_grid(struct broadphase_grid* grid, int capacity)
+{
+	SDL_zerop(grid);
+	grid->columns = (WINDOW_WIDTH + BROADPHASE_CELL_SIZE - 1) / BROADPHASE_CELL_SIZE;
+	grid->rows = (WINDOW_HEIGHT + BROADPHASE_CELL_SIZE - 1) / BROADPHASE_CELL_SIZE;
+
+	int num_cells = grid->columns * grid->rows;
+	grid->cell_starts = SDL_calloc(num_cells + 1, sizeof(int));
+	grid->sorted_objects = SDL_malloc(SDL_max(capacity, 1) * sizeof(int));
+	grid->object_cells = SDL_malloc(SDL_max(capacity, 1) * sizeof(int));
+
+	if (!grid->cell_starts || !grid->sorted_objects || !grid->object_cells)
+	{
+		printf("Could not allocate a broadphase grid for %d objects.\n", capacity);
+		release_broadphase_grid(grid);
+		return FALSE;
+	}
+
+	// no object is filed anywhere yet, so the first update refiles every one of them (all bits set is cell -1)
+	SDL_memset(grid->object_cells, 0xFF, SDL_max(capacity, 1) * sizeof(int));
+	grid->capacity = capacity;
+
+	return TRUE;
+}
+
+void release_broadphase_grid(struct broadphase_grid* grid)
+{
+	SDL_free(grid->cell_starts);
+	SDL_free(grid->sorted_objects);
+	SDL_free(grid->object_cells);
+	SDL_zerop(grid);
+}
+
+/// <summary>
+///		Refiles the objects if any of them has moved into a different cell (or the count changed) since last time.
+///		NOTE: Chaos balls cover a cell in a couple of ticks so most of them move cell every tick,
+///		two linear passes (count per cell, then scatter into place) beat relinking objects one by one
+/// </summary>
+/// <returns>TRUE if the grid had to be refiled</returns>
+int update_broadphase_grid(struct broadphase_grid* grid, const float* x, const float* y, int count)
+{
+	count = SDL_min(count, grid->capacity);
+
+	int num_cells = grid->columns * grid->rows;
+	int is_stale = count != grid->count;
+
+	for (int i = 0; i < count; i++)
+	{
+		int cell_index = get_cell_index(grid, x[i], y[i]);
+		is_stale |= cell_index != grid->object_cells[i];
+		grid->object_cells[i] = cell_index;
+	}
+
+	if (!is_stale)
+		return FALSE;
+
+	// count each cell into the slot after it, the running sum then gives where each cell starts
+	SDL_memset(grid->cell_starts, 0, (num_cells + 1) * sizeof(int));
+
+	for (int i = 0; i < count; i++)
+		grid->cell_starts[grid->object_cells[i] + 1]++;
+
+	for (int cell_index = 0; cell_index < num_cells; cell_index++)
+		grid->cell_starts[cell_index + 1] += grid->cell_starts[cell_index];
+
+	// scatter using the starts as write cursors then shift them back, saves a second array
+	for (int i = 0; i < count; i++)
+		grid->sorted_objects[grid->cell_starts[grid->object_cells[i]]++] = i;
+
+	for (int cell_index = num_cells; cell_index > 0; cell_index--)
+		grid->cell_starts[cell_index] = grid->cell_starts[cell_index - 1];
+
+	grid->cell_starts[0] = 0;
+	grid->count = count;
+
+	return TRUE;
+}
+
+/// <summary>
+///		Visits every object whose top left corner is filed in a cell the box overlaps.
+///		To find everything overlapping a box, grow the box up and left by the object size first.
+/// </summary>
+/// <returns>How many objects were visited</returns>
+int query_broadphase_grid(const struct broadphase_grid* grid, float min_x, float min_y, float max_x, float max_y, broadphase_visit_func visit, void* user_data)
+{
+	int min_cell = get_cell_index(grid, min_x, min_y);
+	int max_cell = get_cell_index(grid, max_x, max_y);
+	int min_column = min_cell % grid->columns;
+	int max_column = max_cell % grid->columns;
+	int num_visited = 0;
+
+	for (int row = min_cell / grid->columns; row <= max_cell / grid->columns; row++)
+	{
+		// a row of cells is one contiguous run of sorted objects
+		int first_cell = (row * grid->columns) + min_column;
+		int last_cell = (row * grid->columns) + max_column;
+
+		for (int k = grid->cell_starts[first_cell]; k < grid->cell_starts[last_cell + 1]; k++)
+			visit(grid->sorted_objects[k], user_data);
+
+		num_visited += grid->cell_starts[last_cell + 1] - grid->cell_starts[first_cell];
+	}
+
+	return num_visited;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  BROADPHASE GRID
+ *  Uniform grid over the playfield for finding which of many small objects
+ *  (the chaos mode balls) are anywhere near a box (a paddle). Objects are
+ *  filed under the cell their top left corner is in and kept sorted by cell
+ *  so each cell is one contiguous run of object indices.
+ * #############################################
+ */
+
+struct broadphase_grid
+{
+	int columns;
+	int rows;
+	int capacity;
+	int count;
+	int* cell_starts; // columns * rows + 1, cell c is sorted_objects[cell_starts[c]] up to cell_starts[c + 1]
+	int* sorted_objects;
+	int* object_cells; // which cell each object is filed under
+};
+
+// Called for every object filed in the cells a query touches, the caller does the real overlap test
+typedef void (*broadphase_visit_func)(int object_index, void* user_data);
+
+int init_broadphase_grid(struct broadphase_grid* grid, int capacity);
+void release_broadphase_grid(struct broadphase_grid* grid);
+
+int update_broadphase_grid(struct broadphase_grid* grid, const float* x, const float* y, int count);
+int query_broadphase_grid(const struct broadphase_grid* grid, float min_x, float min_y, float max_x, float max_y, broadphase_visit_func visit, void* user_data);
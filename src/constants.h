@@ -6,14 +6,37 @@
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
-#define FPS 60
-#define FRAME_TARGET_TIME_MS (1000 / FPS)
+#define FPS 144 // default display rate cap (--fps), the simulation runs at its own fixed tick rate below
+
+#define PACING_MODE_FIXED 0 // sleep then spin to FPS
+#define PACING_MODE_VSYNC 1 // SDL_RenderPresent waits for the display
+#define PACING_MODE_UNLIMITED 2
+#define PACING_MODES_NUM 3
+#define PACING_SAMPLES_MAX 1024 // frame intervals the jitter stats are worked out over
+#define PACING_SLEEP_ESTIMATE_S 0.002 // what we assume SDL_Delay(1) takes until we've timed a few
+#define PACING_SLEEP_HISTORY_MAX 256 // sleeps the estimate is averaged over
+#define PACING_MISSED_FRAME_FACTOR 1.5 // a frame interval this many target periods long is a missed frame
+
+#define RENDER_SCALE_PERCENT_MIN 50 // the software renderer's resolution as a percentage of WINDOW_WIDTH x WINDOW_HEIGHT
+#define RENDER_SCALE_PERCENT_MAX 400 // the surfaces are allocated for the window's own resolution up to this
+#define RENDER_SCALE_PERCENT_STEP 10
+#define RENDER_SCALE_BUDGET_FRACTION 0.5 // of the frame budget drawing and uploading gets, the rest is simulation, present and the OS
+#define RENDER_SCALE_RAISE_FRACTION 0.7 // only step up if the bigger size should still come in under this much of drawing's share
+#define RENDER_SCALE_SMOOTHING 0.1
+#define RENDER_SCALE_SKIP_FRAMES 2 // full redraws after a change, not counted
+#define RENDER_SCALE_SETTLE_FRAMES 30 // frames measured at a size before it changes again
+
+#define SIM_TICKS_PER_SECOND 60
+#define SIM_DT_S (1.0 / SIM_TICKS_PER_SECOND)
+#define SIM_MAX_FRAME_TIME_S 0.25
 
 #define GAME_CONTROLLERS_MAX 2
+#define INPUT_LATENCY_EVENTS_MAX 64 // per frame, anything past this isn't measured
 
 #define GAME_SCREEN_TITLE_INDEX 0
 #define GAME_SCREEN_GAME_INDEX 1
 #define GAME_SCREEN_GAME_OVER_INDEX 2
+#define GAME_SCREEN_NONE_INDEX 0xFF // nothing rendered yet, forces a full redraw/rebuild
 #define GAME_SCREEN_TITLE_RUNS_GAME 0
 #define GAME_SCREEN_GAME_RUNS_GAME 1
 #define GAME_SCREEN_GAME_OVER_RUNS_GAME 0
@@ -28,6 +51,31 @@
 #define BALL_Y_DEFAULT 20
 #define BALL_DX_DEFAULT 2
 #define BALL_DY_DEFAULT 2
+#define BALL_DX_MAX 20 // px a tick, every paddle hit speeds the ball up so rallies have to top out somewhere
+#define BALL_SWEEP_ITERATIONS_MAX 8 // bounces resolved within one step before the rest of the move is dropped
+#define BALL_SWARM_LANES 8 // AVX2 width, the swarm arrays are padded out to a multiple of this
+#define BALL_SWARM_MAX 1000000
+#define BROADPHASE_CELL_SIZE 32 // about 2 balls across, a paddle covers ~3x6 cells once it's grown by a ball
+
+#define MATCH_EVENTS_MAX 8 // per update, a step only ever has a hit or two and maybe a goal
+#define MATCH_FRAME_EVENTS_MAX 64 // --threaded, events held for the window until it's seen them (the oldest go if it stalls)
+#define MATCH_EVENT_PADDLE_HIT 0
+#define MATCH_EVENT_GOAL 1
+
+#define PARTICLES_LANES 8 // AVX2 width, the pool is padded out to a multiple of this
+#define PARTICLES_POOL_SIZE 16384 // the game's pool, a goal is the biggest burst at a few hundred
+#define PARTICLES_SIZE 3
+#define PARTICLES_GRAVITY 0.15f // px a tick, added to dy every tick
+#define PARTICLES_DRAG 0.03f // fraction of the velocity lost every tick
+#define PARTICLES_FADE_TICKS 20.0f
+#define PARTICLES_SHADES_NUM 16
+#define PARTICLES_HIT_SPARKS 48
+#define PARTICLES_HIT_SPREAD 4.0f
+#define PARTICLES_GOAL_SPARKS 400
+#define PARTICLES_GOAL_SPREAD 9.0f
+#define PARTICLES_TRAIL_TICKS 30 // how long the ball leaves a trail after a paddle hit
+#define PARTICLES_TRAIL_PER_TICK 3
+#define PARTICLES_TRAIL_SPREAD 0.6f
 
 #define PADDLE_WIDTH 20
 #define PADDLE_HEIGHT (WINDOW_HEIGHT / 5)
@@ -40,4 +88,114 @@
 #define SCORE_POINTS_INCREMENT 1
 #define SCORE_NUM_SPRITE_WIDTH 64
 #define SCORE_NUM_SPRITE_HEIGHT 64
-#define SCORE_NUM_SPRITE_PADDING 24
\ No newline at end of file
+#define SCORE_NUM_SPRITE_PADDING 24
+
+#define RENDER_BACKEND_SURFACE 0 // CPU rasterized screen_surface uploaded as one texture
+#define RENDER_BACKEND_HW 1 // SDL_Renderer draw list from a sprite atlas
+#define RENDER_BENCH_FRAMES_MAX 100000
+
+#define PROFILER_RING_CAPACITY 65536 // must be a power of 2, ~10 events a frame so a couple of minutes of history
+#define PROFILER_STATS_WINDOW 8192
+#define PROFILER_LATENCY_SAMPLES_MAX 4096
+#define PROFILER_OVERLAY_REFRESH_FRAMES 30
+#define PROFILER_OVERLAY_X 16
+#define PROFILER_OVERLAY_Y 426
+#define PROFILER_OVERLAY_PADDING 4
+#define PROFILER_OVERLAY_ROW_HEIGHT 14
+#define PROFILER_OVERLAY_BAR_WIDTH_MAX 200
+
+#define HW_DRAW_LIST_QUADS_MAX 1024 // chaos mode balls go through in batches of this many
+#define HW_ATLAS_WHITE_SIZE 4 // solid shapes sample the middle of this block
+
+#define HUD_TEXT_SCORE_0_INDEX 0
+#define HUD_TEXT_SCORE_1_INDEX 1
+#define HUD_TEXT_ROUND_INDEX 2
+#define HUD_TEXT_TIMER_INDEX 3
+#define HUD_TEXT_FRAME_STATS_INDEX 4
+#define HUD_TEXTS_NUM 5
+#define HUD_TEXT_LENGTH_MAX 32
+#define HUD_FONT_DIGITS 0 // the number map, 0-9 only
+#define HUD_FONT_SMALL 1 // baked 5x7 font, ' ' to '_' with lower case drawn as upper case
+#define HUD_FONT_FIRST_CHAR ' '
+#define HUD_FONT_GLYPHS_NUM 64
+#define HUD_FONT_GLYPHS_PER_ROW 16
+#define HUD_FONT_GLYPH_WIDTH 5
+#define HUD_FONT_GLYPH_HEIGHT 7
+#define HUD_FONT_SCALE 2 // baked at this size so a glyph is a straight copy
+#define HUD_FONT_CELL_WIDTH ((HUD_FONT_GLYPH_WIDTH + 1) * HUD_FONT_SCALE)
+#define HUD_FONT_CELL_HEIGHT ((HUD_FONT_GLYPH_HEIGHT + 1) * HUD_FONT_SCALE)
+#define HUD_ALIGN_LEFT 0
+#define HUD_ALIGN_RIGHT 1
+#define HUD_ALIGN_CENTER 2
+#define HUD_MARGIN 8
+#define HUD_FRAME_STATS_REFRESH_MS 500 // averaged over this long so the readout is steady enough to read
+
+#define DIRTY_RECTS_MAX (1 + PADDLES_NUM_MAX + HUD_TEXTS_NUM) // ball + paddles + HUD texts, overlapping old and new rects merge
+
+#define AI_DIFFICULTY_EASY 0
+#define AI_DIFFICULTY_NORMAL 1
+#define AI_DIFFICULTY_HARD 2
+#define AI_DIFFICULTIES_NUM 3
+#define AI_DIFFICULTY_DEFAULT AI_DIFFICULTY_NORMAL
+
+#define HEADLESS_MATCHES_DEFAULT 1000
+#define HEADLESS_MATCH_FRAMES_MAX (SIM_TICKS_PER_SECOND * 60 * 10) // give up on a match after 10 simulated minutes
+#define BOT_DEAD_ZONE 5
+#define HEADLESS_SEED_STRIDE 2654435761u // golden ratio, spreads the per match seeds out
+#define HEADLESS_MATCHES_PER_JOB 16 // matches a worker steps in one go, small enough to steal, big enough to not notice the overhead
+
+#define SCHEDULER_THREADS_MAX 64
+#define SCHEDULER_DEQUE_CAPACITY 64 // must be a power of 2, ranges get halved so a deque only ever holds ~log2(items) of them
+
+#define REPLAY_FILE_MAGIC "PONGREC" // 8 bytes with the terminator
+#define REPLAY_FILE_VERSION 1
+#define REPLAY_BUTTON_TRANSITIONS_MAX 7 // 3 bits a button in the log
+
+#define TELEMETRY_FILE_MAGIC "PONGTLM" // 8 bytes with the terminator
+#define TELEMETRY_FILE_VERSION 1
+#define TELEMETRY_CAPACITY_DEFAULT 131072 // 4MB of records, several hours of play
+#define TELEMETRY_CAPACITY_MAX (1 << 24)
+#define TELEMETRY_SAMPLE_TICKS 15 // ball position and speed 4 times a second
+#define TELEMETRY_RECORD_MATCH_START 0
+#define TELEMETRY_RECORD_PADDLE_HIT 1
+#define TELEMETRY_RECORD_GOAL 2
+#define TELEMETRY_RECORD_BALL_SAMPLE 3
+#define TELEMETRY_RECORD_MATCH_END 4 // someone won, or it was reset back to the title
+#define TELEMETRY_RECORD_TYPES_NUM 5
+
+#define GAME_API_VERSION 1 // bump whenever struct game_api changes
+#ifdef _WIN32
+#define GAME_LIBRARY_PATH "pong_game.dll"
+#else
+#define GAME_LIBRARY_PATH "./libpong_game.so" // built by `make game`
+#endif
+#define GAME_LIBRARY_POLL_MS 250 // how often --hot-reload checks whether the library was rebuilt
+
+#define TRIPLE_BUFFER_INDEX_MASK 3
+#define TRIPLE_BUFFER_FRESH 4 // set alongside the middle slot's index until the reader takes it
+
+#define NETPLAY_PORT_DEFAULT 27015 // player 0 listens here and player 1 on the next port up
+#define NETPLAY_HISTORY_FRAMES 64 // must be a power of 2, snapshots and inputs kept to roll back to
+#define NETPLAY_PREDICTION_FRAMES_MAX 15 // how far (250ms) we run ahead of the peer's last input before waiting for them
+#define NETPLAY_INPUTS_PER_PACKET_MAX 64 // no more than NETPLAY_HISTORY_FRAMES, unacked inputs are resent every packet
+#define NETPLAY_PACKET_MAGIC 0x31474E50u // "PNG1"
+
+#define UDP_PACKET_SIZE_MAX 256
+#define UDP_DELAY_QUEUE_MAX 256 // packets the simulated network can be holding back at once
+
+#define SERVER_PORT_DEFAULT 27100
+#define SERVER_PACKET_MAGIC 0x31565253u // "SRV1"
+#define SERVER_SESSIONS_MAX 16384 // one per player, two to a match
+#define SERVER_MATCHES_MAX (SERVER_SESSIONS_MAX / PADDLES_NUM_MAX)
+#define SERVER_SESSION_TIMEOUT_MS 3000
+#define SERVER_IO_BATCH 64 // packets per recvmmsg/sendmmsg
+#define SERVER_SOCKET_BUFFER_BYTES (4 * 1024 * 1024) // the kernel caps this at net.core.rmem_max/wmem_max
+#define SERVER_BUTTON_TRANSITIONS_MAX 4 // per input packet, anything past this is a broken or cheating client
+#define SERVER_TICK_BUDGET_US (1000000 / SIM_TICKS_PER_SECOND)
+#define SERVER_TICK_SAMPLES_MAX 4096 // tick times kept between stats reports, ~68s at 60Hz
+#define SERVER_REPORT_INTERVAL_MS 10000 // printed this often unless the load client asks first
+
+#define LOAD_CLIENT_STEP_DEFAULT 512 // sessions added each step of the ramp
+#define LOAD_CLIENT_HOLD_MS_DEFAULT 3000 // how long each step runs before the server's stats are read
+#define LOAD_CLIENT_JOIN_WAIT_MS 2000
+#define LOAD_CLIENT_DELIVERY_MIN_PERCENT 95 // of the state broadcasts that should have arrived
\ No newline at end of file
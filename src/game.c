@@ -0,0 +1,17 @@
+#include <SDL.h>
+#include "constants.h"
+#include "game.h"
+
+/// <summary>
+///		Fills in the game layer's table from whichever copy of the code this is (the executable's or a loaded library's).
+///		Looked up by name when the library is loaded, so it's the one thing it has to export.
+/// </summary>
+void get_game_api(struct game_api* api)
+{
+	api->version = GAME_API_VERSION;
+	api->match_size = (int)sizeof(struct match);
+	api->ai_controller_size = (int)sizeof(struct ai_controller);
+
+	api->update_match = update_match;
+	api->update_ai_controller = update_ai_controller;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+#include "match.h"
+#include "ai.h"
+
+/*
+ * #############################################
+ *  GAME LAYER
+ *  The code worth tuning while the game is running (the match rules in
+ *  match.c and the AI in ai.c) reached through a table of function
+ *  pointers. The executable has its own copy of all of it, that's the
+ *  table it uses normally. `make game` builds the same files into a
+ *  shared library, and with --hot-reload the window swaps in a fresh
+ *  table every time that library is rebuilt (see game_library.h).
+ *
+ *  The window owns all the state (the match, the AI controllers) and
+ *  only ever hands the game layer pointers to it, so the match carries
+ *  on from where it was under the new code. That only holds while the
+ *  structs keep their layout. A library built with different sizes for
+ *  them is refused, restart to pick those changes up.
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct game_api
+{
+	int version; // GAME_API_VERSION the library was built with
+	int match_size; // sizeof(struct match) it was built with
+	int ai_controller_size;
+
+	void (*update_match)(struct match* match, const struct game_input* input);
+	void (*update_ai_controller)(struct ai_controller* ai, const struct ball* ball, const struct paddle* paddle, float step_ticks, struct game_controller_input* controller);
+};
+
+typedef void (*get_game_api_func)(struct game_api* api);
+
+void get_game_api(struct game_api* api);
@@ -0,0 +1,224 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // stat
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "constants.h"
+#include "game.h"
+#include "game_library.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+
+// Enough to tell the file was rebuilt without reading it
+struct file_stamp
+{
+	Uint64 write_time;
+	Uint64 size;
+	Uint64 id;
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static void* library_handle = NULL;
+static const char* library_path;
+static char copy_paths[2][FILENAME_MAX];
+static int loaded_copy_index; // the copy library_handle was loaded from, the next load goes into the other one
+static struct file_stamp library_stamp; // as of the last load we tried, good or bad
+static Uint32 last_poll_ms;
+
+static int get_file_stamp(const char* path, struct file_stamp* stamp)
+{
+	SDL_zerop(stamp);
+
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes))
+		return FALSE;
+
+	stamp->write_time = ((Uint64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	stamp->size = ((Uint64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+#else
+	struct stat file_stat;
+
+	if (stat(path, &file_stat) != 0)
+		return FALSE;
+
+	// `make game` renames the new build over the old one, so the inode changes even if the time (whole seconds) doesn't
+	stamp->write_time = (Uint64)file_stat.st_mtime;
+	stamp->size = (Uint64)file_stat.st_size;
+	stamp->id = (Uint64)file_stat.st_ino;
+#endif
+
+	return TRUE;
+}
+
+static int copy_file(const char* from_path, const char* to_path)
+{
+	FILE* from_file = fopen(from_path, "rb");
+
+	if (!from_file)
+		return FALSE;
+
+	FILE* to_file = fopen(to_path, "wb");
+
+	if (!to_file)
+	{
+		fclose(from_file);
+		return FALSE;
+	}
+
+	char buffer[65536];
+	size_t num_read;
+	int is_ok = TRUE;
+
+	while ((num_read = fread(buffer, 1, sizeof(buffer), from_file)) > 0)
+		is_ok = is_ok && fwrite(buffer, 1, num_read, to_file) == num_read;
+
+	is_ok = is_ok && !ferror(from_file);
+	fclose(from_file);
+
+	return fclose(to_file) == 0 && is_ok;
+}
+
+/// <summary>
+///		Loads a fresh copy of the library and, if it checks out, swaps it in for the one we had
+/// </summary>
+static int load_library(struct game_api* api)
+{
+	int copy_index = 1 - loaded_copy_index;
+	const char* copy_path = copy_paths[copy_index];
+
+	if (!copy_file(library_path, copy_path))
+	{
+		printf("Could not copy %s to %s.\n", library_path, copy_path);
+		return FALSE;
+	}
+
+	void* handle = SDL_LoadObject(copy_path);
+
+	if (!handle)
+	{
+		printf("Could not load %s. SDL Err: %s\n", library_path, SDL_GetError());
+		remove(copy_path);
+		return FALSE;
+	}
+
+	struct game_api new_api;
+	SDL_zero(new_api);
+
+	get_game_api_func get_library_api = (get_game_api_func)SDL_LoadFunction(handle, "get_game_api");
+
+	if (get_library_api)
+		get_library_api(&new_api);
+
+	// the match is ours and stays where it is, code that thinks it's laid out differently would scribble all over it
+	if (new_api.version != GAME_API_VERSION ||
+		new_api.match_size != (int)sizeof(struct match) ||
+		new_api.ai_controller_size != (int)sizeof(struct ai_controller) ||
+		!new_api.update_match || !new_api.update_ai_controller)
+	{
+		printf("%s doesn't match the game's structs, restart to pick up changes to them.\n", library_path);
+		SDL_UnloadObject(handle);
+		remove(copy_path);
+		return FALSE;
+	}
+
+	if (library_handle)
+	{
+		SDL_UnloadObject(library_handle);
+		remove(copy_paths[loaded_copy_index]);
+	}
+
+	library_handle = handle;
+	loaded_copy_index = copy_index;
+	*api = new_api;
+
+	return TRUE;
+}
+
+/// <summary>
+///		Loads the game layer from the library at path into api, from now on game_library_reload_if_changed() keeps it up to date
+/// </summary>
+int game_library_open(const char* path, struct game_api* api)
+{
+	game_library_close();
+
+	library_path = path;
+	loaded_copy_index = 0;
+
+	for (int i = 0; i < 2; i++)
+		SDL_snprintf(copy_paths[i], sizeof(copy_paths[i]), "%s.live%d", path, i);
+
+	if (!get_file_stamp(path, &library_stamp))
+	{
+		printf("Could not find %s, `make game` builds it.\n", path);
+		return FALSE;
+	}
+
+	last_poll_ms = SDL_GetTicks();
+
+	if (!load_library(api))
+		return FALSE;
+
+	printf("Hot reloading %s, rebuild it with `make game` while the game is running.\n", path);
+
+	return TRUE;
+}
+
+/// <summary>
+///		Every GAME_LIBRARY_POLL_MS checks whether the library was rebuilt and if so loads it into api
+/// </summary>
+/// <returns>TRUE if api now points into a new copy of the library</returns>
+int game_library_reload_if_changed(struct game_api* api)
+{
+	if (!library_handle || SDL_GetTicks() - last_poll_ms < GAME_LIBRARY_POLL_MS)
+		return FALSE;
+
+	last_poll_ms = SDL_GetTicks();
+
+	struct file_stamp stamp;
+
+	// it can be missing for a moment while it's replaced
+	if (!get_file_stamp(library_path, &stamp) || memcmp(&stamp, &library_stamp, sizeof(stamp)) == 0)
+		return FALSE;
+
+	// a build that doesn't load isn't tried again until it changes again
+	library_stamp = stamp;
+
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	if (!load_library(api))
+		return FALSE;
+
+	double elapsed_ms = (double)(SDL_GetPerformanceCounter() - start_counter) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+	printf("Reloaded %s in %.1f ms.\n", library_path, elapsed_ms);
+
+	return TRUE;
+}
+
+void game_library_close()
+{
+	if (!library_handle)
+		return;
+
+	SDL_UnloadObject(library_handle);
+	remove(copy_paths[loaded_copy_index]);
+	library_handle = NULL;
+}
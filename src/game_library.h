@@ -0,0 +1,24 @@
+#pragma once
+
+#include "game.h"
+
+/*
+ * #############################################
+ *  GAME LIBRARY (--hot-reload)
+ *  Loads the game layer from the shared library `make game` builds and
+ *  swaps in a new copy whenever that file changes. The library is copied
+ *  before it's loaded so the build is free to replace the real file
+ *  while we're running (Windows won't let anyone write to a DLL that's
+ *  loaded), alternating between two copies so the old code stays loaded
+ *  until the new code has loaded and checked out. A build that fails to
+ *  load, or was built against different structs, is reported and the
+ *  game carries on with the last good one.
+ *
+ *  Only reload between ticks, nothing may be running the old code when
+ *  it's unloaded.
+ * #############################################
+ */
+
+int game_library_open(const char* path, struct game_api* api);
+int game_library_reload_if_changed(struct game_api* api);
+void game_library_close();
@@ -0,0 +1,168 @@
+#include <string.h>
+#include <SDL.h>
+#include "constants.h"
+#include "hud.h"
+#include "baked_assets.h"
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static struct hud_text texts[HUD_TEXTS_NUM];
+
+// Every slot's glyph run back to back, rebuilt only when a slot is laid out again
+static struct hud_glyph slot_glyphs[HUD_TEXTS_NUM][HUD_TEXT_LENGTH_MAX];
+static struct hud_glyph glyph_list[HUD_TEXTS_NUM * HUD_TEXT_LENGTH_MAX];
+static int glyph_list_count;
+static int is_glyph_list_stale = TRUE;
+
+/// <summary>
+///		Finds a character's glyph in a font
+/// </summary>
+/// <returns>FALSE if the font has nothing to draw for it (a space or a digits font letter), it still takes up a cell</returns>
+static int get_glyph_src(int font, char c, SDL_Rect* src)
+{
+	if (font == HUD_FONT_DIGITS)
+	{
+		if (c < '0' || c > '9')
+			return FALSE;
+
+		src->x = baked_num_map_rect.x + ((c - '0') * SCORE_NUM_SPRITE_WIDTH);
+		src->y = baked_num_map_rect.y;
+		src->w = SCORE_NUM_SPRITE_WIDTH;
+		src->h = SCORE_NUM_SPRITE_HEIGHT;
+
+		return TRUE;
+	}
+
+	if (c >= 'a' && c <= 'z')
+		c -= 'a' - 'A';
+
+	int glyph = c - HUD_FONT_FIRST_CHAR;
+
+	if (glyph < 0 || glyph >= HUD_FONT_GLYPHS_NUM)
+		glyph = '?' - HUD_FONT_FIRST_CHAR;
+
+	if (glyph == 0)
+		return FALSE;
+
+	src->x = baked_hud_font_rect.x + ((glyph % HUD_FONT_GLYPHS_PER_ROW) * HUD_FONT_CELL_WIDTH);
+	src->y = baked_hud_font_rect.y + ((glyph / HUD_FONT_GLYPHS_PER_ROW) * HUD_FONT_CELL_HEIGHT);
+	src->w = HUD_FONT_CELL_WIDTH;
+	src->h = HUD_FONT_CELL_HEIGHT;
+
+	return TRUE;
+}
+
+/// <summary>
+///		Lays a slot's string out into its glyph run and works out its bounds
+/// </summary>
+static void layout_text(int index)
+{
+	struct hud_text* text = &texts[index];
+	int advance = text->font == HUD_FONT_DIGITS ? SCORE_NUM_SPRITE_WIDTH : HUD_FONT_CELL_WIDTH;
+	int height = text->font == HUD_FONT_DIGITS ? SCORE_NUM_SPRITE_HEIGHT : HUD_FONT_CELL_HEIGHT;
+	int length = (int)strlen(text->string);
+	int width = length * advance;
+	int x = text->x;
+
+	if (text->align == HUD_ALIGN_RIGHT)
+		x -= width;
+	else if (text->align == HUD_ALIGN_CENTER)
+		x -= width / 2;
+
+	text->num_glyphs = 0;
+
+	for (int i = 0; i < length; i++)
+	{
+		struct hud_glyph* glyph = &slot_glyphs[index][text->num_glyphs];
+
+		if (!get_glyph_src(text->font, text->string[i], &glyph->src))
+			continue;
+
+		glyph->x = x + (i * advance);
+		glyph->y = text->y;
+		text->num_glyphs++;
+	}
+
+	text->bounds.x = x;
+	text->bounds.y = text->y;
+	text->bounds.w = text->num_glyphs > 0 ? width : 0;
+	text->bounds.h = text->num_glyphs > 0 ? height : 0;
+	text->version++;
+
+	is_glyph_list_stale = TRUE;
+}
+
+/// <summary>
+///		Sets what a HUD slot says and where, it's only laid out again if something changed
+/// </summary>
+/// <param name="index">HUD_TEXT_*_INDEX</param>
+/// <param name="font">HUD_FONT_*</param>
+/// <param name="align">HUD_ALIGN_*, which edge of the text x is</param>
+/// <param name="string">Cut off at HUD_TEXT_LENGTH_MAX - 1 characters</param>
+void hud_set_text(int index, int font, int x, int y, int align, const char* string)
+{
+	struct hud_text* text = &texts[index];
+
+	if (text->font == font && text->x == x && text->y == y && text->align == align && strncmp(text->string, string, HUD_TEXT_LENGTH_MAX - 1) == 0)
+		return;
+
+	strncpy(text->string, string, HUD_TEXT_LENGTH_MAX - 1);
+	text->string[HUD_TEXT_LENGTH_MAX - 1] = '\0';
+	text->font = font;
+	text->x = x;
+	text->y = y;
+	text->align = align;
+
+	layout_text(index);
+}
+
+/// <summary>
+///		Hides a HUD slot (it keeps its position, it just has nothing to draw)
+/// </summary>
+void hud_clear_text(int index)
+{
+	const struct hud_text* text = &texts[index];
+	hud_set_text(index, text->font, text->x, text->y, text->align, "");
+}
+
+/// <summary>
+///		Gets a slot with its glyph run, for renderers that track what changed per slot
+/// </summary>
+const struct hud_text* hud_get_text(int index)
+{
+	// the runs point into the flat list
+	hud_get_glyphs(NULL);
+
+	return &texts[index];
+}
+
+/// <summary>
+///		Gets every slot's glyphs as one list so a renderer can draw the whole HUD in one pass
+/// </summary>
+/// <returns>How many glyphs are in the list</returns>
+int hud_get_glyphs(const struct hud_glyph** glyphs)
+{
+	if (is_glyph_list_stale)
+	{
+		glyph_list_count = 0;
+
+		for (int i = 0; i < HUD_TEXTS_NUM; i++)
+		{
+			struct hud_text* text = &texts[i];
+
+			memcpy(&glyph_list[glyph_list_count], slot_glyphs[i], text->num_glyphs * sizeof(struct hud_glyph));
+			text->glyphs = &glyph_list[glyph_list_count];
+			glyph_list_count += text->num_glyphs;
+		}
+
+		is_glyph_list_stale = FALSE;
+	}
+
+	if (glyphs)
+		*glyphs = glyph_list;
+
+	return glyph_list_count;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <SDL.h>
+#include "constants.h"
+
+/*
+ * #############################################
+ *  HUD TEXT
+ *  Scores, the round and timer and the frame stats readout as runs of
+ *  glyphs from the baked atlas (the number map for big digits, the HUD
+ *  font for everything else). Each HUD_TEXT_* slot keeps the run it laid
+ *  out last, so setting the same string every frame costs a compare and
+ *  only a changed string is laid out again. Both renderers draw every
+ *  slot from the one flat glyph list hud_get_glyphs() hands back.
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+
+// One glyph to copy, src is in atlas pixels and x, y in screen pixels (always src.w by src.h)
+struct hud_glyph
+{
+	SDL_Rect src;
+	int x;
+	int y;
+};
+
+struct hud_text
+{
+	char string[HUD_TEXT_LENGTH_MAX];
+	int font;
+	int x;
+	int y;
+	int align; // HUD_ALIGN_*, which edge of the text x is
+	SDL_Rect bounds; // covers every glyph cell, 0 by 0 if there's nothing to draw
+	Uint32 version; // bumped every time the text is laid out again
+	const struct hud_glyph* glyphs; // run in the flat glyph list, valid until the next hud_set_text()
+	int num_glyphs;
+};
+
+void hud_set_text(int index, int font, int x, int y, int align, const char* string);
+void hud_clear_text(int index);
+const struct hud_text* hud_get_text(int index);
+int hud_get_glyphs(const struct hud_glyph** glyphs);
@@ -1,132 +1,140 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <SDL.h>
 #include "constants.h"
+#include "types.h"
+#include "render_hw.h"
+#include "raster.h"
+#include "baked_assets.h"
+#include "hud.h"
+#include "ai.h"
+#include "profiler.h"
+#include "pacing.h"
+#include "render_scale.h"
+#include "replay.h"
+#include "telemetry.h"
+#include "ball_swarm.h"
+#include "particles.h"
+#include "match.h"
+#include "scheduler.h"
+#include "udp.h"
+#include "netplay.h"
+#include "game.h"
+#include "game_library.h"
+#include "triple_buffer.h"
 
 /*
  * #############################################
- *  TYPE DEFS
+ *  GLOBALS
  * #############################################
  */
-struct game_button_state
-{
-	int half_transition_count; // transition as in multiple taps of a button for dash actions
-	int ended_down;
-};
-
-struct game_controller_input
-{
-	int is_connected;
-	int is_analogue; // e.g - true for gamepads, false for keyboards
-
-	// Stick averages used to determine if there
-	// was a trigger on our movement buttons
-	float stick_average_x;
-	float stick_average_y;
-
-	union
-	{
-		struct game_button_state buttons[2]; // array size same as num struct members below (minus terminator)
-
-		struct {
-			struct game_button_state move_up;
-			struct game_button_state move_down;
-
-			// NOTE: All buttons must be added above this line 
-			// (allows to Assert the Buttons array size is equal to num members above terminator)
-			struct game_button_state terminator;
-		};
-	};
-};
-
-struct game_input 
-{
-	struct game_button_state mouse_buttons[5];
-	int mouse_x, mouse_y, mouse_z;
-
-	float dt_for_frame;
-
-	struct game_controller_input controllers[GAME_CONTROLLERS_MAX]; // includes keyboard "controllers"
-};
-
-struct game_screen
-{
-	Uint8 index;
-	Uint8 should_run_game;
-};
 
-struct ball
-{
-	float width;
-	float height;
-	float x;
-	float y;
-	int dx; // movement vector
-	int dy; // movement vector
-};
+// Rendering
+SDL_Window* window = NULL;
+SDL_Renderer* renderer = NULL;
+int window_width = WINDOW_WIDTH; // the game is always WINDOW_WIDTH x WINDOW_HEIGHT, SDL scales it to fit the window
+int window_height = WINDOW_HEIGHT;
+Uint32 renderer_flags = 0; // SDL_RENDERER_SOFTWARE to test without a GPU
+int render_backend = RENDER_BACKEND_SURFACE;
 
-struct paddle
-{
-	float width;
-	float height;
-	float x;
-	float y;
-	int dx; // movement vector
-	int dy; // movement vector
-	int controller_index;
-};
+static SDL_Surface* screen_surface; // a view over the top left of screen_backing_surface at the current render scale
+static SDL_Surface* screen_backing_surface; // big enough for the largest render scale we'll go to
+static SDL_Surface* sprite_atlas; // title, number map, game over and HUD font, baked into the binary at build time
 
-struct score 
-{
-	int points;
-};
+static SDL_Texture* screen_texture;
 
-struct player
-{
-	struct score score;
-};
+// Static layer (everything that doesn't move, only rebuilt when the screen changes), a view like screen_surface
+static SDL_Surface* static_layer_surface;
+static SDL_Surface* static_layer_backing_surface;
+static Uint8 static_layer_screen_index = GAME_SCREEN_NONE_INDEX;
+static int static_layer_points[PADDLES_NUM_MAX];
 
-struct round
-{
-	int round_num;
-	int elapsed_ms;
-	struct player players[PADDLES_NUM_MAX];
-};
+// Dirty rects (what we drew last frame so we only clear, redraw and upload what changed)
+static Uint8 last_rendered_screen_index = GAME_SCREEN_NONE_INDEX;
+static SDL_Rect last_ball_rect;
+static SDL_Rect last_paddle_rects[PADDLES_NUM_MAX];
+static SDL_Rect dirty_rects[DIRTY_RECTS_MAX];
+static int dirty_rects_count;
 
-/*
- * #############################################
- *  GLOBALS
- * #############################################
- */
+// Render scale, what percentage of WINDOW_WIDTH x WINDOW_HEIGHT screen_surface is (the GPU stretches it over the window)
+static struct render_scale_controller render_scale;
+int render_scale_percent_fixed = 0; // --render-scale, 0 lets the controller pick from how long frames take
 
-// Rendering
-SDL_Window* window = NULL;
-SDL_Renderer* renderer = NULL;
+// HUD (where each text was last drawn and which layout that was, a changed text clears its old glyphs)
+static SDL_Rect last_hud_rects[HUD_TEXTS_NUM];
+static Uint32 last_hud_versions[HUD_TEXTS_NUM];
 
-static SDL_Surface* screen_surface;
-static SDL_Surface* title_screen;
-static SDL_Surface* game_screen_num_map;
-static SDL_Surface* game_over_screen;
+// Particles (hit sparks, goal bursts and the ball's trail after a hit, only the surface renderer draws them)
+static struct particle_system particles;
+static SDL_Rect last_particles_rect;
+static int trail_ticks_left;
 
-static SDL_Texture* screen_texture;
+// Frame stats readout, averaged over HUD_FRAME_STATS_REFRESH_MS
+static Uint64 frame_stats_begin_counter;
+static int frame_stats_frames;
 
 // Input
 struct game_input input[2]; // 0 = new input, 1 = old input (last frame)
 struct game_input* new_input = &input[0];
 struct game_input* old_input = &input[1];
-
-// Screen
-struct game_screen current_screen;
-
-// Scoreboard
-struct round current_round;
-
-// Game Objects
-struct paddle paddles[PADDLES_NUM_MAX];
-struct ball ball;
+int is_new_input_pending = FALSE; // TRUE until a simulation tick has consumed new_input
+
+// Input latency (SDL timestamps of input events not on screen yet)
+Uint32 pending_input_timestamps_ms[INPUT_LATENCY_EVENTS_MAX];
+int pending_input_timestamps_count = 0;
+Uint32 input_sequence = 0; // bumped every process_input()
+Uint32 pending_input_sequence = 0; // the process_input() the newest pending event went in with
+
+// The match the window plays
+struct match current_match;
+
+// Drawing only ever reads the match through this (--threaded it's the newest frame the simulation thread published)
+static struct match_frame single_thread_frame;
+static const struct match_frame* rendered_frame = &single_thread_frame;
+
+// Threaded (--threaded, the match runs on its own thread and publishes a frame after every tick)
+int is_threaded = FALSE;
+static SDL_Thread* simulation_thread;
+static SDL_atomic_t is_simulation_thread_running;
+static SDL_mutex* input_lock; // new_input/old_input/input_sequence, the window fills the input in and a tick takes it
+static struct match_frame frame_slots[3];
+static struct triple_buffer frames;
+static const struct ball_swarm no_ball_swarm; // chaos mode is off when threaded
+// Simulation thread side, every event since the last frame we know the window took
+static struct match_event unseen_events[MATCH_FRAME_EVENTS_MAX];
+static int num_unseen_events;
+static Uint32 first_unseen_event_sequence;
+static Uint32 published_event_sequence_end; // one past the last event in the frame published before
+// Window side
+static Uint64 taken_tick;
+static Uint32 next_event_sequence; // the first event it hasn't spawned effects for
+
+// Game layer (the executable's own copy unless --hot-reload swapped in the library's)
+struct game_api game_api;
+
+// AI opponents, a paddle with one is driven by it instead of the keyboard
+struct ai_controller ai_controllers[GAME_CONTROLLERS_MAX];
+int is_ai_controlled[GAME_CONTROLLERS_MAX] = { FALSE };
+int ai_difficulty_level = AI_DIFFICULTY_DEFAULT; // the bots in headless matches play at this too
+
+// Telemetry (--telemetry, hits, goals and ball samples from the window's match go to a ring file)
+static Uint32 telemetry_tick;
+static Uint8 telemetry_screen_index = GAME_SCREEN_NONE_INDEX;
 
 // Misc
 int is_game_running = FALSE;
-int last_frame_time_ms = 0;
+int is_profiler_overlay_visible = FALSE;
+Uint64 last_frame_counter = 0;
+double sim_accumulator_s = 0.0;
+
+// Frame pacing (F3 cycles through the modes)
+int pacing_mode_requested = PACING_MODE_FIXED;
+int target_fps = FPS;
+
+// Headless
+int bot_step_ticks = 1; // 60Hz ticks per simulation step, the ball sweep keeps coarse steps honest
 
 /// <summary>
 ///		Initializes our window and renderer
@@ -143,8 +151,8 @@ int initialize_window()
 		NULL,
 		SDL_WINDOWPOS_CENTERED,
 		SDL_WINDOWPOS_CENTERED,
-		WINDOW_WIDTH,
-		WINDOW_HEIGHT,
+		window_width,
+		window_height,
 		SDL_WINDOW_BORDERLESS
 	);
 
@@ -154,7 +162,7 @@ int initialize_window()
 		return FALSE;
 	}
 
-	renderer = SDL_CreateRenderer(window, -1, 0);
+	renderer = SDL_CreateRenderer(window, -1, renderer_flags);
 
 	if (!renderer)
 	{
@@ -162,6 +170,9 @@ int initialize_window()
 		return FALSE;
 	}
 
+	// everything draws in game pixels, SDL scales (and letterboxes) that to the window
+	SDL_RenderSetLogicalSize(renderer, WINDOW_WIDTH, WINDOW_HEIGHT);
+
 	return TRUE;
 }
 
@@ -180,13 +191,8 @@ void destroy_window()
 /// </summary>
 int init_screen_textures()
 {
-	screen_texture = SDL_CreateTextureFromSurface(renderer, screen_surface);
-
-	// The colour key to mask out on our bitmaps
-	Uint32 colour_key = SDL_MapRGB(title_screen->format, 255, 0, 255);
-	SDL_SetColorKey(title_screen, SDL_TRUE, colour_key);
-	SDL_SetColorKey(game_screen_num_map, SDL_TRUE, colour_key);
-	SDL_SetColorKey(game_over_screen, SDL_TRUE, colour_key);
+	// the render scale only changes how much of it we use
+	screen_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, screen_backing_surface->w, screen_backing_surface->h);
 
 	if (!screen_texture)
 	{
@@ -195,38 +201,107 @@ int init_screen_textures()
 	}
 }
 
+/// <summary>
+///		Wraps the baked sprite atlas in a surface without copying it, unless this CPU's byte order means it isn't in screen_surface's format
+/// </summary>
+SDL_Surface* create_sprite_atlas_surface()
+{
+	// only ever read from, SDL just wants a non-const pointer
+	SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormatFrom((void*)baked_atlas_pixels, baked_atlas_width, baked_atlas_height, 32, baked_atlas_width * sizeof(Uint32), BAKED_ATLAS_FORMAT);
+
+	if (!atlas || atlas->format->format == screen_surface->format->format)
+		return atlas;
+
+	SDL_Surface* converted = SDL_ConvertSurfaceFormat(atlas, screen_surface->format->format, 0);
+	SDL_FreeSurface(atlas);
+
+	return converted;
+}
+
+/// <summary>
+///		The render scale that puts one screen_surface pixel on every window pixel
+/// </summary>
+int get_native_render_scale_percent()
+{
+	int output_width = window_width;
+	int output_height = window_height;
+
+	// on high DPI displays the renderer's output can be bigger than the window says it is
+	SDL_GetRendererOutputSize(renderer, &output_width, &output_height);
+
+	// the smaller side, the other gets letterboxed
+	int percent = SDL_min((output_width * 100) / WINDOW_WIDTH, (output_height * 100) / WINDOW_HEIGHT);
+
+	return SDL_clamp(percent, RENDER_SCALE_PERCENT_MIN, RENDER_SCALE_PERCENT_MAX);
+}
+
+/// <summary>
+///		Points screen_surface and static_layer_surface at the top left of their backing surfaces at the current render scale,
+///		everything gets redrawn at the new size next frame
+/// </summary>
+/// <returns>FALSE if the surfaces couldn't be made, the ones we had are left as they were</returns>
+int apply_render_scale()
+{
+	int width = (WINDOW_WIDTH * render_scale.percent) / 100;
+	int height = (WINDOW_HEIGHT * render_scale.percent) / 100;
+
+	// a surface over someone else's pixels is just a header, nothing is copied
+	SDL_Surface* new_screen_surface = SDL_CreateRGBSurfaceWithFormatFrom(screen_backing_surface->pixels, width, height, 32, screen_backing_surface->pitch, SDL_PIXELFORMAT_RGBA32);
+	SDL_Surface* new_static_layer_surface = SDL_CreateRGBSurfaceWithFormatFrom(static_layer_backing_surface->pixels, width, height, 32, static_layer_backing_surface->pitch, SDL_PIXELFORMAT_RGBA32);
+
+	if (!new_screen_surface || !new_static_layer_surface)
+	{
+		printf("Could not create the %dx%d screen surfaces. SDL Err: %s\n", width, height, SDL_GetError());
+		SDL_FreeSurface(new_screen_surface);
+		SDL_FreeSurface(new_static_layer_surface);
+		return FALSE;
+	}
+
+	SDL_FreeSurface(screen_surface);
+	SDL_FreeSurface(static_layer_surface);
+	screen_surface = new_screen_surface;
+	static_layer_surface = new_static_layer_surface;
+
+	static_layer_screen_index = GAME_SCREEN_NONE_INDEX;
+	last_rendered_screen_index = GAME_SCREEN_NONE_INDEX;
+
+	return TRUE;
+}
+
 /// <summary>
 ///		Initializes the screen bitmap surfaces for sprites like score and screen imagery
 /// </summary>
 int init_screen_surfaces()
 {
+	int max_percent = render_scale_percent_fixed > 0 ? render_scale_percent_fixed : get_native_render_scale_percent();
+	int min_percent = render_scale_percent_fixed > 0 ? render_scale_percent_fixed : RENDER_SCALE_PERCENT_MIN;
+
+	init_render_scale_controller(&render_scale, max_percent, min_percent, max_percent);
+
+	int max_width = (WINDOW_WIDTH * render_scale.max_percent) / 100;
+	int max_height = (WINDOW_HEIGHT * render_scale.max_percent) / 100;
+
 	// Screen surface we'll draw to and then blit with
-	screen_surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+	screen_backing_surface = SDL_CreateRGBSurfaceWithFormat(0, max_width, max_height, 32, SDL_PIXELFORMAT_RGBA32);
 
-	// Title
-	title_screen = SDL_LoadBMP("assets/title_screen.bmp");
+	// Static layer we composite the net and screen bitmaps into, copied over screen_surface as is
+	static_layer_backing_surface = SDL_CreateRGBSurfaceWithFormat(0, max_width, max_height, 32, SDL_PIXELFORMAT_RGBA32);
 
-	if (!title_screen)
+	if (!screen_backing_surface || !static_layer_backing_surface)
 	{
-		printf("Could not load the title_screen.bmp surface. SDL Err: %s\n", SDL_GetError());
+		printf("Could not create the %dx%d screen surfaces. SDL Err: %s\n", max_width, max_height, SDL_GetError());
 		return 1;
 	}
 
-	// Number map
-	game_screen_num_map = SDL_LoadBMP("assets/num_sprite_map.bmp");
-
-	if (!game_screen_num_map)
-	{
-		printf("Could not load the num_sprite_map.bmp surface. SDL Err: %s\n", SDL_GetError());
+	if (!apply_render_scale())
 		return 1;
-	}
 
-	// Game over
-	game_over_screen = SDL_LoadBMP("assets/game_over_screen.bmp");
+	// Title, number map, game over and HUD font sprites
+	sprite_atlas = create_sprite_atlas_surface();
 
-	if (!game_over_screen)
+	if (!sprite_atlas)
 	{
-		printf("Could not load the game_over_screen.bmp surface. SDL Err: %s\n", SDL_GetError());
+		printf("Could not create the sprite atlas surface. SDL Err: %s\n", SDL_GetError());
 		return 1;
 	}
 }
@@ -234,167 +309,150 @@ int init_screen_surfaces()
 void release_assets()
 {
 	SDL_FreeSurface(screen_surface);
-	SDL_FreeSurface(title_screen);
-	SDL_FreeSurface(game_screen_num_map);
-	SDL_FreeSurface(game_over_screen);
-}
+	SDL_FreeSurface(static_layer_surface);
+	SDL_FreeSurface(screen_backing_surface);
+	SDL_FreeSurface(static_layer_backing_surface);
+	SDL_FreeSurface(sprite_atlas);
 
-void init_scoreboard()
-{
-	struct score default_score;
-	default_score.points = SCORE_MIN;
-
-	current_round.elapsed_ms = 0;
-	current_round.players[0].score = current_round.players[1].score = default_score;
-	current_round.round_num = 0;
+	release_hw_renderer();
 }
 
 /// <summary>
-///		Initializes the ball dimensions
+///		Sets up our game objects and any other initial data
 /// </summary>
-void init_ball_dimensions()
+void setup()
 {
-	ball.width = BALL_SIZE;
-	ball.height = BALL_SIZE;
+	init_raster();
+	init_screen_surfaces();
+	init_screen_textures();
+	init_hw_renderer(renderer, sprite_atlas);
+	init_match(&current_match);
+	init_particle_system(&particles, PARTICLES_POOL_SIZE, 1);
 }
 
 /// <summary>
-///		Initializes the ball dimensions
+///		Applies a key press/release to a button, every transition counts even if it's released again in the same frame
 /// </summary>
-void init_ball_positions()
+void process_keyboard_button(struct game_button_state* button, int is_down, Uint32 timestamp_ms)
 {
-	ball.x = BALL_X_DEFAULT;
-	ball.y = BALL_Y_DEFAULT;
-	ball.dx = BALL_DX_DEFAULT;
-	ball.dy = BALL_DY_DEFAULT;
-}
+	if (button->ended_down == is_down)
+		return;
 
-/// <summary>
-///		Initializes the paddle dimensions
-/// </summary>
-void init_paddles_misc()
-{
-	paddles[0].controller_index = 0;
-	paddles[1].controller_index = 1;
+	button->ended_down = is_down;
+	button->half_transition_count++;
+	button->transition_timestamp_ms = timestamp_ms;
 }
 
 /// <summary>
-///		Initializes the paddle dimensions
+///		Moves on to the next frame pacing mode: fixed rate, VSync then unlimited
 /// </summary>
-void init_paddles_dimensions()
+void cycle_pacing_mode()
 {
-	paddles[0].width = PADDLE_WIDTH;
-	paddles[1].width = PADDLE_WIDTH;
-	paddles[0].height = PADDLE_HEIGHT;
-	paddles[1].height = PADDLE_HEIGHT;
-}
+	int mode = pacing_set_mode(window, renderer, (pacing_get_mode() + 1) % PACING_MODES_NUM, target_fps);
 
-/// <summary>
-///		Initializes the paddle positions
-/// </summary>
-void init_paddles_positions()
-{
-	paddles[0].y = paddles[1].y = (WINDOW_HEIGHT / 2) - (PADDLE_HEIGHT / 2);
-	paddles[0].x = PADDLES_X_OFFSET;
-	paddles[1].x = WINDOW_WIDTH - PADDLE_WIDTH - PADDLES_X_OFFSET;
+	if (mode == PACING_MODE_UNLIMITED)
+		printf("Pacing: unlimited\n");
+	else
+		printf("Pacing: %s at %d FPS\n", pacing_mode_name(mode), pacing_get_target_fps());
 }
 
 /// <summary>
-///		Initializes the game
+///		Maps a key to the controller or command button it drives
 /// </summary>
-void init()
+/// <returns>NULL if the key isn't bound to a button</returns>
+struct game_button_state* get_keyboard_button(int scancode)
 {
-	init_screen_surfaces();
-	init_screen_textures();
+	// Controller 0 = w/s
+	// Controller 1 = up/down
+	switch (scancode) {
+		case SDL_SCANCODE_W:
+			return &new_input->controllers[0].move_up;
+
+		case SDL_SCANCODE_S:
+			return &new_input->controllers[0].move_down;
+
+		case SDL_SCANCODE_UP:
+			return &new_input->controllers[1].move_up;
+
+		case SDL_SCANCODE_DOWN:
+			return &new_input->controllers[1].move_down;
 
-	current_screen.index = GAME_SCREEN_TITLE_INDEX;
-	current_screen.should_run_game = GAME_SCREEN_TITLE_RUNS_GAME;
+		case SDL_SCANCODE_SPACE:
+			return &new_input->start;
 
-	init_ball_dimensions();
-	init_ball_positions();
+		case SDL_SCANCODE_F1:
+			return &new_input->reset;
+	}
 
-	init_paddles_misc();
-	init_paddles_dimensions();
-	init_paddles_positions();
+	return NULL;
 }
 
 /// <summary>
-///		Reinitializes the game
+///		A button keeps its held state into the next frame but its transitions start again from 0
 /// </summary>
-void reinit()
+void begin_button_frame(struct game_button_state* new_button, const struct game_button_state* old_button)
 {
-	init_ball_positions();
-	init_paddles_positions();
+	new_button->ended_down = old_button->ended_down;
+	new_button->half_transition_count = 0;
+	new_button->transition_timestamp_ms = old_button->transition_timestamp_ms;
 }
 
 /// <summary>
-///		Sets up our game objects and any other initial data
+///		Starts this frame's input off from where the last input a tick consumed ended up
 /// </summary>
-void setup()
+void begin_input_frame()
 {
-	init();
-}
+	// no simulation tick has seen the input from last frame yet so keep adding to it
+	if (is_new_input_pending)
+		return;
 
-void increment_score(int winning_player_index, int points)
-{
-	struct player* winning_player = &current_round.players[winning_player_index];
-	current_round.round_num += 1;
-	winning_player->score.points += points;
-}
+	for (size_t i = 0; i < GAME_CONTROLLERS_MAX; i++)
+	{
+		const struct game_controller_input* old_controller = &old_input->controllers[i]; // controller input from last frame
+		struct game_controller_input* new_controller = &new_input->controllers[i]; // current
+		new_controller->is_connected = TRUE;
+		new_controller->is_analogue = FALSE;
 
-void reset_score()
-{
-	init_scoreboard();
-}
+		for (size_t button = 0; button < SDL_arraysize(new_controller->buttons); button++)
+			begin_button_frame(&new_controller->buttons[button], &old_controller->buttons[button]);
+	}
 
-/// <summary>
-///		Determines whether the paddle could move to the proposed coordinates within play area bounds
-/// </summary>
-/// <param name="testX"></param>
-/// <param name="testY"></param>
-/// <returns></returns>
-int can_move_paddle(float testX, float testY)
-{
-	if (testX < 0 || testX + PADDLE_WIDTH >= WINDOW_WIDTH ||
-		testY < 0 || testY + PADDLE_HEIGHT >= WINDOW_HEIGHT)
-		return FALSE;
+	begin_button_frame(&new_input->start, &old_input->start);
+	begin_button_frame(&new_input->reset, &old_input->reset);
 
-	return TRUE;
+	is_new_input_pending = TRUE;
 }
 
 /// <summary>
-///		Determines whether the ball could move to the proposed coordinates within play area bounds
+///		Remembers when an input event happened so we can measure how long it took to reach the screen
 /// </summary>
-/// <param name="testX"></param>
-/// <param name="testY"></param>
-/// <returns></returns>
-int can_move_ball(float testX, float testY)
+void track_input_event(Uint32 timestamp_ms)
 {
-	if (testX < 0 || testX + BALL_SIZE >= WINDOW_WIDTH ||
-		testY < 0 || testY + BALL_SIZE >= WINDOW_HEIGHT)
-		return FALSE;
+	if (!profiler_is_enabled() || pending_input_timestamps_count >= INPUT_LATENCY_EVENTS_MAX)
+		return;
 
-	return TRUE;
+	pending_input_timestamps_ms[pending_input_timestamps_count++] = timestamp_ms;
+	pending_input_sequence = input_sequence;
 }
 
 /// <summary>
-///		Determines whether the ball and paddle are touching
+///		Called right after present, every input event a tick has consumed is now on screen
 /// </summary>
-/// <param name="paddle"></param>
-/// <param name="ball"></param>
-/// <returns></returns>
-int are_ball_paddle_touching(struct paddle* paddle, struct ball* ball)
+void record_input_latency()
 {
-	float minX = paddle->x;
-	float maxX = paddle->x + PADDLE_WIDTH;
-	float minY = paddle->y;
-	float maxY = paddle->y + PADDLE_HEIGHT;
+	// threaded, the frame on screen has to be from a tick that had taken the input the events went into
+	int is_input_consumed = is_threaded ? (Sint32)(rendered_frame->input_sequence - pending_input_sequence) >= 0 : !is_new_input_pending;
+
+	if (!is_input_consumed || pending_input_timestamps_count == 0)
+		return;
 
-	if ((ball->x + BALL_SIZE >= minX && ball->x <= maxX) &&
-		(ball->y + BALL_SIZE >= minY && ball->y <= maxY))
-		return TRUE;
+	// SDL event timestamps are in SDL_GetTicks milliseconds so that's our resolution here
+	Uint32 now_ms = SDL_GetTicks();
 
-	return FALSE;
+	for (int i = 0; i < pending_input_timestamps_count; i++)
+		profiler_record_input_latency((double)(now_ms - pending_input_timestamps_ms[i]));
+
+	pending_input_timestamps_count = 0;
 }
 
 /// <summary>
@@ -402,70 +460,77 @@ int are_ball_paddle_touching(struct paddle* paddle, struct ball* ball)
 /// </summary>
 void process_input()
 {
-	SDL_Event event;
-	SDL_PollEvent(&event);
+	begin_input_frame();
+	input_sequence++;
 
-	switch (event.type) {
-		case SDL_QUIT:
-			is_game_running = FALSE;
-			break;
+	// NOTE: credit goes to Casey Muratori for this Handmade Hero input system
+	// I prefer handling capturing the input here and actually updating game objects in update code later for the frame, just feels more self-contained
+	// We drain the whole queue each frame, several events can land in one frame (key repeats, window events)
+	// and every one of them should count this frame rather than trickling in one a frame
+	SDL_Event event;
 
-		case SDL_KEYDOWN: {
-			if (event.key.keysym.sym == SDLK_ESCAPE)
-			{
+	while (SDL_PollEvent(&event))
+	{
+		switch (event.type) {
+			case SDL_QUIT:
 				is_game_running = FALSE;
 				break;
-			}
 
-			if (event.key.keysym.sym == SDLK_SPACE && current_screen.index != GAME_SCREEN_GAME_INDEX)
-			{
-				current_screen.index = GAME_SCREEN_GAME_INDEX;
-				current_screen.should_run_game = TRUE;
+			// some drivers throw away render target contents (e.g. D3D on a device reset)
+			case SDL_RENDER_TARGETS_RESET:
+			case SDL_RENDER_DEVICE_RESET:
+				invalidate_hw_static_layer();
 				break;
-			}
 
-			if (event.key.keysym.sym == SDLK_F1)
-			{
-				reset_score();
-				reinit();
-				current_screen.index = GAME_SCREEN_TITLE_INDEX;
-				current_screen.should_run_game = FALSE;
+			case SDL_KEYUP: {
+				track_input_event(event.key.timestamp);
+
+				struct game_button_state* button = get_keyboard_button(event.key.keysym.scancode);
+
+				if (button)
+					process_keyboard_button(button, FALSE, event.key.timestamp);
+
 				break;
 			}
 
-			// NOTE: currently we only catch the first key pressed
-			// Game object inputs
-			// Controller 0 = a/s
-			// Controller 1 = up/down
-			 
-			// kept in for reference
-			//if (event.key.keysym.sym == SDLK_UP || event.key.keysym.sym == SDLK_w)
-			//{
-			//	struct paddle paddle_for_controller = event.key.keysym.sym == SDLK_UP ? paddles[1] : paddles[0];
-			//	last_input_keydown_sym = event.key.keysym.sym;
-			//	can_move_paddle_to_new_pos = can_move_paddle(paddle_for_controller.x, paddle_for_controller.y - 1);
-			//	break;
-			//}
-		}
-	}
+			case SDL_KEYDOWN: {
+				// repeats aren't transitions, the key was already down
+				if (event.key.repeat)
+					break;
 
-	// NOTE: credit goes to Casey Muratori for this Handmade Hero input system
-	// I prefer handling capturing the input here and actually updating game objects in update code later for the frame, just feels more self-contained
-	// We only support keyboard at the moment so this is dead simple
-	const Uint8* keyboard_state = SDL_GetKeyboardState(NULL);
+				track_input_event(event.key.timestamp);
 
-	for (size_t i = 0; i < GAME_CONTROLLERS_MAX; i++)
-	{
-		struct game_controller_input* old_controller = &old_input->controllers[i]; // controller input from last frame
-		struct game_controller_input* new_controller = &new_input->controllers[i]; // current
-		new_controller->is_analogue = FALSE;
+				struct game_button_state* button = get_keyboard_button(event.key.keysym.scancode);
+
+				if (button)
+				{
+					process_keyboard_button(button, TRUE, event.key.timestamp);
+					break;
+				}
 
-		// If we had tons more buttons we could move this snippet for each button to its own func but this is fine for now
-		new_controller->move_up.ended_down = i == 0 && keyboard_state[SDL_SCANCODE_W] || i == 1 && keyboard_state[SDL_SCANCODE_UP] ? 1 : 0;
-		new_controller->move_up.half_transition_count = old_controller->move_up.ended_down != new_controller->move_up.ended_down ? 1 : 0;
+				if (event.key.keysym.sym == SDLK_ESCAPE)
+				{
+					is_game_running = FALSE;
+					break;
+				}
 
-		new_controller->move_down.ended_down = i == 0 && keyboard_state[SDL_SCANCODE_S] || i == 1 && keyboard_state[SDL_SCANCODE_DOWN] ? 1 : 0;
-		new_controller->move_down.half_transition_count = old_controller->move_down.ended_down != new_controller->move_down.ended_down ? 1 : 0;
+				if (event.key.keysym.sym == SDLK_F3)
+				{
+					cycle_pacing_mode();
+					break;
+				}
+
+				if (event.key.keysym.sym == SDLK_F2)
+				{
+					is_profiler_overlay_visible = !is_profiler_overlay_visible;
+
+					if (is_profiler_overlay_visible)
+						profiler_set_enabled(TRUE);
+
+					break;
+				}
+			}
+		}
 	}
 }
 
@@ -480,383 +545,1499 @@ void retain_input()
 }
 
 /// <summary>
-///		Updates the state of our game objects
+///		Lets the AI press the buttons on the controllers it's driving, off the state the tick is about to run from
 /// </summary>
-void update()
+void apply_ai_input(struct game_input* tick_input)
 {
-	// ####################################
-	//  FRAMERATE ENFORCEMENT
-	// ####################################
-	// todo: better to do this end of update cycle re: handmade hero flow? technically, this should include render time!
-	// sleep the execution until we reach the target frame time in milliseconds
-	int time_to_wait_ms = FRAME_TARGET_TIME_MS - (SDL_GetTicks() - last_frame_time_ms);
-
-	// only call delay if we are too fast to process this frame
-	if (time_to_wait_ms > 0 && time_to_wait_ms <= FRAME_TARGET_TIME_MS)
-		SDL_Delay(time_to_wait_ms);
+	for (int i = 0; i < GAME_CONTROLLERS_MAX; i++)
+	{
+		if (is_ai_controlled[i])
+			game_api.update_ai_controller(&ai_controllers[i], &current_match.ball, &current_match.paddles[i], 1.0f, &tick_input->controllers[i]);
+	}
+}
 
-	// Get a delta time factor converted to seconds to be used to update my objects later
-	float delta_time = (SDL_GetTicks() - last_frame_time_ms) / 1000.0f; // in seconds
-	last_frame_time_ms = SDL_GetTicks();
-	current_round.elapsed_ms += last_frame_time_ms;
+/// <summary>
+///		Runs one fixed simulation tick on tick_input (and logs that input if we're recording)
+/// </summary>
+/// <returns>FALSE if netplay is waiting on the peer and the tick didn't run</returns>
+int simulate_tick(struct game_input* tick_input)
+{
+	// before recording or sending the input, so replays and the peer see what the AI pressed
+	apply_ai_input(tick_input);
 
-	// ####################################
-	//  GAMESCREEN STATE HANDLING
-	// ####################################
-	if (current_screen.index == GAME_SCREEN_TITLE_INDEX || current_screen.index == GAME_SCREEN_GAME_OVER_INDEX)
-		return;
+	if (netplay_is_active())
+		return netplay_tick(&current_match, tick_input);
 
-	// ####################################
-	//  BALL POSITIONING
-	// ####################################
-	int new_ball_x_delta = ball.dx;
-	int new_ball_y_delta = ball.dy;
+	save_match_previous_state(&current_match);
+	tick_input->dt_for_frame = SIM_DT_S;
+	replay_record_tick(tick_input);
+	game_api.update_match(&current_match, tick_input);
 
-	// Move ball by its motion vector
-	ball.x += new_ball_x_delta;
-	ball.y += new_ball_y_delta;
-	
-	// Bounces off the left/right goals (increment score, reset game)
-	if (ball.x < 0 || ball.x > WINDOW_WIDTH - BALL_SIZE) {
-		const struct player* player_zero = &current_round.players[0];
-		const struct player* player_one = &current_round.players[1];
-		int scoring_player_index = ball.x > WINDOW_WIDTH - BALL_SIZE ? 0 : 1;
+	return TRUE;
+}
 
-		increment_score(scoring_player_index, SCORE_POINTS_INCREMENT);
+/// <summary>
+///		Spawns the sparks for the events num_ticks ticks threw up, and keeps the ball's trail going after a hit
+/// </summary>
+void spawn_match_effects(const struct match_event* events, int num_events, const struct ball* ball, Uint8 screen_index, int num_ticks)
+{
+	for (int i = 0; i < num_events; i++)
+	{
+		const struct match_event* event = &events[i];
 
-		// winrar is u?
-		if (player_zero->score.points == SCORE_MAX || player_one->score.points == SCORE_MAX)
+		if (event->type == MATCH_EVENT_PADDLE_HIT)
 		{
-			current_screen.index = GAME_SCREEN_GAME_OVER_INDEX;
-			current_screen.should_run_game = FALSE;
-			return;
+			// fanned out the way the ball went off the paddle
+			struct particle_burst sparks = { event->x, event->y, event->dx * 0.5f, 0.0f, PARTICLES_HIT_SPREAD, 10.0f, 20.0f, PARTICLES_HIT_SPARKS };
+			spawn_particle_burst(&particles, &sparks);
+			trail_ticks_left = PARTICLES_TRAIL_TICKS;
+		}
+		else if (event->type == MATCH_EVENT_GOAL)
+		{
+			// thrown back into the court from where the ball went out, and up a bit so gravity can bring it round
+			struct particle_burst sparks = { event->x, event->y, event->dx * -0.5f, -3.0f, PARTICLES_GOAL_SPREAD, 30.0f, 40.0f, PARTICLES_GOAL_SPARKS };
+			spawn_particle_burst(&particles, &sparks);
+			trail_ticks_left = 0;
 		}
+	}
 
-		reinit();
+	for (int tick = 0; tick < num_ticks && trail_ticks_left > 0 && screen_index == GAME_SCREEN_GAME_INDEX; tick++)
+	{
+		struct particle_burst trail = {
+			ball->x + (BALL_SIZE / 2.0f),
+			ball->y + (BALL_SIZE / 2.0f),
+			0.0f,
+			0.0f,
+			PARTICLES_TRAIL_SPREAD,
+			8.0f,
+			6.0f,
+			PARTICLES_TRAIL_PER_TICK
+		};
+
+		spawn_particle_burst(&particles, &trail);
+		trail_ticks_left--;
 	}
+}
 
-	// Bounces off top/bottom (turn the ball around)
-	if (ball.y < 0 || ball.y > WINDOW_HEIGHT - BALL_SIZE)
-		ball.dy = -ball.dy;
+/// <summary>
+///		Fills in what every telemetry record has. The ball comes from the event if there is one,
+///		after a goal the match has already put it back on its spot.
+/// </summary>
+void fill_telemetry_record(struct telemetry_record* record, int type, const struct match_event* event)
+{
+	const struct match* match = &current_match;
 
-	// ####################################
-	//  PADDLES
-	// ####################################
-	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+	SDL_zerop(record);
+	record->tick = telemetry_tick;
+	record->elapsed_ms = (Uint32)match->round.elapsed_ms;
+	record->type = (Uint8)type;
+	record->round_num = (Uint8)match->round.round_num;
+
+	for (int i = 0; i < PADDLES_NUM_MAX; i++)
+		record->points[i] = (Uint8)match->round.players[i].score.points;
+
+	if (event)
 	{
-		struct paddle* paddle = &paddles[i];
-
-		// ####################################
-		//  HANDLE INPUT UPDATES
-		// ####################################
-		// at the moment just saying we have two keyboard control patterns on the same keyboard
-		const struct game_controller_input* old_controller = &old_input->controllers[i];
-		const struct game_controller_input* new_controller = &new_input->controllers[i];
- 
-		// ####################################
-		//  PADDLE POSITIONING
-		// ####################################
-		int are_ball_paddle_objs_touching = are_ball_paddle_touching(paddle, &ball);
-		int can_move_ball_to_new_pos = !are_ball_paddle_objs_touching && can_move_ball(ball.x + new_ball_x_delta, ball.y + new_ball_y_delta);
-
-		// INPUT UPDATES
-		// Again, if we support more buttons we can make some wee funcs for this but it's fine for now
-		if (new_controller->move_up.ended_down && can_move_paddle(paddle->x, paddle->y - 1))
-			paddle->y += -PADDLE_MOVE_DY;
-
-		if (new_controller->move_down.ended_down && can_move_paddle(paddle->x, paddle->y + 1))
-			paddle->y += PADDLE_MOVE_DY;
-
-		// ####################################
-		//  BALL -> PADDLE COLLISION
-		// ####################################
-		// dx < 0 = moving left
-		// dx > 0 = moving right
-		// dy < 0 = moving up
-		// dy > 0 = moving down
-
-		// NOTE: I knew movement vectors were the answer here but was stuck on implementation
-		// credit goes to https://github.com/flightcrank/pong/blob/master/pong.c for making this click for me
-		if (are_ball_paddle_objs_touching)
-		{
-			// Moving left
-			if (ball.dx < 0)
-				ball.dx -= 1;
-			// Moving right
-			else
-				ball.dx += 1;
+		record->paddle_index = (Uint8)event->paddle_index;
+		record->hit_pos = (Sint16)event->hit_pos;
+		record->ball_x = event->x;
+		record->ball_y = event->y;
+		record->ball_dx = event->dx;
+		record->ball_dy = event->dy;
+	}
+	else
+	{
+		record->ball_x = match->ball.x + (BALL_SIZE / 2.0f);
+		record->ball_y = match->ball.y + (BALL_SIZE / 2.0f);
+		record->ball_dx = (float)match->ball.dx;
+		record->ball_dy = (float)match->ball.dy;
+	}
+}
 
-			// change ball direction
-			ball.dx = -ball.dx;
+/// <summary>
+///		Writes what the last tick did to the telemetry file: matches starting and ending, its events and every so often the ball
+/// </summary>
+void record_match_telemetry()
+{
+	if (!telemetry_is_open())
+		return;
 
-			// change ball angle based on where the paddle hit it
-			int hit_pos = (paddle->y + paddle->height) - ball.y;
+	const struct match* match = &current_match;
+	struct telemetry_record record;
+	int is_screen_changed = match->screen.index != telemetry_screen_index;
 
-			if (hit_pos >= 0 && hit_pos < 7)
-				ball.dy = 4;
+	if (is_screen_changed && match->screen.index == GAME_SCREEN_GAME_INDEX)
+	{
+		fill_telemetry_record(&record, TELEMETRY_RECORD_MATCH_START, NULL);
+		telemetry_write(&record);
+	}
 
-			if (hit_pos >= 7 && hit_pos < 14)
-				ball.dy = 3;
+	for (int i = 0; i < match->num_events; i++)
+	{
+		const struct match_event* event = &match->events[i];
+		fill_telemetry_record(&record, event->type == MATCH_EVENT_GOAL ? TELEMETRY_RECORD_GOAL : TELEMETRY_RECORD_PADDLE_HIT, event);
+		telemetry_write(&record);
+	}
 
-			if (hit_pos >= 14 && hit_pos < 21)
-				ball.dy = 2;
+	if (is_screen_changed && telemetry_screen_index == GAME_SCREEN_GAME_INDEX)
+	{
+		fill_telemetry_record(&record, TELEMETRY_RECORD_MATCH_END, NULL);
+		telemetry_write(&record);
+	}
 
-			if (hit_pos >= 21 && hit_pos < 28)
-				ball.dy = 1;
+	if (match->screen.index == GAME_SCREEN_GAME_INDEX && telemetry_tick % TELEMETRY_SAMPLE_TICKS == 0)
+	{
+		fill_telemetry_record(&record, TELEMETRY_RECORD_BALL_SAMPLE, NULL);
+		telemetry_write(&record);
+	}
 
-			if (hit_pos >= 28 && hit_pos < 32)
-				ball.dy = 0;
+	telemetry_screen_index = match->screen.index;
+	telemetry_tick++;
+}
 
-			if (hit_pos >= 32 && hit_pos < 39)
-				ball.dy = -1;
+/// <summary>
+///		Runs as many fixed simulation ticks as the real time since the last frame has paid for
+/// </summary>
+/// <returns>How far we are between the last two ticks (0 to 1) for render interpolation</returns>
+float run_simulation_ticks()
+{
+	Uint64 now_counter = SDL_GetPerformanceCounter();
+	double frame_time_s = (double)(now_counter - last_frame_counter) / (double)SDL_GetPerformanceFrequency();
+	last_frame_counter = now_counter;
 
-			if (hit_pos >= 39 && hit_pos < 46)
-				ball.dy = -2;
+	// a long stall (window drag, breakpoint) shouldn't make us simulate forever to catch up
+	if (frame_time_s > SIM_MAX_FRAME_TIME_S)
+		frame_time_s = SIM_MAX_FRAME_TIME_S;
 
-			if (hit_pos >= 46 && hit_pos < 53)
-				ball.dy = -3;
+	sim_accumulator_s += frame_time_s;
 
-			if (hit_pos >= 53 && hit_pos <= 60)
-				ball.dy = -4;
+	int ticks_run = 0;
 
-			// NOTE:
-			// if the ball is bouncing into a paddle it can end
-			// up trapped within the paddle geometry
-			// so we ensure it's snapped outside the paddle shape bounds
-			// to avoid a multi-collision bug
+	while (sim_accumulator_s >= SIM_DT_S)
+	{
+		// as of the start of the frame, the ticks a slow frame held up all run late together
+		profiler_record_tick_lateness((sim_accumulator_s - SIM_DT_S) * 1000.0);
 
-			// ball bouncing out to right (left paddle)
-			if (ball.dx > 0 && ball.x <= PADDLES_X_OFFSET)
-				ball.x = PADDLES_X_OFFSET;
+		Uint64 phase_begin = profiler_begin();
+		int is_tick_run = simulate_tick(new_input);
+		profiler_end(PROFILE_PHASE_UPDATE_SIM, phase_begin);
 
-			// ball bouncing out to left (right paddle)
-			if(ball.dx <= 0 && ball.x + BALL_SIZE >= WINDOW_WIDTH - PADDLES_X_OFFSET - PADDLE_WIDTH)
-				ball.x = WINDOW_WIDTH - PADDLES_X_OFFSET - PADDLE_WIDTH - BALL_SIZE;
+		if (is_tick_run)
+		{
+			spawn_match_effects(current_match.events, current_match.num_events, &current_match.ball, current_match.screen.index, 1);
+			record_match_telemetry();
 		}
-	}
-}
 
-void render_title_screen()
-{
-	if (current_screen.index != GAME_SCREEN_TITLE_INDEX)
-		return;
+		sim_accumulator_s -= SIM_DT_S;
+		ticks_run += is_tick_run;
+	}
 
-	SDL_Rect src;
-	SDL_Rect dest;
+	// only hand the input over to the next frame once a tick has consumed it
+	// otherwise we'd lose transitions on frames that render without simulating
+	if (ticks_run > 0)
+	{
+		Uint64 phase_begin = profiler_begin();
+		retain_input();
+		is_new_input_pending = FALSE;
+		profiler_end(PROFILE_PHASE_RETAIN_INPUT, phase_begin);
+	}
 
-	src.x = src.y = 0;
-	src.w = title_screen->w;
-	src.h = title_screen->h;
+	// cosmetic, so they move on the real frame time rather than in whole ticks
+	Uint64 phase_begin = profiler_begin();
+	update_particles(&particles, (float)(frame_time_s * SIM_TICKS_PER_SECOND));
+	profiler_end(PROFILE_PHASE_UPDATE_PARTICLES, phase_begin);
 
-	dest.x = (screen_surface->w / 2) - (src.w / 2);
-	dest.y = (screen_surface->h / 2) - (src.h / 2);
-	dest.w = title_screen->w;
-	dest.h = title_screen->h;
+	capture_match_frame(&current_match, &single_thread_frame);
 
-	SDL_BlitSurface(title_screen, &src, screen_surface, &dest);
+	return (float)(sim_accumulator_s / SIM_DT_S);
 }
 
-void render_ball()
+/// <summary>
+///		Drops the events from the front of unseen_events that come before sequence_end
+/// </summary>
+void forget_seen_events(Uint32 sequence_end)
 {
-	SDL_Rect ball_rect = {
-		(int)ball.x,
-		(int)ball.y,
-		(int)ball.width,
-		(int)ball.height
-	};
+	int num_seen = SDL_clamp((int)(sequence_end - first_unseen_event_sequence), 0, num_unseen_events);
 
-	SDL_FillRect(screen_surface, &ball_rect, 0xFFFFFFFF);
+	num_unseen_events -= num_seen;
+	first_unseen_event_sequence += num_seen;
+	SDL_memmove(unseen_events, unseen_events + num_seen, num_unseen_events * sizeof(struct match_event));
 }
 
-void render_player_zero_paddle()
+/// <summary>
+///		Simulation thread, copies the match out after a tick and hands it to the window through the triple buffer
+/// </summary>
+void publish_match_frame(Uint64 tick, Uint64 tick_due_counter, Uint32 tick_input_sequence)
 {
-	SDL_Rect player_zero_paddle_rect = {
-		(int)paddles[0].x,
-		(int)paddles[0].y,
-		(int)paddles[0].width,
-		(int)paddles[0].height,
-	};
+	// the window only ever gets the newest frame, so every frame carries all the events it might not have seen yet
+	for (int i = 0; i < current_match.num_events; i++)
+	{
+		// it's stalled for a good while, it can do without the oldest sparks
+		if (num_unseen_events == MATCH_FRAME_EVENTS_MAX)
+			forget_seen_events(first_unseen_event_sequence + 1);
 
-	SDL_FillRect(screen_surface, &player_zero_paddle_rect, 0xFFFFFFFF);
-}
+		unseen_events[num_unseen_events++] = current_match.events[i];
+	}
 
-void render_player_one_paddle()
-{
-	SDL_Rect player_one_paddle_rect = {
-		(int)paddles[1].x,
-		(int)paddles[1].y,
-		(int)paddles[1].width,
-		(int)paddles[1].height,
-	};
+	struct match_frame* frame = triple_buffer_get_back(&frames);
+	capture_match_frame(&current_match, frame);
+	frame->ball_swarm = &no_ball_swarm;
+	frame->tick = tick;
+	frame->tick_due_counter = tick_due_counter;
+	frame->input_sequence = tick_input_sequence;
+	frame->first_event_sequence = first_unseen_event_sequence;
+	frame->num_events = num_unseen_events;
+	SDL_memcpy(frame->events, unseen_events, num_unseen_events * sizeof(struct match_event));
 
-	SDL_FillRect(screen_surface, &player_one_paddle_rect, 0xFFFFFFFF);
-}
+	Uint32 event_sequence_end = first_unseen_event_sequence + (Uint32)num_unseen_events;
 
-void render_net()
-{
-	int num_dashes_and_gaps = (NET_NUM_DASHES * 2);
+	// the window took the frame before this one, so it's had every event up to the end of that
+	if (triple_buffer_publish(&frames))
+		forget_seen_events(published_event_sequence_end);
 
-	SDL_Rect net_dash;
-	net_dash.w = NET_DASH_WIDTH;
-	net_dash.h = screen_surface->h / num_dashes_and_gaps;
-	net_dash.x = screen_surface->w / 2;
-	net_dash.y = net_dash.h;
+	published_event_sequence_end = event_sequence_end;
+}
 
-	int dash_offset = net_dash.h * 2;
+/// <summary>
+///		--threaded, runs the match at SIM_TICKS_PER_SECOND on its own so a slow render or present can't hold a tick up.
+///		Takes whatever input the window has filled in at each tick and publishes a frame after it.
+/// </summary>
+int run_simulation_thread(void* data)
+{
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 anchor_counter = SDL_GetPerformanceCounter();
+	Uint64 num_anchor_ticks = 0;
+	Uint64 tick = 0;
 
-	for (size_t i = 0; i < NET_NUM_DASHES; i++)
+	while (SDL_AtomicGet(&is_simulation_thread_running))
 	{
-		SDL_FillRect(screen_surface, &net_dash, 0xFFFFFFFF);
-		net_dash.y += dash_offset;
-	}
-}
+		// counted from the anchor each time so the tick rate doesn't drift
+		Uint64 tick_due_counter = anchor_counter + ((num_anchor_ticks * frequency) / SIM_TICKS_PER_SECOND);
+		Uint64 now_counter = SDL_GetPerformanceCounter();
 
-void render_player_zero_score() 
-{
-	const struct score* score = &current_round.players[0].score;
+		// no spinning, up to a millisecond late is fine as the window interpolates from when the tick was due
+		if (now_counter < tick_due_counter)
+		{
+			SDL_Delay(1);
+			continue;
+		}
 
-	SDL_Rect src;
-	SDL_Rect dest;
+		// a long stall (breakpoint, a reload) shouldn't make us simulate forever to catch up
+		if ((double)(now_counter - tick_due_counter) / (double)frequency > SIM_MAX_FRAME_TIME_S)
+		{
+			anchor_counter = tick_due_counter = now_counter;
+			num_anchor_ticks = 0;
+		}
+
+		profiler_record_tick_lateness((double)(now_counter - tick_due_counter) * 1000.0 / (double)frequency);
 
-	src.x = src.y = 0;
-	src.w = SCORE_NUM_SPRITE_WIDTH;
-	src.h = SCORE_NUM_SPRITE_WIDTH;
+		// between ticks, so nothing is part way through the old code
+		game_library_reload_if_changed(&game_api);
 
-	dest.x = (screen_surface->w / 2) - src.w - SCORE_NUM_SPRITE_PADDING;
-	dest.y = 0;
-	dest.w = SCORE_NUM_SPRITE_WIDTH;
-	dest.h = SCORE_NUM_SPRITE_HEIGHT;
+		// the same hand over run_simulation_ticks does, a tick takes everything the window has added since the last one
+		struct game_input tick_input;
+		SDL_LockMutex(input_lock);
+		begin_input_frame();
+		tick_input = *new_input;
+		Uint32 tick_input_sequence = input_sequence;
+		retain_input();
+		is_new_input_pending = FALSE;
+		SDL_UnlockMutex(input_lock);
 
-	// A score higher than NINE, are you insane!?
-	if (score->points > SCORE_MIN && score->points < SCORE_MAX + 1)
-		src.x += src.w * score->points;
+		simulate_tick(&tick_input);
+		record_match_telemetry();
+		publish_match_frame(++tick, tick_due_counter, tick_input_sequence);
+		num_anchor_ticks++;
+	}
 
-	SDL_BlitSurface(game_screen_num_map, &src, screen_surface, &dest);
+	return 0;
 }
 
-void render_player_one_score()
+int start_simulation_thread()
 {
-	const struct score* score = &current_round.players[1].score;
+	input_lock = SDL_CreateMutex();
 
-	SDL_Rect src;
-	SDL_Rect dest;
+	if (!input_lock)
+	{
+		printf("Could not create the input lock. SDL Err: %s\n", SDL_GetError());
+		return FALSE;
+	}
 
-	src.x = src.y = 0;
-	src.w = SCORE_NUM_SPRITE_WIDTH;
-	src.h = SCORE_NUM_SPRITE_WIDTH;
+	init_triple_buffer(&frames, &frame_slots[0], &frame_slots[1], &frame_slots[2]);
 
-	dest.x = (screen_surface->w / 2) + SCORE_NUM_SPRITE_PADDING - (SCORE_NUM_SPRITE_PADDING / 2);
-	dest.y = 0;
-	dest.w = SCORE_NUM_SPRITE_WIDTH;
-	dest.h = SCORE_NUM_SPRITE_HEIGHT;
+	// drawn until the first tick's frame turns up
+	capture_match_frame(&current_match, &single_thread_frame);
+	single_thread_frame.ball_swarm = &no_ball_swarm;
 
-	// A score higher than NINE, are you insane!?
-	if (score->points > SCORE_MIN && score->points < SCORE_MAX + 1)
-		src.x += src.w * score->points;
+	SDL_AtomicSet(&is_simulation_thread_running, TRUE);
+	simulation_thread = SDL_CreateThread(run_simulation_thread, "pong simulation", NULL);
 
-	SDL_BlitSurface(game_screen_num_map, &src, screen_surface, &dest);
-}
+	if (!simulation_thread)
+	{
+		printf("Could not start the simulation thread. SDL Err: %s\n", SDL_GetError());
+		SDL_DestroyMutex(input_lock);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+void stop_simulation_thread()
+{
+	SDL_AtomicSet(&is_simulation_thread_running, FALSE);
+	SDL_WaitThread(simulation_thread, NULL);
+	SDL_DestroyMutex(input_lock);
+	simulation_thread = NULL;
+	input_lock = NULL;
+}
+
+/// <summary>
+///		--threaded, picks up the newest frame the simulation thread has published (if there's a newer one) and
+///		starts the effects off for anything that's happened since the last one
+/// </summary>
+/// <returns>How far we are from the frame's tick to the next one (0 to 1) for render interpolation</returns>
+float take_simulation_frame()
+{
+	Uint64 now_counter = SDL_GetPerformanceCounter();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	double frame_time_s = SDL_min((double)(now_counter - last_frame_counter) / (double)frequency, SIM_MAX_FRAME_TIME_S);
+	last_frame_counter = now_counter;
+
+	if (triple_buffer_acquire(&frames))
+	{
+		const struct match_frame* frame = triple_buffer_get_front(&frames);
+
+		// an earlier frame could have had some of them already
+		int num_seen = SDL_clamp((int)(next_event_sequence - frame->first_event_sequence), 0, frame->num_events);
+
+		spawn_match_effects(frame->events + num_seen, frame->num_events - num_seen, &frame->ball, frame->screen.index, (int)(frame->tick - taken_tick));
+		next_event_sequence = frame->first_event_sequence + (Uint32)frame->num_events;
+		taken_tick = frame->tick;
+		rendered_frame = frame;
+	}
+
+	Uint64 phase_begin = profiler_begin();
+	update_particles(&particles, (float)(frame_time_s * SIM_TICKS_PER_SECOND));
+	profiler_end(PROFILE_PHASE_UPDATE_PARTICLES, phase_begin);
+
+	// past 1 if the next tick is late, we hold on the newest one rather than guess ahead
+	double alpha = (double)(Sint64)(now_counter - rendered_frame->tick_due_counter) / ((double)frequency * SIM_DT_S);
+
+	return (float)SDL_clamp(alpha, 0.0, 1.0);
+}
+
+/// <summary>
+///		Game pixels to screen_surface pixels, rounding down (towards -infinity, the ball can be off the left edge)
+/// </summary>
+int to_render_coordinate(int value)
+{
+	int scaled = value * render_scale.percent;
+	return (scaled >= 0 ? scaled : scaled - 99) / 100;
+}
+
+/// <summary>
+///		Maps a rect in game pixels to screen_surface at the current render scale. Both edges round the same way so
+///		rects that tile in game pixels still tile, and a rect always maps to the same pixels (the dirty rects rely on that).
+/// </summary>
+SDL_Rect to_render_rect(SDL_Rect rect)
+{
+	if (render_scale.percent == 100)
+		return rect;
+
+	int min_x = to_render_coordinate(rect.x);
+	int min_y = to_render_coordinate(rect.y);
+	SDL_Rect render_rect = {
+		min_x,
+		min_y,
+		SDL_max(to_render_coordinate(rect.x + rect.w) - min_x, 1),
+		SDL_max(to_render_coordinate(rect.y + rect.h) - min_y, 1)
+	};
+
+	return render_rect;
+}
+
+void render_title_screen(SDL_Surface* target)
+{
+	SDL_Rect src = baked_title_rect;
+	SDL_Rect dest;
+
+	dest.x = (WINDOW_WIDTH / 2) - (src.w / 2);
+	dest.y = (WINDOW_HEIGHT / 2) - (src.h / 2);
+	dest.w = src.w;
+	dest.h = src.h;
+
+	dest = to_render_rect(dest);
+	raster_copy_scaled(sprite_atlas, &src, target, &dest);
+}
+
+/// <returns>The ball's pixels on screen_surface</returns>
+SDL_Rect get_ball_rect(const struct ball* ball)
+{
+	SDL_Rect ball_rect = {
+		(int)ball->x,
+		(int)ball->y,
+		(int)ball->width,
+		(int)ball->height
+	};
+
+	return to_render_rect(ball_rect);
+}
+
+/// <returns>The paddle's pixels on screen_surface</returns>
+SDL_Rect get_paddle_rect(const struct paddle* paddle)
+{
+	SDL_Rect paddle_rect = {
+		(int)paddle->x,
+		(int)paddle->y,
+		(int)paddle->width,
+		(int)paddle->height,
+	};
+
+	return to_render_rect(paddle_rect);
+}
+
+void render_ball(const struct ball* ball)
+{
+	SDL_Rect ball_rect = get_ball_rect(ball);
+
+	raster_fill_rect(screen_surface, &ball_rect, 0xFFFFFFFF);
+}
+
+/// <summary>
+///		Draws the chaos mode balls where the last tick left them (they aren't interpolated)
+/// </summary>
+void render_ball_swarm(const struct ball_swarm* swarm)
+{
+	for (int i = 0; i < swarm->count; i++)
+	{
+		SDL_Rect ball_rect = { (int)swarm->x[i], (int)swarm->y[i], BALL_SIZE, BALL_SIZE };
+		ball_rect = to_render_rect(ball_rect);
+		raster_fill_rect(screen_surface, &ball_rect, 0xFFFFFFFF);
+	}
+}
+
+void render_player_zero_paddle(const struct paddle* paddle)
+{
+	SDL_Rect player_zero_paddle_rect = get_paddle_rect(paddle);
+
+	raster_fill_rect(screen_surface, &player_zero_paddle_rect, 0xFFFFFFFF);
+}
 
-void render_scores()
+void render_player_one_paddle(const struct paddle* paddle)
 {
-	render_player_zero_score();
-	render_player_one_score();
+	SDL_Rect player_one_paddle_rect = get_paddle_rect(paddle);
+
+	raster_fill_rect(screen_surface, &player_one_paddle_rect, 0xFFFFFFFF);
 }
 
-void render_game_screen()
+void render_net(SDL_Surface* target)
 {
-	// Game objects & play field
-	render_ball();
-	render_player_zero_paddle();
-	render_player_one_paddle();
-	render_net();
+	int num_dashes_and_gaps = (NET_NUM_DASHES * 2);
+
+	SDL_Rect net_dash;
+	net_dash.w = NET_DASH_WIDTH;
+	net_dash.h = WINDOW_HEIGHT / num_dashes_and_gaps;
+	net_dash.x = WINDOW_WIDTH / 2;
+	net_dash.y = net_dash.h;
+
+	int dash_offset = net_dash.h * 2;
 
-	// Scores/timer etc.
-	render_scores();
+	for (size_t i = 0; i < NET_NUM_DASHES; i++)
+	{
+		SDL_Rect render_dash = to_render_rect(net_dash);
+		raster_fill_rect(target, &render_dash, 0xFFFFFFFF);
+		net_dash.y += dash_offset;
+	}
 }
 
-void render_game_over_screen()
+/// <summary>
+///		Refreshes the frame rate, frame time and jitter readout, it's shown with the profiler overlay
+/// </summary>
+void update_frame_stats_text()
 {
-	if (current_screen.index != GAME_SCREEN_GAME_OVER_INDEX)
+	Uint64 now_counter = SDL_GetPerformanceCounter();
+	frame_stats_frames++;
+
+	if (!is_profiler_overlay_visible || frame_stats_begin_counter == 0)
+	{
+		hud_clear_text(HUD_TEXT_FRAME_STATS_INDEX);
+		frame_stats_begin_counter = now_counter;
+		frame_stats_frames = 0;
+		return;
+	}
+
+	double window_ms = (double)(now_counter - frame_stats_begin_counter) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+	if (window_ms < HUD_FRAME_STATS_REFRESH_MS)
 		return;
 
+	// jitter is over the pacing's sample window, a good few seconds of frames
+	struct pacing_stats pacing_stats;
+	pacing_compute_stats(&pacing_stats);
+
+	char string[HUD_TEXT_LENGTH_MAX];
+	int length = snprintf(string, sizeof(string), "%d FPS %.2f+-%.2f MS", (int)((frame_stats_frames * 1000.0 / window_ms) + 0.5), window_ms / frame_stats_frames, pacing_stats.jitter_ms);
+
+	// the software renderer's resolution, the hardware one always draws at the window's
+	if (render_backend == RENDER_BACKEND_SURFACE && length > 0 && length < (int)sizeof(string))
+		snprintf(string + length, sizeof(string) - length, " %d%%", render_scale.percent);
+	hud_set_text(HUD_TEXT_FRAME_STATS_INDEX, HUD_FONT_SMALL, WINDOW_WIDTH - HUD_MARGIN, HUD_MARGIN, HUD_ALIGN_RIGHT, string);
+
+	frame_stats_begin_counter = now_counter;
+	frame_stats_frames = 0;
+}
+
+/// <summary>
+///		Sets the HUD text for the current screen, a string that hasn't changed keeps last frame's glyph run
+/// </summary>
+void update_hud()
+{
+	const struct round* round = &rendered_frame->round;
+	char string[HUD_TEXT_LENGTH_MAX];
+
+	if (rendered_frame->screen.index == GAME_SCREEN_GAME_INDEX)
+	{
+		int elapsed_s = round->elapsed_ms / 1000;
+
+		// player zero's score grows left from the net and player one's grows right
+		snprintf(string, sizeof(string), "%d", round->players[0].score.points);
+		hud_set_text(HUD_TEXT_SCORE_0_INDEX, HUD_FONT_DIGITS, (WINDOW_WIDTH / 2) - SCORE_NUM_SPRITE_PADDING, 0, HUD_ALIGN_RIGHT, string);
+
+		snprintf(string, sizeof(string), "%d", round->players[1].score.points);
+		hud_set_text(HUD_TEXT_SCORE_1_INDEX, HUD_FONT_DIGITS, (WINDOW_WIDTH / 2) + SCORE_NUM_SPRITE_PADDING - (SCORE_NUM_SPRITE_PADDING / 2), 0, HUD_ALIGN_LEFT, string);
+
+		snprintf(string, sizeof(string), "ROUND %d", round->round_num + 1);
+		hud_set_text(HUD_TEXT_ROUND_INDEX, HUD_FONT_SMALL, HUD_MARGIN, HUD_MARGIN, HUD_ALIGN_LEFT, string);
+
+		snprintf(string, sizeof(string), "%d:%02d", elapsed_s / 60, elapsed_s % 60);
+		hud_set_text(HUD_TEXT_TIMER_INDEX, HUD_FONT_SMALL, HUD_MARGIN, HUD_MARGIN + HUD_FONT_CELL_HEIGHT, HUD_ALIGN_LEFT, string);
+	}
+	else
+	{
+		hud_clear_text(HUD_TEXT_SCORE_0_INDEX);
+		hud_clear_text(HUD_TEXT_SCORE_1_INDEX);
+		hud_clear_text(HUD_TEXT_ROUND_INDEX);
+		hud_clear_text(HUD_TEXT_TIMER_INDEX);
+	}
+
+	update_frame_stats_text();
+}
+
+void render_game_over_screen(SDL_Surface* target)
+{
 	// simple enough to assume if we're rendering this we've got a clear winner
-	const struct player* player_zero = &current_round.players[0];
-	const struct player* player_one = &current_round.players[1];
+	const struct player* player_zero = &rendered_frame->round.players[0];
+	const struct player* player_one = &rendered_frame->round.players[1];
 	const int winning_player_index = player_zero->score.points > player_one->score.points ? 0 : 1;
 
 	SDL_Rect player_zero_msg;
 	SDL_Rect player_one_msg;
 	SDL_Rect dest;
 
-	player_zero_msg.x = player_zero_msg.y = player_one_msg.x = 0;
-	player_zero_msg.w = player_one_msg.w = game_over_screen->w;
+	player_zero_msg.x = player_one_msg.x = baked_game_over_rect.x;
+	player_zero_msg.y = player_one_msg.y = baked_game_over_rect.y;
+	player_zero_msg.w = player_one_msg.w = baked_game_over_rect.w;
 	player_zero_msg.h = player_one_msg.h = GAME_SCREEN_GAME_OVER_MSG_HEIGHT;
 
-	player_one_msg.y = GAME_SCREEN_GAME_OVER_MSG_OFFSET;
+	player_one_msg.y += GAME_SCREEN_GAME_OVER_MSG_OFFSET;
 
-	dest.x = (screen_surface->w / 2) - (game_over_screen->w / 2);
-	dest.y = (screen_surface->h / 2) - (GAME_SCREEN_GAME_OVER_MSG_HEIGHT / 2);
-	dest.w = game_over_screen->w;
-	dest.h = game_over_screen->h;
+	dest.x = (WINDOW_WIDTH / 2) - (baked_game_over_rect.w / 2);
+	dest.y = (WINDOW_HEIGHT / 2) - (GAME_SCREEN_GAME_OVER_MSG_HEIGHT / 2);
+	dest.w = baked_game_over_rect.w;
+	dest.h = GAME_SCREEN_GAME_OVER_MSG_HEIGHT;
+
+	dest = to_render_rect(dest);
 	
 	// switch if we add more like AI
 	if (winning_player_index == 0)
 	{
-		SDL_BlitSurface(game_over_screen, &player_zero_msg, screen_surface, &dest);
+		raster_copy_scaled(sprite_atlas, &player_zero_msg, target, &dest);
 		return;
 	}
 
-	SDL_BlitSurface(game_over_screen, &player_one_msg, screen_surface, &dest);
+	raster_copy_scaled(sprite_atlas, &player_one_msg, target, &dest);
 }
 
 /// <summary>
-///		Renders our game screens
+///		Composites everything that doesn't move on the current screen into the static layer
 /// </summary>
-void render()
+void build_static_layer()
 {
-	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-	SDL_FillRect(screen_surface, NULL, 0x00000000);
-	SDL_RenderClear(renderer);
+	raster_fill_rect(static_layer_surface, NULL, 0x00000000);
 
-	switch (current_screen.index) {
-		case GAME_SCREEN_TITLE_INDEX: 
-			render_title_screen();
+	switch (rendered_frame->screen.index) {
+		case GAME_SCREEN_TITLE_INDEX:
+			render_title_screen(static_layer_surface);
 			break;
 
 		case GAME_SCREEN_GAME_INDEX:
-			render_game_screen();
+			render_net(static_layer_surface);
 			break;
 
 		case GAME_SCREEN_GAME_OVER_INDEX:
-			render_game_over_screen();
+			render_game_over_screen(static_layer_surface);
 			break;
 	}
 
-	SDL_UpdateTexture(screen_texture, NULL, screen_surface->pixels, screen_surface->w * sizeof(Uint32));
-	SDL_RenderCopy(renderer, screen_texture, NULL, NULL);
+	static_layer_screen_index = rendered_frame->screen.index;
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		static_layer_points[i] = rendered_frame->round.players[i].score.points;
+}
+
+/// <summary>
+///		Rebuilds the static layer if the screen has changed since it was built
+/// </summary>
+/// <returns>TRUE if the layer was rebuilt</returns>
+int refresh_static_layer()
+{
+	int is_stale = static_layer_screen_index != rendered_frame->screen.index;
+
+	// the game over screen says who won, nothing else in the layer depends on the score
+	if (rendered_frame->screen.index == GAME_SCREEN_GAME_OVER_INDEX)
+	{
+		for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+			is_stale |= static_layer_points[i] != rendered_frame->round.players[i].score.points;
+	}
+
+	if (!is_stale)
+		return FALSE;
+
+	build_static_layer();
+	return TRUE;
+}
+
+/// <summary>
+///		Copies a rect of the static layer over screen_surface (NULL for all of it)
+/// </summary>
+void restore_static_layer(const SDL_Rect* rect)
+{
+	SDL_Rect src = rect ? *rect : static_layer_surface->clip_rect;
+	raster_copy(static_layer_surface, &src, screen_surface, src.x, src.y);
+}
+
+/// <summary>
+///		Copies whatever's drawn in a rect of the static layer over screen_surface, leaving the rest of the rect as it is
+/// </summary>
+void overlay_static_layer(const SDL_Rect* rect)
+{
+	raster_blit_keyed(static_layer_surface, rect, screen_surface, rect->x, rect->y, 0x00000000);
+}
+
+/// <summary>
+///		Linear interpolation from a to b by t (0 to 1)
+/// </summary>
+float lerp(float a, float b, float t)
+{
+	return a + (b - a) * t;
+}
+
+/// <summary>
+///		Blends the last two simulation ticks so motion is smooth whatever the display rate
+/// </summary>
+void interpolate_game_objects(float alpha, struct ball* interpolated_ball, struct paddle* interpolated_paddles)
+{
+	const struct match_frame* frame = rendered_frame;
+
+	*interpolated_ball = frame->ball;
+	interpolated_ball->x = lerp(frame->previous_ball.x, frame->ball.x, alpha);
+	interpolated_ball->y = lerp(frame->previous_ball.y, frame->ball.y, alpha);
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+	{
+		interpolated_paddles[i] = frame->paddles[i];
+		interpolated_paddles[i].x = lerp(frame->previous_paddles[i].x, frame->paddles[i].x, alpha);
+		interpolated_paddles[i].y = lerp(frame->previous_paddles[i].y, frame->paddles[i].y, alpha);
+	}
+}
+
+/// <summary>
+///		Draws the ball and paddles and remembers where so the next frame knows which pixels are stale
+/// </summary>
+void render_game_objects(const struct ball* rendered_ball, const struct paddle* rendered_paddles)
+{
+	render_ball(rendered_ball);
+	render_player_zero_paddle(&rendered_paddles[0]);
+	render_player_one_paddle(&rendered_paddles[1]);
+
+	last_ball_rect = get_ball_rect(rendered_ball);
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		last_paddle_rects[i] = get_paddle_rect(&rendered_paddles[i]);
+
+	// the net has always been drawn over the ball and paddles
+	overlay_static_layer(&last_ball_rect);
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		overlay_static_layer(&last_paddle_rects[i]);
+}
+
+/// <summary>
+///		Where the live particles are in screen_surface pixels, empty if there aren't any
+/// </summary>
+SDL_Rect get_particles_rect()
+{
+	SDL_Rect empty_rect = { 0, 0, 0, 0 };
+	return SDL_RectEmpty(&particles.bounds) ? empty_rect : to_render_rect(particles.bounds);
+}
+
+/// <summary>
+///		Draws the particles in one pass over screen_surface and remembers where for the next frame's dirty rects
+/// </summary>
+void render_particle_effects()
+{
+	render_particles(&particles, screen_surface, render_scale.percent);
+	last_particles_rect = get_particles_rect();
+}
+
+/// <summary>
+///		Adds a rect to this frame's dirty list, merging it into any dirty rect it overlaps
+/// </summary>
+void add_dirty_rect(SDL_Rect rect)
+{
+	SDL_Rect screen_rect = { 0, 0, screen_surface->w, screen_surface->h };
+	SDL_Rect clipped_rect;
+
+	if (!SDL_IntersectRect(&rect, &screen_rect, &clipped_rect))
+		return;
+
+	for (int i = 0; i < dirty_rects_count; i++)
+	{
+		if (SDL_HasIntersection(&dirty_rects[i], &clipped_rect))
+		{
+			SDL_UnionRect(&dirty_rects[i], &clipped_rect, &dirty_rects[i]);
+			return;
+		}
+	}
+
+	if (dirty_rects_count < DIRTY_RECTS_MAX)
+	{
+		dirty_rects[dirty_rects_count++] = clipped_rect;
+		return;
+	}
+
+	// out of slots, grow the last one instead
+	SDL_UnionRect(&dirty_rects[dirty_rects_count - 1], &clipped_rect, &dirty_rects[dirty_rects_count - 1]);
+}
+
+/// <summary>
+///		Marks where every HUD text that's changed since it was last drawn was and now is
+/// </summary>
+void add_hud_dirty_rects()
+{
+	for (int i = 0; i < HUD_TEXTS_NUM; i++)
+	{
+		const struct hud_text* text = hud_get_text(i);
+
+		if (text->version == last_hud_versions[i])
+			continue;
+
+		add_dirty_rect(last_hud_rects[i]);
+		add_dirty_rect(to_render_rect(text->bounds));
+	}
+}
+
+/// <summary>
+///		Copies the HUD glyphs into screen_surface, only the texts this frame's dirty rects touch unless it's a full redraw
+/// </summary>
+void render_hud(int is_full_redraw)
+{
+	for (int i = 0; i < HUD_TEXTS_NUM; i++)
+	{
+		const struct hud_text* text = hud_get_text(i);
+		SDL_Rect bounds = to_render_rect(text->bounds);
+		int is_touched = is_full_redraw;
+
+		// outside the dirty rects a text that hasn't changed would just copy over its own pixels
+		for (int r = 0; r < dirty_rects_count && !is_touched; r++)
+			is_touched = SDL_HasIntersection(&dirty_rects[r], &bounds);
+
+		for (int g = 0; g < text->num_glyphs && is_touched; g++)
+		{
+			const struct hud_glyph* glyph = &text->glyphs[g];
+			SDL_Rect dest = { glyph->x, glyph->y, glyph->src.w, glyph->src.h };
+
+			dest = to_render_rect(dest);
+			raster_copy_scaled(sprite_atlas, &glyph->src, screen_surface, &dest);
+		}
+
+		last_hud_rects[i] = bounds;
+		last_hud_versions[i] = text->version;
+	}
+}
+
+/// <summary>
+///		Redraws only what moved or changed since last frame, the rest of screen_surface is left as is
+/// </summary>
+void render_screen_dirty(float alpha)
+{
+	int is_game_screen = rendered_frame->screen.index == GAME_SCREEN_GAME_INDEX;
+	struct ball interpolated_ball;
+	struct paddle interpolated_paddles[PADDLES_NUM_MAX];
+
+	dirty_rects_count = 0;
+
+	// old and new bounding boxes of everything that moves
+	if (is_game_screen)
+	{
+		interpolate_game_objects(alpha, &interpolated_ball, interpolated_paddles);
+
+		add_dirty_rect(last_ball_rect);
+		add_dirty_rect(get_ball_rect(&interpolated_ball));
+
+		for (int i = 0; i < PADDLES_NUM_MAX; i++)
+		{
+			add_dirty_rect(last_paddle_rects[i]);
+			add_dirty_rect(get_paddle_rect(&interpolated_paddles[i]));
+		}
+	}
+
+	// particles keep going on every screen (a winning goal's burst plays out over the game over screen)
+	add_dirty_rect(last_particles_rect);
+	add_dirty_rect(get_particles_rect());
+
+	// a goal, the timer ticking over or a new frame stats reading
+	add_hud_dirty_rects();
+
+	// the static layer has the net already in it, we just paint the HUD and moving bits on top
+	for (int i = 0; i < dirty_rects_count; i++)
+		restore_static_layer(&dirty_rects[i]);
+
+	render_hud(FALSE);
+	render_particle_effects();
+
+	if (is_game_screen)
+		render_game_objects(&interpolated_ball, interpolated_paddles);
+}
+
+/// <summary>
+///		Uploads just the dirty rects of screen_surface to screen_texture
+/// </summary>
+void upload_dirty_rects()
+{
+	for (int i = 0; i < dirty_rects_count; i++)
+	{
+		const SDL_Rect* rect = &dirty_rects[i];
+		const Uint8* pixels = (const Uint8*)screen_surface->pixels + (rect->y * screen_surface->pitch) + (rect->x * sizeof(Uint32));
+		SDL_UpdateTexture(screen_texture, rect, pixels, screen_surface->pitch);
+	}
+}
+
+/// <summary>
+///		Renders into screen_surface on the CPU and copies it up as one texture
+/// </summary>
+void render_surface_frame(float alpha)
+{
+	Uint64 render_begin_counter = SDL_GetPerformanceCounter();
+	Uint64 phase_begin = profiler_begin();
+	dirty_rects_count = 0;
+
+	// a swarm touches most of the screen anyway, not worth tracking dirty rects for
+	if (rendered_frame->ball_swarm->count > 0 && rendered_frame->screen.index == GAME_SCREEN_GAME_INDEX)
+		last_rendered_screen_index = GAME_SCREEN_NONE_INDEX;
+
+	// After a screen change we copy the static layer over once, from then on a frame
+	// only touches its dirty rects (whatever moved and any HUD text that changed)
+	if (rendered_frame->screen.index != last_rendered_screen_index)
+	{
+		refresh_static_layer();
+		restore_static_layer(NULL);
+		render_hud(TRUE);
+		render_particle_effects();
+
+		if (rendered_frame->screen.index == GAME_SCREEN_GAME_INDEX)
+		{
+			struct ball interpolated_ball;
+			struct paddle interpolated_paddles[PADDLES_NUM_MAX];
+			interpolate_game_objects(alpha, &interpolated_ball, interpolated_paddles);
+
+			render_game_objects(&interpolated_ball, interpolated_paddles);
+			render_ball_swarm(rendered_frame->ball_swarm);
+		}
+
+		last_rendered_screen_index = rendered_frame->screen.index;
+
+		// the whole screen is one big dirty rect
+		add_dirty_rect(screen_surface->clip_rect);
+	}
+	else
+	{
+		render_screen_dirty(alpha);
+	}
+
+	profiler_end(PROFILE_PHASE_RENDER_DRAW, phase_begin);
+
+	phase_begin = profiler_begin();
+	upload_dirty_rects();
+	SDL_RenderCopy(renderer, screen_texture, &screen_surface->clip_rect, NULL);
+	profiler_end(PROFILE_PHASE_RENDER_UPLOAD, phase_begin);
+
+	// only what the render scale changes the cost of, present is at the window's size whatever we do
+	double render_ms = (double)(SDL_GetPerformanceCounter() - render_begin_counter) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+	int previous_percent = render_scale.percent;
+
+	// if the new size can't be had we carry on at the old one, the surfaces still match it
+	if (update_render_scale_controller(&render_scale, render_ms, pacing_get_frame_budget_ms()) && !apply_render_scale())
+		init_render_scale_controller(&render_scale, previous_percent, render_scale.min_percent, render_scale.max_percent);
+}
+
+/// <summary>
+///		Renders our game screens
+/// </summary>
+/// <param name="alpha">How far we are between the last two simulation ticks (0 to 1)</param>
+void render(float alpha)
+{
+	update_hud();
+
+	Uint64 phase_begin = profiler_begin();
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+	SDL_RenderClear(renderer);
+	profiler_end(PROFILE_PHASE_RENDER_CLEAR, phase_begin);
+
+	if (render_backend == RENDER_BACKEND_HW)
+	{
+		phase_begin = profiler_begin();
+
+		struct ball interpolated_ball;
+		struct paddle interpolated_paddles[PADDLES_NUM_MAX];
+		interpolate_game_objects(alpha, &interpolated_ball, interpolated_paddles);
+
+		const struct hud_glyph* hud_glyphs;
+		int num_hud_glyphs = hud_get_glyphs(&hud_glyphs);
+
+		render_hw_frame(renderer, &rendered_frame->screen, &rendered_frame->round, &interpolated_ball, interpolated_paddles, rendered_frame->ball_swarm, hud_glyphs, num_hud_glyphs);
+		profiler_end(PROFILE_PHASE_RENDER_DRAW, phase_begin);
+	}
+	else
+	{
+		render_surface_frame(alpha);
+	}
+
+	if (is_profiler_overlay_visible)
+		profiler_render_overlay(renderer, pacing_get_frame_budget_ms());
 
 	// swap the backbuffer with the current front buffer
+	phase_begin = profiler_begin();
 	SDL_RenderPresent(renderer);
+	profiler_end(PROFILE_PHASE_RENDER_PRESENT, phase_begin);
+
+	record_input_latency();
+}
+
+int compare_doubles(const void* a, const void* b)
+{
+	double lhs = *(const double*)a;
+	double rhs = *(const double*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+/// <summary>
+///		Times render() for each backend over the same bot match so we can compare frame times
+/// </summary>
+/// <param name="num_frames"></param>
+void run_render_bench(int num_frames)
+{
+	static double samples_ms[RENDER_BENCH_FRAMES_MAX];
+	const char* backend_names[] = { "surface", "hardware" };
+	SDL_RendererInfo renderer_info;
+
+	if (num_frames > RENDER_BENCH_FRAMES_MAX)
+		num_frames = RENDER_BENCH_FRAMES_MAX;
+
+	if (num_frames <= 0)
+		return;
+
+	SDL_GetRendererInfo(renderer, &renderer_info);
+	printf("Render bench: %d frames per backend on the '%s' SDL renderer\n", num_frames, renderer_info.name);
+
+	for (int backend = RENDER_BACKEND_SURFACE; backend <= RENDER_BACKEND_HW; backend++)
+	{
+		render_backend = backend;
+		init_bot_match(&current_match, 1, 1, get_ai_difficulty(AI_DIFFICULTY_DEFAULT));
+		start_bot_match(&current_match);
+		last_rendered_screen_index = GAME_SCREEN_NONE_INDEX;
+
+		double total_ms = 0.0;
+
+		for (int frame = 0; frame < num_frames; frame++)
+		{
+			step_bot_match(&current_match);
+
+			if (current_match.screen.index != GAME_SCREEN_GAME_INDEX)
+				start_bot_match(&current_match);
+
+			Uint64 start_counter = SDL_GetPerformanceCounter();
+			capture_match_frame(&current_match, &single_thread_frame);
+			render(0.5f);
+			samples_ms[frame] = (double)(SDL_GetPerformanceCounter() - start_counter) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+			total_ms += samples_ms[frame];
+		}
+
+		qsort(samples_ms, num_frames, sizeof(double), compare_doubles);
+		printf("  %-8s avg %.3f ms, p50 %.3f ms, p99 %.3f ms\n",
+			backend_names[backend],
+			total_ms / num_frames,
+			samples_ms[num_frames / 2],
+			samples_ms[(num_frames * 99) / 100]);
+	}
+}
+
+/// <summary>
+///		Scheduler job, one step of each running headless match in [begin, end)
+/// </summary>
+void step_headless_matches(int begin, int end, void* user_data)
+{
+	struct match** running_matches = user_data;
+
+	for (int i = begin; i < end; i++)
+		step_bot_match(running_matches[i]);
+}
+
+/// <summary>
+///		Plays bot vs bot matches as fast as the CPU allows, no window, rendering or frame pacing.
+///		Every match is in flight at once and each pass steps all of them across the scheduler's threads.
+/// </summary>
+/// <param name="num_matches"></param>
+/// <param name="num_chaos_balls">Swarm size for each match, 0 for none</param>
+/// <param name="seed"></param>
+void run_headless(int num_matches, int num_chaos_balls, Uint32 seed)
+{
+	int wins[PADDLES_NUM_MAX] = { 0 };
+	int unfinished_matches = 0;
+	Uint64 total_frames = 0;
+	Uint32 results_hash = 2166136261u;
+
+	num_matches = SDL_max(num_matches, 0);
+
+	struct match* matches = SDL_calloc(SDL_max(num_matches, 1), sizeof(struct match));
+	struct match** running_matches = SDL_malloc(SDL_max(num_matches, 1) * sizeof(struct match*));
+
+	if (!matches || !running_matches)
+	{
+		printf("Could not allocate %d headless matches.\n", num_matches);
+		SDL_free(matches);
+		SDL_free(running_matches);
+		return;
+	}
+
+	for (int i = 0; i < num_matches; i++)
+	{
+		// every match has its own seed so the results don't depend on which thread stepped what
+		Uint32 match_seed = seed + ((Uint32)i * HEADLESS_SEED_STRIDE);
+		init_bot_match(&matches[i], match_seed, bot_step_ticks, get_ai_difficulty(ai_difficulty_level));
+
+		if (num_chaos_balls > 0)
+			init_match_ball_swarm(&matches[i], num_chaos_balls, match_seed);
+
+		start_bot_match(&matches[i]);
+		running_matches[i] = &matches[i];
+	}
+
+	int num_running = num_matches;
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	while (num_running > 0)
+	{
+		scheduler_parallel_for(num_running, HEADLESS_MATCHES_PER_JOB, step_headless_matches, running_matches);
+
+		// finished matches drop out so the next pass only hands out live ones
+		int num_still_running = 0;
+
+		for (int i = 0; i < num_running; i++)
+		{
+			if (is_bot_match_running(running_matches[i]))
+				running_matches[num_still_running++] = running_matches[i];
+		}
+
+		num_running = num_still_running;
+	}
+
+	double elapsed_s = (double)(SDL_GetPerformanceCounter() - start_counter) / (double)SDL_GetPerformanceFrequency();
+
+	if (elapsed_s <= 0.0)
+		elapsed_s = 1e-9;
+
+	for (int i = 0; i < num_matches; i++)
+	{
+		const struct match* match = &matches[i];
+		struct game_snapshot final_state;
+		capture_match_snapshot(match, &final_state);
+		results_hash = (results_hash ^ replay_hash_snapshot(&final_state)) * 16777619u;
+
+		total_frames += (Uint64)match->bot_num_steps * bot_step_ticks;
+
+		if (match->screen.index != GAME_SCREEN_GAME_OVER_INDEX)
+		{
+			unfinished_matches++;
+			continue;
+		}
+
+		wins[match->round.players[0].score.points > match->round.players[1].score.points ? 0 : 1]++;
+	}
+
+	printf("Headless: %d matches (%d unfinished) in %.3f s\n", num_matches, unfinished_matches, elapsed_s);
+	printf("  wins: player 0 = %d, player 1 = %d\n", wins[0], wins[1]);
+	printf("  results: %08x (the same whatever the thread count)\n", results_hash);
+	printf("  threads: %d, %llu ranges stolen\n", scheduler_get_num_threads(), (unsigned long long)scheduler_get_num_steals());
+	printf("  step: %d tick(s), %.1f steps/sec\n", bot_step_ticks, (total_frames / bot_step_ticks) / elapsed_s);
+	printf("  simulated frames: %llu (%.1f per match)\n", (unsigned long long)total_frames, num_matches ? (double)total_frames / num_matches : 0.0);
+	printf("  matches/sec: %.1f\n", num_matches / elapsed_s);
+	printf("  simulated frames/sec: %.1f\n", total_frames / elapsed_s);
+
+	for (int i = 0; i < num_matches; i++)
+		release_match(&matches[i]);
+
+	SDL_free(matches);
+	SDL_free(running_matches);
+}
+
+/// <summary>
+///		Plays a recorded input log back through update_match() as fast as we can go, optionally drawing every tick
+/// </summary>
+/// <returns>FALSE if the replay couldn't be loaded or didn't end up where the recording did</returns>
+int run_replay(const char* path, int should_render)
+{
+	struct game_snapshot snapshot;
+
+	if (!replay_open(path, &snapshot))
+		return FALSE;
+
+	restore_match_snapshot(&current_match, &snapshot);
+	SDL_zero(input);
+	is_new_input_pending = FALSE;
+
+	Uint64 num_ticks = 0;
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+
+	while (replay_read_tick(new_input))
+	{
+		save_match_previous_state(&current_match);
+		update_match(&current_match, new_input);
+		retain_input();
+		record_match_telemetry();
+		num_ticks++;
+
+		if (should_render)
+		{
+			spawn_match_effects(current_match.events, current_match.num_events, &current_match.ball, current_match.screen.index, 1);
+			update_particles(&particles, 1.0f);
+			capture_match_frame(&current_match, &single_thread_frame);
+			SDL_PumpEvents();
+			render(1.0f);
+		}
+	}
+
+	double elapsed_s = (double)(SDL_GetPerformanceCounter() - start_counter) / (double)SDL_GetPerformanceFrequency();
+
+	if (elapsed_s <= 0.0)
+		elapsed_s = 1e-9;
+
+	replay_close();
+	capture_match_snapshot(&current_match, &snapshot);
+
+	int final_state_check = replay_check_final_state(&snapshot);
+
+	printf("Replay: %llu ticks (%.1f s of play) in %.3f s\n", (unsigned long long)num_ticks, (double)num_ticks * SIM_DT_S, elapsed_s);
+	printf("  ticks/sec: %.1f%s\n", num_ticks / elapsed_s, should_render ? " (rendered)" : "");
+	printf("  final score: %d - %d\n", current_match.round.players[0].score.points, current_match.round.players[1].score.points);
+	printf("  final state: %08x (%s)\n", replay_hash_snapshot(&snapshot),
+		final_state_check < 0 ? "recording was not finished, nothing to check against" : final_state_check ? "matches the recording" : "DIVERGED from the recording");
+
+	return final_state_check != FALSE;
 }
 
 int main(int argc, char* args[])
 {
+	int is_headless = FALSE;
+	int num_matches = HEADLESS_MATCHES_DEFAULT;
+	int render_bench_frames = 0;
+	const char* trace_path = NULL;
+	const char* record_path = NULL;
+	const char* telemetry_path = NULL;
+	const char* replay_path = NULL;
+	int should_render_replay = FALSE;
+	int num_chaos_balls = 0;
+	int num_threads = 0;
+	int netplay_player_index = -1;
+	int netplay_port = -1;
+	int netplay_peer_port = -1;
+	int net_latency_ms = 0;
+	int net_jitter_ms = 0;
+	int net_loss_percent = 0;
+	int should_hot_reload = FALSE;
+	Uint32 seed = 1;
+
+	get_game_api(&game_api);
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(args[i], "--headless") == 0)
+			is_headless = TRUE;
+		else if (strcmp(args[i], "--matches") == 0 && i + 1 < argc)
+			num_matches = atoi(args[++i]);
+		else if (strcmp(args[i], "--threads") == 0 && i + 1 < argc)
+			num_threads = atoi(args[++i]);
+		else if (strcmp(args[i], "--step-ticks") == 0 && i + 1 < argc)
+			bot_step_ticks = atoi(args[++i]);
+		else if (strcmp(args[i], "--seed") == 0 && i + 1 < argc)
+			seed = (Uint32)strtoul(args[++i], NULL, 10);
+		else if (strcmp(args[i], "--renderer") == 0 && i + 1 < argc)
+			render_backend = strcmp(args[++i], "hw") == 0 ? RENDER_BACKEND_HW : RENDER_BACKEND_SURFACE;
+		else if (strcmp(args[i], "--window") == 0 && i + 1 < argc)
+		{
+			if (sscanf(args[++i], "%dx%d", &window_width, &window_height) != 2 || window_width < 1 || window_height < 1)
+			{
+				printf("--window wants a size like 1600x1200, using %dx%d.\n", WINDOW_WIDTH, WINDOW_HEIGHT);
+				window_width = WINDOW_WIDTH;
+				window_height = WINDOW_HEIGHT;
+			}
+		}
+		else if (strcmp(args[i], "--render-scale") == 0 && i + 1 < argc)
+		{
+			// "auto" (or anything that isn't a number) leaves it to the controller
+			render_scale_percent_fixed = atoi(args[++i]);
+
+			if (render_scale_percent_fixed > 0)
+				render_scale_percent_fixed = SDL_clamp(render_scale_percent_fixed, RENDER_SCALE_PERCENT_MIN, RENDER_SCALE_PERCENT_MAX);
+		}
+		else if (strcmp(args[i], "--software-renderer") == 0)
+			renderer_flags |= SDL_RENDERER_SOFTWARE;
+		else if (strcmp(args[i], "--render-bench") == 0 && i + 1 < argc)
+			render_bench_frames = atoi(args[++i]);
+		else if (strcmp(args[i], "--fps") == 0 && i + 1 < argc)
+		{
+			target_fps = atoi(args[++i]);
+			pacing_mode_requested = target_fps > 0 ? PACING_MODE_FIXED : PACING_MODE_UNLIMITED;
+		}
+		else if (strcmp(args[i], "--vsync") == 0)
+			pacing_mode_requested = PACING_MODE_VSYNC;
+		else if (strcmp(args[i], "--profile") == 0)
+			is_profiler_overlay_visible = TRUE;
+		else if (strcmp(args[i], "--trace") == 0 && i + 1 < argc)
+			trace_path = args[++i];
+		else if (strcmp(args[i], "--record") == 0 && i + 1 < argc)
+			record_path = args[++i];
+		else if (strcmp(args[i], "--replay") == 0 && i + 1 < argc)
+			replay_path = args[++i];
+		else if (strcmp(args[i], "--telemetry") == 0 && i + 1 < argc)
+			telemetry_path = args[++i];
+		else if (strcmp(args[i], "--replay-render") == 0)
+			should_render_replay = TRUE;
+		else if (strcmp(args[i], "--chaos") == 0 && i + 1 < argc)
+			num_chaos_balls = atoi(args[++i]);
+		else if (strcmp(args[i], "--netplay") == 0 && i + 1 < argc)
+			netplay_player_index = atoi(args[++i]) ? 1 : 0;
+		else if (strcmp(args[i], "--net-port") == 0 && i + 1 < argc)
+			netplay_port = atoi(args[++i]);
+		else if (strcmp(args[i], "--net-peer-port") == 0 && i + 1 < argc)
+			netplay_peer_port = atoi(args[++i]);
+		else if (strcmp(args[i], "--net-latency") == 0 && i + 1 < argc)
+			net_latency_ms = atoi(args[++i]);
+		else if (strcmp(args[i], "--net-jitter") == 0 && i + 1 < argc)
+			net_jitter_ms = atoi(args[++i]);
+		else if (strcmp(args[i], "--net-loss") == 0 && i + 1 < argc)
+			net_loss_percent = atoi(args[++i]);
+		else if (strcmp(args[i], "--threaded") == 0)
+			is_threaded = TRUE;
+		else if (strcmp(args[i], "--hot-reload") == 0)
+			should_hot_reload = TRUE;
+		else if (strcmp(args[i], "--ai") == 0 && i + 1 < argc)
+			is_ai_controlled[atoi(args[++i]) ? 1 : 0] = TRUE;
+		else if (strcmp(args[i], "--ai-difficulty") == 0 && i + 1 < argc)
+		{
+			ai_difficulty_level = find_ai_difficulty(args[++i]);
+
+			if (ai_difficulty_level < 0)
+			{
+				printf("Unknown AI difficulty %s (easy, normal or hard), playing normal.\n", args[i]);
+				ai_difficulty_level = AI_DIFFICULTY_DEFAULT;
+			}
+		}
+	}
+
+	for (int i = 0; i < GAME_CONTROLLERS_MAX; i++)
+		init_ai_controller(&ai_controllers[i], get_ai_difficulty(ai_difficulty_level), seed + ((Uint32)i * HEADLESS_SEED_STRIDE));
+
+	if (is_profiler_overlay_visible || trace_path)
+		profiler_set_enabled(TRUE);
+
+	if (bot_step_ticks < 1)
+		bot_step_ticks = 1;
+
+	if (is_headless)
+	{
+		if (!init_scheduler(num_threads))
+			return 1;
+
+		run_headless(num_matches, num_chaos_balls, seed);
+		release_scheduler();
+		return 0;
+	}
+
+	// netplay waits on the peer inside a tick and rolls back from the window's thread
+	if (is_threaded && netplay_player_index >= 0)
+		printf("Threaded mode is off for netplay.\n");
+
+	is_threaded = is_threaded && netplay_player_index < 0 && !replay_path;
+
+	// netplay only rolls back what's in a game_snapshot, the swarm isn't so it would drift apart
+	if (num_chaos_balls > 0 && netplay_player_index >= 0)
+		printf("Chaos mode is off for netplay.\n");
+	// the window would be drawing the swarm while the simulation thread moves it
+	else if (num_chaos_balls > 0 && is_threaded)
+		printf("Chaos mode is off for threaded mode.\n");
+	else if (num_chaos_balls > 0)
+		init_match_ball_swarm(&current_match, num_chaos_balls, seed);
+
+	// a replay can be played back through it too, to get the numbers for a match after the fact
+	if (telemetry_path && !telemetry_open(telemetry_path, TELEMETRY_CAPACITY_DEFAULT))
+		return 1;
+
+	// no window unless we want to watch (or benchmark the renderer on) the replay
+	if (replay_path && !should_render_replay)
+	{
+		int is_replay_ok = run_replay(replay_path, FALSE);
+		telemetry_close();
+		return is_replay_ok ? 0 : 1;
+	}
+
 	is_game_running = initialize_window();
 	setup();
 
+	if (replay_path)
+	{
+		int is_replay_ok = is_game_running && run_replay(replay_path, TRUE);
+
+		if (profiler_is_enabled())
+			profiler_print_stats();
+
+		telemetry_close();
+		release_assets();
+		release_match(&current_match);
+		destroy_window();
+
+		return is_replay_ok ? 0 : 1;
+	}
+
+	// the peer would be running different code to us
+	if (should_hot_reload && netplay_player_index >= 0)
+		printf("Hot reloading is off for netplay.\n");
+	else if (is_game_running && should_hot_reload)
+	{
+		is_game_running = game_library_open(GAME_LIBRARY_PATH, &game_api);
+
+		// the log would only play back on the code it was recorded with
+		if (record_path)
+			printf("Recording is off while hot reloading.\n");
+
+		record_path = NULL;
+	}
+
+	if (is_game_running && netplay_player_index >= 0)
+	{
+		Uint16 port = (Uint16)(netplay_port >= 0 ? netplay_port : NETPLAY_PORT_DEFAULT + netplay_player_index);
+		Uint16 peer_port = (Uint16)(netplay_peer_port >= 0 ? netplay_peer_port : NETPLAY_PORT_DEFAULT + 1 - netplay_player_index);
+
+		udp_set_conditions(net_latency_ms, net_jitter_ms, net_loss_percent, seed + netplay_player_index);
+		is_game_running = netplay_start(netplay_player_index, port, peer_port);
+
+		// the log would have our guesses at the peer's input in it, not what they really pressed
+		if (record_path)
+			printf("Recording is off for netplay.\n");
+
+		record_path = NULL;
+	}
+
+	if (is_game_running && record_path)
+	{
+		struct game_snapshot initial_state;
+		capture_match_snapshot(&current_match, &initial_state);
+		replay_begin_recording(record_path, &initial_state);
+	}
+
+	if (is_game_running && render_bench_frames > 0)
+	{
+		run_render_bench(render_bench_frames);
+		is_game_running = FALSE;
+	}
+
+	if (is_game_running)
+		pacing_set_mode(window, renderer, pacing_mode_requested, target_fps);
+
+	if (is_game_running && is_threaded)
+		is_game_running = start_simulation_thread();
+
+	last_frame_counter = SDL_GetPerformanceCounter();
+
 	while (is_game_running)
 	{
+		Uint64 frame_begin = profiler_begin();
+
+		// between frames, so no tick is part way through the old code (threaded, the simulation thread does it between ticks)
+		if (!is_threaded)
+			game_library_reload_if_changed(&game_api);
+
 		//check for new events every frame
+		Uint64 phase_begin = profiler_begin();
 		SDL_PumpEvents();
+		profiler_end(PROFILE_PHASE_PUMP_EVENTS, phase_begin);
+
+		phase_begin = profiler_begin();
+
+		if (is_threaded)
+			SDL_LockMutex(input_lock);
 
 		process_input();
-		update();
-		retain_input();
-		render();
+
+		if (is_threaded)
+			SDL_UnlockMutex(input_lock);
+
+		profiler_end(PROFILE_PHASE_PROCESS_INPUT, phase_begin);
+
+		float alpha = is_threaded ? take_simulation_frame() : run_simulation_ticks();
+		render(alpha);
+
+		// after present so the render time counts towards the frame
+		phase_begin = profiler_begin();
+		pacing_wait_for_next_frame();
+		profiler_end(PROFILE_PHASE_UPDATE_PACING, phase_begin);
+
+		profiler_end(PROFILE_PHASE_FRAME, frame_begin);
 	}
 
+	// before anything it might still be using goes
+	if (simulation_thread)
+		stop_simulation_thread();
+
+	if (replay_is_recording())
+	{
+		struct game_snapshot final_state;
+		capture_match_snapshot(&current_match, &final_state);
+		replay_end_recording(&final_state);
+	}
+
+	if (netplay_is_active())
+	{
+		netplay_print_stats();
+		netplay_stop();
+	}
+
+	if (profiler_is_enabled())
+	{
+		profiler_print_stats();
+		pacing_print_stats();
+	}
+
+	if (trace_path)
+		profiler_write_chrome_trace(trace_path);
+
+	telemetry_close();
+	game_library_close();
+
 	release_assets();
+	release_match(&current_match);
+	release_particle_system(&particles);
 	destroy_window();
 
 	return 0;
@@ -0,0 +1,687 @@
+#include <stdio.h>
+#include <math.h>
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+#include "match.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+
+// What the broadphase visitor needs to bounce a swarm ball off one paddle
+struct swarm_paddle_query
+{
+	struct match* match;
+	const struct paddle* paddle;
+};
+
+static void init_scoreboard(struct match* match)
+{
+	struct score default_score;
+	default_score.points = SCORE_MIN;
+
+	match->round.elapsed_ms = 0;
+	match->round.players[0].score = match->round.players[1].score = default_score;
+	match->round.round_num = 0;
+}
+
+/// <summary>
+///		Initializes the ball dimensions
+/// </summary>
+static void init_ball_dimensions(struct match* match)
+{
+	match->ball.width = BALL_SIZE;
+	match->ball.height = BALL_SIZE;
+}
+
+/// <summary>
+///		Initializes the ball dimensions
+/// </summary>
+static void init_ball_positions(struct match* match)
+{
+	match->ball.x = BALL_X_DEFAULT;
+	match->ball.y = BALL_Y_DEFAULT;
+	match->ball.dx = BALL_DX_DEFAULT;
+	match->ball.dy = BALL_DY_DEFAULT;
+}
+
+/// <summary>
+///		Initializes the paddle dimensions
+/// </summary>
+static void init_paddles_misc(struct match* match)
+{
+	match->paddles[0].controller_index = 0;
+	match->paddles[1].controller_index = 1;
+}
+
+/// <summary>
+///		Initializes the paddle dimensions
+/// </summary>
+static void init_paddles_dimensions(struct match* match)
+{
+	match->paddles[0].width = PADDLE_WIDTH;
+	match->paddles[1].width = PADDLE_WIDTH;
+	match->paddles[0].height = PADDLE_HEIGHT;
+	match->paddles[1].height = PADDLE_HEIGHT;
+}
+
+/// <summary>
+///		Initializes the paddle positions
+/// </summary>
+static void init_paddles_positions(struct match* match)
+{
+	match->paddles[0].y = match->paddles[1].y = (WINDOW_HEIGHT / 2) - (PADDLE_HEIGHT / 2);
+	match->paddles[0].x = PADDLES_X_OFFSET;
+	match->paddles[1].x = WINDOW_WIDTH - PADDLE_WIDTH - PADDLES_X_OFFSET;
+}
+
+/// <summary>
+///		Initializes the game, the chaos mode swarm (if any) is left alone
+/// </summary>
+void init_match(struct match* match)
+{
+	match->screen.index = GAME_SCREEN_TITLE_INDEX;
+	match->screen.should_run_game = GAME_SCREEN_TITLE_RUNS_GAME;
+
+	init_scoreboard(match);
+
+	init_ball_dimensions(match);
+	init_ball_positions(match);
+
+	init_paddles_misc(match);
+	init_paddles_dimensions(match);
+	init_paddles_positions(match);
+
+	save_match_previous_state(match);
+}
+
+/// <summary>
+///		Initializes a match for the bots to play, the same seed plays out the same way
+/// </summary>
+void init_bot_match(struct match* match, Uint32 seed, int step_ticks, const struct ai_difficulty* difficulty)
+{
+	init_match(match);
+	SDL_zero(match->bot_input);
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		init_ai_controller(&match->bots[i], difficulty, seed + ((Uint32)i * HEADLESS_SEED_STRIDE));
+
+	match->bot_step_ticks = SDL_max(step_ticks, 1);
+	match->bot_num_steps = 0;
+}
+
+/// <summary>
+///		Gives the match a chaos mode swarm of num_balls
+/// </summary>
+int init_match_ball_swarm(struct match* match, int num_balls, Uint32 seed)
+{
+	num_balls = SDL_min(num_balls, BALL_SWARM_MAX);
+
+	if (!init_ball_swarm(&match->ball_swarm, num_balls) || !init_broadphase_grid(&match->ball_swarm_grid, match->ball_swarm.capacity))
+	{
+		release_match(match);
+		return FALSE;
+	}
+
+	spawn_ball_swarm(&match->ball_swarm, num_balls, seed);
+
+	return TRUE;
+}
+
+void release_match(struct match* match)
+{
+	release_ball_swarm(&match->ball_swarm);
+	release_broadphase_grid(&match->ball_swarm_grid);
+}
+
+/// <summary>
+///		Keeps a copy of the game objects before a simulation tick so render can interpolate from them
+/// </summary>
+void save_match_previous_state(struct match* match)
+{
+	match->previous_ball = match->ball;
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		match->previous_paddles[i] = match->paddles[i];
+}
+
+/// <summary>
+///		Reinitializes the game
+/// </summary>
+static void reinit_match(struct match* match)
+{
+	init_ball_positions(match);
+	init_paddles_positions(match);
+
+	// don't interpolate across a reset or the ball streaks across the screen
+	save_match_previous_state(match);
+}
+
+/// <summary>
+///		Copies out everything the simulation touches
+/// </summary>
+void capture_match_snapshot(const struct match* match, struct game_snapshot* snapshot)
+{
+	// zero first so struct padding is the same every time (snapshots get hashed)
+	SDL_zerop(snapshot);
+	snapshot->screen = match->screen;
+	snapshot->round = match->round;
+	snapshot->ball = match->ball;
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		snapshot->paddles[i] = match->paddles[i];
+}
+
+/// <summary>
+///		Copies what drawing needs out of the match, the --threaded fields are left for the caller
+/// </summary>
+void capture_match_frame(const struct match* match, struct match_frame* frame)
+{
+	frame->screen = match->screen;
+	frame->round = match->round;
+	frame->ball = match->ball;
+	frame->previous_ball = match->previous_ball;
+	frame->ball_swarm = &match->ball_swarm;
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+	{
+		frame->paddles[i] = match->paddles[i];
+		frame->previous_paddles[i] = match->previous_paddles[i];
+	}
+}
+
+void restore_match_snapshot(struct match* match, const struct game_snapshot* snapshot)
+{
+	match->screen = snapshot->screen;
+	match->round = snapshot->round;
+	match->ball = snapshot->ball;
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		match->paddles[i] = snapshot->paddles[i];
+
+	save_match_previous_state(match);
+}
+
+static void increment_score(struct match* match, int winning_player_index, int points)
+{
+	struct player* winning_player = &match->round.players[winning_player_index];
+	match->round.round_num += 1;
+	winning_player->score.points += points;
+}
+
+static void reset_score(struct match* match)
+{
+	init_scoreboard(match);
+}
+
+/// <summary>
+///		Determines whether the ball and paddle are touching
+/// </summary>
+/// <param name="paddle"></param>
+/// <param name="ball"></param>
+/// <returns></returns>
+static int are_ball_paddle_touching(const struct paddle* paddle, const struct ball* ball)
+{
+	float minX = paddle->x;
+	float maxX = paddle->x + PADDLE_WIDTH;
+	float minY = paddle->y;
+	float maxY = paddle->y + PADDLE_HEIGHT;
+
+	if ((ball->x + BALL_SIZE >= minX && ball->x <= maxX) &&
+		(ball->y + BALL_SIZE >= minY && ball->y <= maxY))
+		return TRUE;
+
+	return FALSE;
+}
+
+/// <summary>
+///		Swept AABB test of the ball moving by (vx, vy) this step against a box that isn't moving
+/// </summary>
+/// <param name="time_of_impact">0 to 1, how far through the move the ball first touches the box</param>
+/// <param name="normal_x">-1/1 if the ball hit a left/right face, 0 if it hit the top or bottom</param>
+/// <returns>TRUE if the ball touches the box at some point during the move</returns>
+static int sweep_ball_against_box(const struct ball* ball, float vx, float vy, float min_x, float min_y, float max_x, float max_y, float* time_of_impact, int* normal_x)
+{
+	// grow the box by the ball so the ball can be treated as a point at its top left corner
+	min_x -= BALL_SIZE;
+	min_y -= BALL_SIZE;
+
+	float entry_x = -INFINITY, exit_x = INFINITY;
+	float entry_y = -INFINITY, exit_y = INFINITY;
+
+	if (vx != 0.0f)
+	{
+		entry_x = ((vx > 0 ? min_x : max_x) - ball->x) / vx;
+		exit_x = ((vx > 0 ? max_x : min_x) - ball->x) / vx;
+	}
+	else if (ball->x < min_x || ball->x > max_x)
+		return FALSE;
+
+	if (vy != 0.0f)
+	{
+		entry_y = ((vy > 0 ? min_y : max_y) - ball->y) / vy;
+		exit_y = ((vy > 0 ? max_y : min_y) - ball->y) / vy;
+	}
+	else if (ball->y < min_y || ball->y > max_y)
+		return FALSE;
+
+	float entry = SDL_max(entry_x, entry_y);
+	float exit = SDL_min(exit_x, exit_y);
+
+	// already past it, misses it or doesn't get there this step
+	if (entry > exit || entry < 0.0f || entry > 1.0f)
+		return FALSE;
+
+	*time_of_impact = entry;
+	*normal_x = entry_x >= entry_y ? (vx > 0 ? -1 : 1) : 0;
+
+	return TRUE;
+}
+
+/// <summary>
+///		Sends the ball back off a paddle's face, faster and at an angle depending on where it hit
+/// </summary>
+/// <returns>Where on the paddle it hit (paddle bottom - ball top)</returns>
+static int bounce_ball_off_paddle(struct ball* ball, const struct paddle* paddle)
+{
+	// dx < 0 = moving left
+	// dx > 0 = moving right
+	// dy < 0 = moving up
+	// dy > 0 = moving down
+
+	// NOTE: I knew movement vectors were the answer here but was stuck on implementation
+	// credit goes to https://github.com/flightcrank/pong/blob/master/pong.c for making this click for me
+
+	// Moving left
+	if (ball->dx < 0)
+		ball->dx = SDL_max(ball->dx - 1, -BALL_DX_MAX);
+	// Moving right
+	else
+		ball->dx = SDL_min(ball->dx + 1, BALL_DX_MAX);
+
+	// change ball direction
+	ball->dx = -ball->dx;
+
+	// change ball angle based on where the paddle hit it
+	int hit_pos = (paddle->y + paddle->height) - ball->y;
+
+	if (hit_pos >= 0 && hit_pos < 7)
+		ball->dy = 4;
+
+	if (hit_pos >= 7 && hit_pos < 14)
+		ball->dy = 3;
+
+	if (hit_pos >= 14 && hit_pos < 21)
+		ball->dy = 2;
+
+	if (hit_pos >= 21 && hit_pos < 28)
+		ball->dy = 1;
+
+	if (hit_pos >= 28 && hit_pos < 32)
+		ball->dy = 0;
+
+	if (hit_pos >= 32 && hit_pos < 39)
+		ball->dy = -1;
+
+	if (hit_pos >= 39 && hit_pos < 46)
+		ball->dy = -2;
+
+	if (hit_pos >= 46 && hit_pos < 53)
+		ball->dy = -3;
+
+	if (hit_pos >= 53 && hit_pos <= 60)
+		ball->dy = -4;
+
+	return hit_pos;
+}
+
+/// <summary>
+///		Notes something the ball did this update, anything past MATCH_EVENTS_MAX is dropped
+/// </summary>
+static void push_match_event(struct match* match, int type, int paddle_index, int hit_pos)
+{
+	if (match->num_events >= MATCH_EVENTS_MAX)
+		return;
+
+	struct match_event* event = &match->events[match->num_events++];
+	event->type = type;
+	event->paddle_index = paddle_index;
+	event->hit_pos = hit_pos;
+	event->x = match->ball.x + (BALL_SIZE / 2.0f);
+	event->y = match->ball.y + (BALL_SIZE / 2.0f);
+	event->dx = (float)match->ball.dx;
+	event->dy = (float)match->ball.dy;
+}
+
+/// <summary>
+///		A paddle moved into the ball, push the ball back out the shortest way
+/// </summary>
+static void push_ball_out_of_paddle(struct match* match, int paddle_index)
+{
+	struct ball* ball = &match->ball;
+	const struct paddle* paddle = &match->paddles[paddle_index];
+
+	float push_left = (ball->x + BALL_SIZE) - paddle->x;
+	float push_right = (paddle->x + PADDLE_WIDTH) - ball->x;
+	float push_up = (ball->y + BALL_SIZE) - paddle->y;
+	float push_down = (paddle->y + PADDLE_HEIGHT) - ball->y;
+
+	if (SDL_min(push_left, push_right) <= SDL_min(push_up, push_down))
+	{
+		int is_pushed_left = push_left < push_right;
+		ball->x += is_pushed_left ? -push_left : push_right;
+
+		// still heading into the paddle so it counts as a hit
+		if ((is_pushed_left && ball->dx > 0) || (!is_pushed_left && ball->dx < 0))
+		{
+			int hit_pos = bounce_ball_off_paddle(ball, paddle);
+			push_match_event(match, MATCH_EVENT_PADDLE_HIT, paddle_index, hit_pos);
+		}
+	}
+	else
+	{
+		int is_pushed_up = push_up < push_down;
+		ball->y += is_pushed_up ? -push_up : push_down;
+
+		if ((is_pushed_up && ball->dy > 0) || (!is_pushed_up && ball->dy < 0))
+			ball->dy = -ball->dy;
+	}
+}
+
+/// <summary>
+///		Moves the ball through this step, bouncing off walls and paddles at the exact point it touches them.
+///		Nothing tunnels through however fast the ball is going or however long the step is.
+/// </summary>
+static void move_ball(struct match* match, float step_ticks)
+{
+	struct ball* ball = &match->ball;
+
+	// touching is fine (that's where the last bounce left it), only an actual overlap needs sorting out
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+	{
+		const struct paddle* paddle = &match->paddles[i];
+
+		if (ball->x + BALL_SIZE > paddle->x && ball->x < paddle->x + PADDLE_WIDTH &&
+			ball->y + BALL_SIZE > paddle->y && ball->y < paddle->y + PADDLE_HEIGHT)
+			push_ball_out_of_paddle(match, (int)i);
+	}
+
+	float time_left = 1.0f;
+
+	for (int iteration = 0; iteration < BALL_SWEEP_ITERATIONS_MAX && time_left > 0.0f; iteration++)
+	{
+		// a push out can leave the ball past the top/bottom
+		if (ball->y < 0 || ball->y > WINDOW_HEIGHT - BALL_SIZE)
+		{
+			ball->y = SDL_max(0.0f, SDL_min(ball->y, (float)(WINDOW_HEIGHT - BALL_SIZE)));
+			ball->dy = ball->y == 0 ? SDL_abs(ball->dy) : -SDL_abs(ball->dy);
+		}
+
+		float vx = ball->dx * step_ticks * time_left;
+		float vy = ball->dy * step_ticks * time_left;
+
+		float time_of_impact = 1.0f;
+		const struct paddle* hit_paddle = NULL;
+		int hit_normal_x = 0;
+		int is_wall_hit = FALSE;
+
+		// Bounces off top/bottom
+		if (vy != 0.0f)
+		{
+			float wall_time = ((vy < 0 ? 0 : WINDOW_HEIGHT - BALL_SIZE) - ball->y) / vy;
+
+			if (wall_time < time_of_impact)
+			{
+				time_of_impact = wall_time;
+				is_wall_hit = TRUE;
+			}
+		}
+
+		for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+		{
+			const struct paddle* paddle = &match->paddles[i];
+			float paddle_time;
+			int normal_x;
+
+			if (sweep_ball_against_box(ball, vx, vy, paddle->x, paddle->y, paddle->x + PADDLE_WIDTH, paddle->y + PADDLE_HEIGHT, &paddle_time, &normal_x) &&
+				paddle_time < time_of_impact)
+			{
+				time_of_impact = paddle_time;
+				hit_paddle = paddle;
+				hit_normal_x = normal_x;
+				is_wall_hit = FALSE;
+			}
+		}
+
+		ball->x += vx * time_of_impact;
+		ball->y += vy * time_of_impact;
+		time_left -= time_left * time_of_impact;
+
+		if (is_wall_hit)
+			ball->dy = -ball->dy;
+		else if (hit_paddle && hit_normal_x != 0)
+		{
+			int hit_pos = bounce_ball_off_paddle(ball, hit_paddle);
+			push_match_event(match, MATCH_EVENT_PADDLE_HIT, (int)(hit_paddle - match->paddles), hit_pos);
+		}
+		else if (hit_paddle)
+			ball->dy = -ball->dy; // clipped the top/bottom of the paddle
+		else
+			break;
+	}
+}
+
+/// <summary>
+///		Broadphase visitor, a swarm ball filed near a paddle: do the real test and send it back off the face it's on
+/// </summary>
+static void collide_swarm_ball_with_paddle(int ball_index, void* user_data)
+{
+	const struct swarm_paddle_query* query = user_data;
+	const struct paddle* paddle = query->paddle;
+	struct ball_swarm* swarm = &query->match->ball_swarm;
+	struct ball candidate = { BALL_SIZE, BALL_SIZE, swarm->x[ball_index], swarm->y[ball_index], 0, 0 };
+
+	if (!are_ball_paddle_touching(paddle, &candidate))
+		return;
+
+	if (candidate.x + (BALL_SIZE / 2) < paddle->x + (PADDLE_WIDTH / 2))
+	{
+		swarm->x[ball_index] = paddle->x - BALL_SIZE;
+		swarm->dx[ball_index] = -fabsf(swarm->dx[ball_index]);
+	}
+	else
+	{
+		swarm->x[ball_index] = paddle->x + PADDLE_WIDTH;
+		swarm->dx[ball_index] = fabsf(swarm->dx[ball_index]);
+	}
+}
+
+/// <summary>
+///		Bounces the chaos mode balls off the paddles, each paddle only looks at the balls in the grid cells around it
+/// </summary>
+static void collide_ball_swarm_with_paddles(struct match* match)
+{
+	if (match->ball_swarm.count == 0)
+		return;
+
+	update_broadphase_grid(&match->ball_swarm_grid, match->ball_swarm.x, match->ball_swarm.y, match->ball_swarm.count);
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+	{
+		const struct paddle* paddle = &match->paddles[i];
+		struct swarm_paddle_query query = { match, paddle };
+
+		// balls are filed by their top left corner so grow the paddle up and left by a ball
+		query_broadphase_grid(&match->ball_swarm_grid,
+			paddle->x - BALL_SIZE, paddle->y - BALL_SIZE, paddle->x + PADDLE_WIDTH, paddle->y + PADDLE_HEIGHT,
+			collide_swarm_ball_with_paddle, &query);
+	}
+}
+
+/// <summary>
+///		Pressed at any point during the frame, even if it was let go again before the tick saw it
+/// </summary>
+int was_button_pressed(const struct game_button_state* button)
+{
+	return button->half_transition_count > 1 || (button->half_transition_count == 1 && button->ended_down);
+}
+
+/// <summary>
+///		Updates the state of our game objects
+/// </summary>
+void update_match(struct match* match, const struct game_input* input)
+{
+	// ####################################
+	//  ROUND TIMER
+	// ####################################
+	// dt comes in on the input so the headless runner can feed simulated time
+	match->round.elapsed_ms += (int)(input->dt_for_frame * 1000.0f);
+	match->num_events = 0;
+
+	// ####################################
+	//  GAMESCREEN STATE HANDLING
+	// ####################################
+	if (was_button_pressed(&input->reset))
+	{
+		reset_score(match);
+		reinit_match(match);
+		match->screen.index = GAME_SCREEN_TITLE_INDEX;
+		match->screen.should_run_game = FALSE;
+		return;
+	}
+
+	if (was_button_pressed(&input->start) && match->screen.index != GAME_SCREEN_GAME_INDEX)
+	{
+		match->screen.index = GAME_SCREEN_GAME_INDEX;
+		match->screen.should_run_game = TRUE;
+	}
+
+	if (match->screen.index == GAME_SCREEN_TITLE_INDEX || match->screen.index == GAME_SCREEN_GAME_OVER_INDEX)
+		return;
+
+	// how many 60Hz ticks worth of motion this step covers, 1 unless the headless runner is taking coarse steps
+	float step_ticks = input->dt_for_frame * SIM_TICKS_PER_SECOND;
+
+	// ####################################
+	//  PADDLES
+	// ####################################
+	// paddles move first, the ball is then swept against where they ended up
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+	{
+		struct paddle* paddle = &match->paddles[i];
+
+		// ####################################
+		//  HANDLE INPUT UPDATES
+		// ####################################
+		// at the moment just saying we have two keyboard control patterns on the same keyboard
+		const struct game_controller_input* new_controller = &input->controllers[i];
+
+		// ####################################
+		//  PADDLE POSITIONING
+		// ####################################
+		// INPUT UPDATES
+		// Again, if we support more buttons we can make some wee funcs for this but it's fine for now
+		if (new_controller->move_up.ended_down)
+			paddle->y += -PADDLE_MOVE_DY * step_ticks;
+
+		if (new_controller->move_down.ended_down)
+			paddle->y += PADDLE_MOVE_DY * step_ticks;
+
+		// clamp rather than test the move up front, a coarse step can overshoot the edge by more than one move
+		paddle->y = SDL_max(0.0f, SDL_min(paddle->y, (float)(WINDOW_HEIGHT - PADDLE_HEIGHT)));
+	}
+
+	// ####################################
+	//  BALL POSITIONING
+	// ####################################
+	move_ball(match, step_ticks);
+	update_ball_swarm(&match->ball_swarm, step_ticks);
+	collide_ball_swarm_with_paddles(match);
+
+	// Went past the left/right goals (increment score, reset game)
+	if (match->ball.x < 0 || match->ball.x > WINDOW_WIDTH - BALL_SIZE) {
+		const struct player* player_zero = &match->round.players[0];
+		const struct player* player_one = &match->round.players[1];
+		int scoring_player_index = match->ball.x > WINDOW_WIDTH - BALL_SIZE ? 0 : 1;
+
+		push_match_event(match, MATCH_EVENT_GOAL, scoring_player_index, 0);
+		increment_score(match, scoring_player_index, SCORE_POINTS_INCREMENT);
+
+		// winrar is u?
+		if (player_zero->score.points == SCORE_MAX || player_one->score.points == SCORE_MAX)
+		{
+			match->screen.index = GAME_SCREEN_GAME_OVER_INDEX;
+			match->screen.should_run_game = FALSE;
+			return;
+		}
+
+		reinit_match(match);
+	}
+}
+
+/// <summary>
+///		Synthesizes controller input for the bots, each paddle's AI works out where to meet the ball
+/// </summary>
+/// <param name="first_bot_index">Paddles before this one are driven by whoever is stepping the match</param>
+static void process_bot_input(struct match* match, int first_bot_index)
+{
+	for (int i = first_bot_index; i < GAME_CONTROLLERS_MAX; i++)
+		update_ai_controller(&match->bots[i], &match->ball, &match->paddles[i], (float)match->bot_step_ticks, &match->bot_input.controllers[i]);
+
+	// the runner drives the screens itself
+	SDL_zero(match->bot_input.start);
+	SDL_zero(match->bot_input.reset);
+
+	match->bot_input.dt_for_frame = (float)(SIM_DT_S * match->bot_step_ticks);
+}
+
+/// <summary>
+///		Resets the scoreboard and objects and drops straight into a bot vs bot match
+/// </summary>
+void start_bot_match(struct match* match)
+{
+	reset_score(match);
+	reinit_match(match);
+	match->bot_num_steps = 0;
+	match->screen.index = GAME_SCREEN_GAME_INDEX;
+	match->screen.should_run_game = TRUE;
+}
+
+/// <summary>
+///		Runs one simulation step of a bot vs bot match
+/// </summary>
+void step_bot_match(struct match* match)
+{
+	save_match_previous_state(match);
+	process_bot_input(match, 0);
+	update_match(match, &match->bot_input);
+	match->bot_num_steps++;
+}
+
+/// <summary>
+///		Runs one simulation step of a bot match with the first num_agents paddles on the controllers passed in
+///		instead (the rest are still bots), for training agents against the AI or each other
+/// </summary>
+void step_agent_match(struct match* match, const struct game_controller_input* agent_controllers, int num_agents)
+{
+	num_agents = SDL_max(0, SDL_min(num_agents, GAME_CONTROLLERS_MAX));
+
+	for (int i = 0; i < num_agents; i++)
+		match->bot_input.controllers[i] = agent_controllers[i];
+
+	save_match_previous_state(match);
+	process_bot_input(match, num_agents);
+	update_match(match, &match->bot_input);
+	match->bot_num_steps++;
+}
+
+/// <summary>
+///		Still on the game screen and hasn't run out of time (a match that goes on for HEADLESS_MATCH_FRAMES_MAX is abandoned)
+/// </summary>
+int is_bot_match_running(const struct match* match)
+{
+	return match->screen.index == GAME_SCREEN_GAME_INDEX && match->bot_num_steps < HEADLESS_MATCH_FRAMES_MAX / match->bot_step_ticks;
+}
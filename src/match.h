@@ -0,0 +1,94 @@
+#pragma once
+
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+#include "ball_swarm.h"
+#include "broadphase.h"
+#include "ai.h"
+
+/*
+ * #############################################
+ *  MATCH
+ *  Everything one game of pong needs to simulate, so a process can run as
+ *  many as it likes side by side (the window plays one, the headless runner
+ *  and tournament bench play thousands). Nothing in here touches globals.
+ * #############################################
+ */
+
+// Something happened this update that the window might want to show (sparks, telemetry), never read back by the simulation
+struct match_event
+{
+	int type; // MATCH_EVENT_*
+	int paddle_index; // the paddle that was hit, or the player who scored
+	int hit_pos; // paddle hits, paddle bottom - ball top (what picked the bounce angle)
+	float x; // where, middle of the ball
+	float y;
+	float dx; // the ball's velocity afterwards (as it went in for a goal)
+	float dy;
+};
+
+// What the window draws from, copied out of the match after a tick so drawing never reads a match that's being updated
+struct match_frame
+{
+	struct game_screen screen;
+	struct round round;
+	struct ball ball;
+	struct ball previous_ball;
+	struct paddle paddles[PADDLES_NUM_MAX];
+	struct paddle previous_paddles[PADDLES_NUM_MAX];
+	const struct ball_swarm* ball_swarm; // the match's own, so only safe to draw on the thread that updates the match
+
+	// --threaded, filled in by the simulation thread
+	Uint64 tick; // ticks run so far
+	Uint64 tick_due_counter; // performance counter when the tick was due, the window interpolates on from there
+	Uint32 input_sequence; // the newest process_input() the ticks have had
+	Uint32 first_event_sequence; // events are numbered one after another, this is events[0]'s
+	struct match_event events[MATCH_FRAME_EVENTS_MAX]; // every tick's since the last frame we know the window took
+	int num_events;
+};
+
+struct match
+{
+	// Simulation (what a snapshot captures)
+	struct game_screen screen;
+	struct round round;
+	struct ball ball;
+	struct paddle paddles[PADDLES_NUM_MAX];
+
+	// Interpolation (game objects as of the previous simulation tick)
+	struct ball previous_ball;
+	struct paddle previous_paddles[PADDLES_NUM_MAX];
+
+	// Chaos mode (extra balls that bounce off the walls and paddles, for fun and load testing)
+	struct ball_swarm ball_swarm;
+	struct broadphase_grid ball_swarm_grid;
+
+	// Events (what happened in the last update_match, not part of a snapshot)
+	struct match_event events[MATCH_EVENTS_MAX];
+	int num_events;
+
+	// Bots (an AI on each paddle)
+	struct game_input bot_input;
+	struct ai_controller bots[PADDLES_NUM_MAX];
+	int bot_step_ticks; // 60Hz ticks per simulation step, the ball sweep keeps coarse steps honest
+	int bot_num_steps; // steps played since start_bot_match
+};
+
+void init_match(struct match* match);
+void init_bot_match(struct match* match, Uint32 seed, int step_ticks, const struct ai_difficulty* difficulty);
+int init_match_ball_swarm(struct match* match, int num_balls, Uint32 seed);
+void release_match(struct match* match);
+
+void save_match_previous_state(struct match* match);
+void capture_match_snapshot(const struct match* match, struct game_snapshot* snapshot);
+void restore_match_snapshot(struct match* match, const struct game_snapshot* snapshot);
+void capture_match_frame(const struct match* match, struct match_frame* frame);
+
+int was_button_pressed(const struct game_button_state* button);
+void update_match(struct match* match, const struct game_input* input);
+
+void start_bot_match(struct match* match);
+void step_bot_match(struct match* match);
+void step_agent_match(struct match* match, const struct game_controller_input* agent_controllers, int num_agents);
+int is_bot_match_running(const struct match* match);
@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+#include "match.h"
+#include "replay.h"
+#include "udp.h"
+#include "netplay.h"
+
+// One byte of input per player per tick
+#define NETPLAY_INPUT_MOVE_UP 0x01
+#define NETPLAY_INPUT_MOVE_DOWN 0x02
+#define NETPLAY_INPUT_START 0x04 // pressed this tick
+#define NETPLAY_INPUT_RESET 0x08 // pressed this tick
+#define NETPLAY_INPUT_HELD (NETPLAY_INPUT_MOVE_UP | NETPLAY_INPUT_MOVE_DOWN)
+
+#define NETPLAY_HISTORY_MASK (NETPLAY_HISTORY_FRAMES - 1)
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct netplay_frame
+{
+	struct game_snapshot snapshot; // the state this frame started from
+	Uint32 state_hash;
+	Uint8 local_input;
+	Uint8 remote_input; // what we simulated with, a guess until the peer's real one arrives
+};
+
+// NOTE: raw struct on the wire, fine for two copies of the same build on one machine
+struct netplay_packet
+{
+	Uint32 magic;
+	Uint32 ack_frame; // we have all of your inputs before this frame
+	Uint32 has_checksum;
+	Uint32 checksum_frame; // our state at the start of this frame can't change any more, here's its hash
+	Uint32 checksum;
+	Uint32 first_frame; // frame of inputs[0], everything from your last ack up to our latest frame
+	Uint8 num_inputs;
+	Uint8 inputs[NETPLAY_INPUTS_PER_PACKET_MAX];
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int is_active = FALSE;
+static int local_player_index = 0;
+
+static struct netplay_frame frames[NETPLAY_HISTORY_FRAMES];
+static Uint8 remote_inputs[NETPLAY_HISTORY_FRAMES];
+static Uint32 current_frame; // the next frame we simulate
+static Uint32 remote_confirmed_frame; // we have the peer's input for every frame before this
+static Uint32 peer_ack_frame; // the peer has our input for every frame before this
+
+static int is_rollback_pending = FALSE;
+static Uint32 rollback_frame;
+
+static int has_peer_checksum = FALSE;
+static Uint32 peer_checksum_frame;
+static Uint32 peer_checksum;
+static Uint32 last_checked_frame;
+
+static struct netplay_stats stats;
+
+/// <summary>
+///		Starts a session as player 0 or 1, the peer has to be started with the other index and our ports swapped
+/// </summary>
+int netplay_start(int player_index, Uint16 local_port, Uint16 peer_port)
+{
+	if (!udp_open(local_port, peer_port))
+		return FALSE;
+
+	local_player_index = player_index ? 1 : 0;
+	current_frame = remote_confirmed_frame = peer_ack_frame = 0;
+	is_rollback_pending = FALSE;
+	has_peer_checksum = FALSE;
+	last_checked_frame = 0;
+	SDL_zero(frames);
+	SDL_zero(remote_inputs);
+	SDL_zero(stats);
+	is_active = TRUE;
+
+	printf("Netplay: player %d on port %d, peer on port %d\n", local_player_index, local_port, peer_port);
+
+	return TRUE;
+}
+
+void netplay_stop()
+{
+	if (!is_active)
+		return;
+
+	udp_close();
+	is_active = FALSE;
+}
+
+int netplay_is_active()
+{
+	return is_active;
+}
+
+static Uint8 pack_input(const struct game_input* input)
+{
+	const struct game_controller_input* controller = &input->controllers[local_player_index];
+	Uint8 bits = 0;
+
+	if (controller->move_up.ended_down)
+		bits |= NETPLAY_INPUT_MOVE_UP;
+
+	if (controller->move_down.ended_down)
+		bits |= NETPLAY_INPUT_MOVE_DOWN;
+
+	if (was_button_pressed(&input->start))
+		bits |= NETPLAY_INPUT_START;
+
+	if (was_button_pressed(&input->reset))
+		bits |= NETPLAY_INPUT_RESET;
+
+	return bits;
+}
+
+static void unpack_press(Uint8 bits, Uint8 flag, struct game_button_state* button)
+{
+	if (!(bits & flag))
+		return;
+
+	button->ended_down = TRUE;
+	button->half_transition_count = 1;
+}
+
+/// <summary>
+///		Rebuilds the input a frame runs on from both players' bytes, either player can start or reset
+/// </summary>
+static void unpack_frame_input(const struct netplay_frame* frame, struct game_input* input)
+{
+	Uint8 player_inputs[PADDLES_NUM_MAX];
+	player_inputs[local_player_index] = frame->local_input;
+	player_inputs[1 - local_player_index] = frame->remote_input;
+
+	SDL_zerop(input);
+	input->dt_for_frame = (float)SIM_DT_S;
+
+	for (size_t i = 0; i < PADDLES_NUM_MAX; i++)
+	{
+		struct game_controller_input* controller = &input->controllers[i];
+		controller->is_connected = TRUE;
+		controller->move_up.ended_down = player_inputs[i] & NETPLAY_INPUT_MOVE_UP ? 1 : 0;
+		controller->move_down.ended_down = player_inputs[i] & NETPLAY_INPUT_MOVE_DOWN ? 1 : 0;
+
+		unpack_press(player_inputs[i], NETPLAY_INPUT_START, &input->start);
+		unpack_press(player_inputs[i], NETPLAY_INPUT_RESET, &input->reset);
+	}
+}
+
+/// <summary>
+///		The peer's real input for a frame if we have it, otherwise a guess: they're still holding whatever they last held
+/// </summary>
+static Uint8 get_remote_input(Uint32 frame_index)
+{
+	if (frame_index < remote_confirmed_frame)
+		return remote_inputs[frame_index & NETPLAY_HISTORY_MASK];
+
+	if (remote_confirmed_frame == 0)
+		return 0;
+
+	// presses are one offs, repeating one would start/reset the game again
+	return remote_inputs[(remote_confirmed_frame - 1) & NETPLAY_HISTORY_MASK] & NETPLAY_INPUT_HELD;
+}
+
+/// <summary>
+///		Snapshots the match then runs one frame of it on the inputs we have for that frame
+/// </summary>
+static void simulate_frame(struct match* match, Uint32 frame_index)
+{
+	struct netplay_frame* frame = &frames[frame_index & NETPLAY_HISTORY_MASK];
+	struct game_input input;
+
+	frame->remote_input = get_remote_input(frame_index);
+	capture_match_snapshot(match, &frame->snapshot);
+	frame->state_hash = replay_hash_snapshot(&frame->snapshot);
+
+	unpack_frame_input(frame, &input);
+	save_match_previous_state(match);
+	update_match(match, &input);
+}
+
+/// <summary>
+///		Takes the peer's inputs in order off every packet waiting and notes the earliest frame we guessed wrong
+/// </summary>
+static void receive_packets()
+{
+	struct netplay_packet packet;
+	int size;
+
+	while ((size = udp_receive(&packet, sizeof(packet))) > 0)
+	{
+		size_t header_size = offsetof(struct netplay_packet, inputs);
+
+		if (size < (int)header_size || packet.magic != NETPLAY_PACKET_MAGIC ||
+			packet.num_inputs > NETPLAY_INPUTS_PER_PACKET_MAX || size < (int)(header_size + packet.num_inputs))
+			continue;
+
+		if (packet.ack_frame > peer_ack_frame)
+			peer_ack_frame = SDL_min(packet.ack_frame, current_frame);
+
+		for (Uint32 i = 0; i < packet.num_inputs; i++)
+		{
+			Uint32 frame_index = packet.first_frame + i;
+
+			// old news, or a gap (an earlier packet went missing, a later one resends it)
+			if (frame_index < remote_confirmed_frame)
+				continue;
+
+			if (frame_index > remote_confirmed_frame)
+				break;
+
+			Uint8 remote_input = packet.inputs[i];
+			remote_inputs[frame_index & NETPLAY_HISTORY_MASK] = remote_input;
+			remote_confirmed_frame++;
+
+			// already simulated on a guess, if the guess was wrong everything from here on is too
+			if (frame_index < current_frame && frames[frame_index & NETPLAY_HISTORY_MASK].remote_input != remote_input &&
+				(!is_rollback_pending || frame_index < rollback_frame))
+			{
+				is_rollback_pending = TRUE;
+				rollback_frame = frame_index;
+			}
+		}
+
+		if (packet.has_checksum && (!has_peer_checksum || packet.checksum_frame > peer_checksum_frame))
+		{
+			has_peer_checksum = TRUE;
+			peer_checksum_frame = packet.checksum_frame;
+			peer_checksum = packet.checksum;
+		}
+	}
+}
+
+/// <summary>
+///		Puts the match back how it was at the first mispredicted frame and re-simulates up to now with the real inputs
+/// </summary>
+static void roll_back(struct match* match)
+{
+	if (!is_rollback_pending)
+		return;
+
+	Uint32 num_frames = current_frame - rollback_frame;
+	restore_match_snapshot(match, &frames[rollback_frame & NETPLAY_HISTORY_MASK].snapshot);
+
+	for (Uint32 frame_index = rollback_frame; frame_index < current_frame; frame_index++)
+		simulate_frame(match, frame_index);
+
+	stats.num_rollbacks++;
+	stats.num_resimulated_frames += num_frames;
+	stats.max_rollback_frames = SDL_max(stats.max_rollback_frames, num_frames);
+	is_rollback_pending = FALSE;
+}
+
+/// <summary>
+///		The newest frame whose starting state is final: we have both players' inputs for every frame before it
+/// </summary>
+/// <returns>FALSE if we haven't simulated one yet</returns>
+static int get_final_frame(Uint32* frame_index)
+{
+	if (current_frame == 0)
+		return FALSE;
+
+	*frame_index = SDL_min(remote_confirmed_frame, current_frame - 1);
+	return TRUE;
+}
+
+/// <summary>
+///		Compares the peer's hash of a final frame against ours, both sides simulated it on the same inputs so they have to match
+/// </summary>
+static void check_peer_checksum()
+{
+	Uint32 final_frame;
+
+	if (!has_peer_checksum || !get_final_frame(&final_frame))
+		return;
+
+	if (peer_checksum_frame > final_frame || (stats.num_checked_frames > 0 && peer_checksum_frame <= last_checked_frame) ||
+		peer_checksum_frame + NETPLAY_HISTORY_FRAMES <= current_frame)
+		return;
+
+	if (frames[peer_checksum_frame & NETPLAY_HISTORY_MASK].state_hash != peer_checksum)
+	{
+		if (stats.num_desyncs == 0)
+			printf("Netplay: DESYNC at frame %u, our state %08x, theirs %08x\n",
+				peer_checksum_frame, frames[peer_checksum_frame & NETPLAY_HISTORY_MASK].state_hash, peer_checksum);
+
+		stats.num_desyncs++;
+	}
+
+	stats.num_checked_frames++;
+	last_checked_frame = peer_checksum_frame;
+}
+
+/// <summary>
+///		Sends the peer every input of ours they haven't acked yet, plus what we've got of theirs and a checksum
+/// </summary>
+static void send_inputs()
+{
+	struct netplay_packet packet;
+	Uint32 final_frame;
+
+	SDL_zero(packet);
+	packet.magic = NETPLAY_PACKET_MAGIC;
+	packet.ack_frame = remote_confirmed_frame;
+	packet.first_frame = SDL_max(peer_ack_frame, current_frame > NETPLAY_INPUTS_PER_PACKET_MAX ? current_frame - NETPLAY_INPUTS_PER_PACKET_MAX : 0);
+	packet.num_inputs = (Uint8)(current_frame - packet.first_frame);
+
+	for (Uint32 i = 0; i < packet.num_inputs; i++)
+		packet.inputs[i] = frames[(packet.first_frame + i) & NETPLAY_HISTORY_MASK].local_input;
+
+	if (get_final_frame(&final_frame))
+	{
+		packet.has_checksum = TRUE;
+		packet.checksum_frame = final_frame;
+		packet.checksum = frames[final_frame & NETPLAY_HISTORY_MASK].state_hash;
+	}
+
+	udp_send(&packet, (int)(offsetof(struct netplay_packet, inputs) + packet.num_inputs));
+}
+
+/// <summary>
+///		Runs one fixed tick of a netplay match: takes in the peer's inputs, rolls back if we guessed any wrong,
+///		then simulates this tick on our input and our guess at theirs
+/// </summary>
+/// <returns>FALSE if we're too far ahead of the peer and have to wait for them (the tick didn't run)</returns>
+int netplay_tick(struct match* match, const struct game_input* local_input)
+{
+	udp_flush();
+	receive_packets();
+	roll_back(match);
+
+	if (current_frame >= remote_confirmed_frame + NETPLAY_PREDICTION_FRAMES_MAX)
+	{
+		stats.num_stalled_ticks++;
+		send_inputs();
+		return FALSE;
+	}
+
+	frames[current_frame & NETPLAY_HISTORY_MASK].local_input = pack_input(local_input);
+	simulate_frame(match, current_frame);
+	current_frame++;
+
+	check_peer_checksum();
+	send_inputs();
+
+	return TRUE;
+}
+
+void netplay_get_stats(struct netplay_stats* out_stats)
+{
+	*out_stats = stats;
+	out_stats->frame = current_frame;
+}
+
+void netplay_print_stats()
+{
+	struct udp_stats link_stats;
+	udp_get_stats(&link_stats);
+
+	printf("Netplay: %u frames, %u stalled ticks\n", current_frame, stats.num_stalled_ticks);
+	printf("  rollbacks: %u (%u frames re-simulated, deepest %u)\n", stats.num_rollbacks, stats.num_resimulated_frames, stats.max_rollback_frames);
+	printf("  checked: %u frames, %u desync(s)\n", stats.num_checked_frames, stats.num_desyncs);
+	printf("  packets: %llu sent (%llu dropped by the simulated network), %llu received\n",
+		(unsigned long long)link_stats.num_sent, (unsigned long long)link_stats.num_dropped, (unsigned long long)link_stats.num_received);
+}
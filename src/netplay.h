@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SDL.h>
+#include "types.h"
+#include "match.h"
+
+/*
+ * #############################################
+ *  ROLLBACK NETPLAY
+ *  Two instances each simulate the whole match. Every tick we run on our own
+ *  input straight away and a guess at the peer's (whatever they last sent).
+ *  When their real input turns up and the guess was wrong we restore the
+ *  snapshot from that tick and re-simulate up to now within the same tick.
+ *  Inputs go over the UDP loopback with every unacked tick resent in each
+ *  packet, so a lost packet only costs a rollback.
+ * #############################################
+ */
+
+struct netplay_stats
+{
+	Uint32 frame; // ticks simulated (not counting re-simulation)
+	Uint32 num_rollbacks;
+	Uint32 num_resimulated_frames;
+	Uint32 max_rollback_frames;
+	Uint32 num_stalled_ticks; // ticks we waited because we were too far ahead of the peer's input
+	Uint32 num_checked_frames; // ticks whose final state both sides have compared
+	Uint32 num_desyncs;
+};
+
+int netplay_start(int local_player_index, Uint16 local_port, Uint16 peer_port);
+void netplay_stop();
+int netplay_is_active();
+
+int netplay_tick(struct match* match, const struct game_input* local_input);
+
+void netplay_get_stats(struct netplay_stats* stats);
+void netplay_print_stats();
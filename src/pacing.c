@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "constants.h"
+#include "pacing.h"
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int pacing_mode = PACING_MODE_FIXED;
+static int pacing_target_fps = FPS;
+// Deadlines are anchor + frames * frequency / fps, worked out fresh each frame so a period that doesn't divide into
+// counter ticks never rounds the same way twice
+static Uint64 anchor_counter; // 0 until the first frame, we start the clock from there
+static Uint64 num_anchor_frames;
+static Uint64 last_frame_counter;
+
+// How long SDL_Delay(1) really takes (Welford running mean/variance), we spin once the rest of the wait is within
+// the mean plus a standard deviation of it so an overshooting sleep doesn't make us late
+static double sleep_mean_s = PACING_SLEEP_ESTIMATE_S;
+static double sleep_m2_s = 0.0;
+static Uint64 num_sleeps = 1;
+
+// Frame intervals, only the loop thread touches these
+static double intervals_ms[PACING_SAMPLES_MAX];
+static int intervals_written;
+
+static const char* mode_names[PACING_MODES_NUM] = {
+	"fixed",
+	"vsync",
+	"unlimited",
+};
+
+/// <summary>
+///		Switches how frames are paced, VSync is turned on or off on the renderer to suit
+/// </summary>
+/// <param name="target_fps">Rate for PACING_MODE_FIXED, under VSync it's replaced with the display's refresh rate if SDL knows it</param>
+/// <returns>The mode we ended up in, fixed if VSync couldn't be turned on</returns>
+int pacing_set_mode(SDL_Window* window, SDL_Renderer* renderer, int mode, int target_fps)
+{
+	if (mode < 0 || mode >= PACING_MODES_NUM)
+		mode = PACING_MODE_FIXED;
+
+	if (target_fps < 1)
+		target_fps = FPS;
+
+	// a renderer that can't change VSync after it's created reports an error and keeps presenting as it was
+	if (SDL_RenderSetVSync(renderer, mode == PACING_MODE_VSYNC) != 0 && mode == PACING_MODE_VSYNC)
+	{
+		printf("Could not turn VSync on, pacing to %d FPS instead. SDL Err: %s\n", target_fps, SDL_GetError());
+		mode = PACING_MODE_FIXED;
+	}
+
+	SDL_DisplayMode display_mode;
+
+	if (mode == PACING_MODE_VSYNC && SDL_GetWindowDisplayMode(window, &display_mode) == 0 && display_mode.refresh_rate > 0)
+		target_fps = display_mode.refresh_rate;
+
+	pacing_mode = mode;
+	pacing_target_fps = target_fps;
+	anchor_counter = 0;
+
+	// the old mode's intervals would just muddy the new one's stats
+	last_frame_counter = 0;
+	intervals_written = 0;
+
+	return mode;
+}
+
+int pacing_get_mode()
+{
+	return pacing_mode;
+}
+
+int pacing_get_target_fps()
+{
+	return pacing_target_fps;
+}
+
+const char* pacing_mode_name(int mode)
+{
+	return mode >= 0 && mode < PACING_MODES_NUM ? mode_names[mode] : "unknown";
+}
+
+/// <summary>
+///		One frame at the target rate, what the profiler overlay measures its bars against
+/// </summary>
+double pacing_get_frame_budget_ms()
+{
+	return 1000.0 / pacing_target_fps;
+}
+
+/// <summary>
+///		Sleeps for a ms and folds how long that really took into the estimate
+/// </summary>
+static Uint64 sleep_and_measure(Uint64 now_counter)
+{
+	SDL_Delay(1);
+
+	Uint64 after_counter = SDL_GetPerformanceCounter();
+	double slept_s = (double)(after_counter - now_counter) / (double)SDL_GetPerformanceFrequency();
+
+	// cap how much history counts so it follows the OS if its timer behaviour changes
+	num_sleeps = SDL_min(num_sleeps + 1, PACING_SLEEP_HISTORY_MAX);
+
+	double delta = slept_s - sleep_mean_s;
+	sleep_mean_s += delta / (double)num_sleeps;
+	sleep_m2_s += delta * (slept_s - sleep_mean_s);
+
+	// keep the variance in step with the capped count too
+	if (num_sleeps == PACING_SLEEP_HISTORY_MAX)
+		sleep_m2_s *= (double)(num_sleeps - 1) / (double)num_sleeps;
+
+	return after_counter;
+}
+
+/// <summary>
+///		Sleeps then spins until this frame's deadline, called after present so the render time counts towards the frame
+/// </summary>
+static Uint64 wait_for_deadline()
+{
+	Uint64 now_counter = SDL_GetPerformanceCounter();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+
+	// a frame that ran over by more than a period (or a stall) starts the clock again from now,
+	// otherwise we'd rush out a burst of frames to catch up
+	if (anchor_counter == 0 || now_counter > anchor_counter + (((num_anchor_frames + 2) * frequency) / pacing_target_fps))
+	{
+		anchor_counter = now_counter;
+		num_anchor_frames = 0;
+	}
+
+	Uint64 deadline_counter = anchor_counter + ((++num_anchor_frames * frequency) / pacing_target_fps);
+
+	for (;;)
+	{
+		if (now_counter >= deadline_counter)
+			break;
+
+		double remaining_s = (double)(deadline_counter - now_counter) / (double)frequency;
+		double sleep_stddev_s = SDL_sqrt(sleep_m2_s / (double)num_sleeps);
+
+		if (remaining_s <= sleep_mean_s + sleep_stddev_s)
+			break;
+
+		now_counter = sleep_and_measure(now_counter);
+	}
+
+	while (now_counter < deadline_counter)
+		now_counter = SDL_GetPerformanceCounter();
+
+	return now_counter;
+}
+
+/// <summary>
+///		Holds the frame to the current mode's rate then records how long it was
+/// </summary>
+void pacing_wait_for_next_frame()
+{
+	// VSync already waited in SDL_RenderPresent and unlimited doesn't wait
+	Uint64 now_counter = pacing_mode == PACING_MODE_FIXED ? wait_for_deadline() : SDL_GetPerformanceCounter();
+
+	if (last_frame_counter != 0)
+	{
+		intervals_ms[intervals_written % PACING_SAMPLES_MAX] = (double)(now_counter - last_frame_counter) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+		intervals_written++;
+	}
+
+	last_frame_counter = now_counter;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+	double lhs = *(const double*)a;
+	double rhs = *(const double*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+/// <summary>
+///		Works out the jitter and percentiles over the most recent PACING_SAMPLES_MAX frame intervals
+/// </summary>
+void pacing_compute_stats(struct pacing_stats* stats)
+{
+	static double sorted_intervals_ms[PACING_SAMPLES_MAX];
+	int num_samples = SDL_min(intervals_written, PACING_SAMPLES_MAX);
+
+	SDL_zerop(stats);
+	stats->num_samples = num_samples;
+
+	if (num_samples == 0)
+		return;
+
+	double missed_ms = pacing_get_frame_budget_ms() * PACING_MISSED_FRAME_FACTOR;
+	double sum_ms = 0.0;
+
+	for (int i = 0; i < num_samples; i++)
+	{
+		sum_ms += intervals_ms[i];
+
+		if (pacing_mode != PACING_MODE_UNLIMITED && intervals_ms[i] > missed_ms)
+			stats->num_missed++;
+	}
+
+	stats->mean_ms = sum_ms / num_samples;
+
+	double sum_squares = 0.0;
+
+	for (int i = 0; i < num_samples; i++)
+		sum_squares += (intervals_ms[i] - stats->mean_ms) * (intervals_ms[i] - stats->mean_ms);
+
+	stats->jitter_ms = SDL_sqrt(sum_squares / num_samples);
+
+	SDL_memcpy(sorted_intervals_ms, intervals_ms, num_samples * sizeof(double));
+	qsort(sorted_intervals_ms, num_samples, sizeof(double), compare_doubles);
+	stats->p50_ms = sorted_intervals_ms[(num_samples * 50) / 100];
+	stats->p99_ms = sorted_intervals_ms[(num_samples * 99) / 100];
+	stats->max_ms = sorted_intervals_ms[num_samples - 1];
+}
+
+void pacing_print_stats()
+{
+	struct pacing_stats stats;
+	pacing_compute_stats(&stats);
+
+	printf("Pacing: %s at %d FPS (%.3f ms), last %d frames\n", mode_names[pacing_mode], pacing_target_fps, pacing_get_frame_budget_ms(), stats.num_samples);
+	printf("  mean %.3f ms  jitter %.3f ms  p50 %.3f ms  p99 %.3f ms  max %.3f ms  missed %d\n",
+		stats.mean_ms, stats.jitter_ms, stats.p50_ms, stats.p99_ms, stats.max_ms, stats.num_missed);
+	printf("  SDL_Delay(1) takes %.3f ms +- %.3f ms here\n", sleep_mean_s * 1000.0, SDL_sqrt(sleep_m2_s / (double)num_sleeps) * 1000.0);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  FRAME PACING
+ *  Holds the display rate to a target on the performance counter. Frame
+ *  deadlines are counted from a fixed start rather than from when the
+ *  last frame finished, so rounding never adds up to a drift. Most of
+ *  the wait is slept off in 1ms SDL_Delays, then it spins the last
+ *  stretch because a sleep can overshoot by a ms or more (how much is
+ *  measured as it goes). VSync hands the waiting to SDL_RenderPresent
+ *  instead, unlimited doesn't wait at all. Every frame interval goes
+ *  into a ring for the jitter stats.
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct pacing_stats
+{
+	int num_samples;
+	double mean_ms;
+	double jitter_ms; // standard deviation of the frame intervals
+	double p50_ms;
+	double p99_ms;
+	double max_ms;
+	int num_missed; // intervals over PACING_MISSED_FRAME_FACTOR target periods (fixed and VSync only)
+};
+
+int pacing_set_mode(SDL_Window* window, SDL_Renderer* renderer, int mode, int target_fps);
+int pacing_get_mode();
+int pacing_get_target_fps();
+const char* pacing_mode_name(int mode);
+double pacing_get_frame_budget_ms();
+
+void pacing_wait_for_next_frame();
+
+void pacing_compute_stats(struct pacing_stats* stats);
+void pacing_print_stats();
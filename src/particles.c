@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <limits.h>
+#include <SDL.h>
+#include "constants.h"
+#include "simd.h"
+#include "particles.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+typedef void (*particles_kernel_func)(float* x, float* y, float* dx, float* dy, float* life, int count, float step_ticks, float damping);
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int simd_level = SIMD_LEVEL_SCALAR;
+static particles_kernel_func update_kernel;
+
+/*
+ * #############################################
+ *  SCALAR
+ * #############################################
+ */
+static void update_kernel_scalar(float* x, float* y, float* dx, float* dy, float* life, int count, float step_ticks, float damping)
+{
+	// the SIMD kernels do exactly these operations in this order, they have to come out bit for bit the same
+	for (int i = 0; i < count; i++)
+	{
+		x[i] += dx[i] * step_ticks;
+		y[i] += dy[i] * step_ticks;
+		dy[i] += PARTICLES_GRAVITY * step_ticks;
+		dx[i] *= damping;
+		dy[i] *= damping;
+		life[i] -= step_ticks;
+	}
+}
+
+#if SIMD_HAS_X86
+/*
+ * #############################################
+ *  SSE2 (4 particles at a time)
+ * #############################################
+ */
+SIMD_TARGET_SSE2 static void update_kernel_sse2(float* x, float* y, float* dx, float* dy, float* life, int count, float step_ticks, float damping)
+{
+	__m128 step_x4 = _mm_set1_ps(step_ticks);
+	__m128 fall_x4 = _mm_set1_ps(PARTICLES_GRAVITY * step_ticks);
+	__m128 damping_x4 = _mm_set1_ps(damping);
+
+	for (int i = 0; i < count; i += 4)
+	{
+		__m128 vx = _mm_load_ps(&dx[i]);
+		__m128 vy = _mm_load_ps(&dy[i]);
+
+		_mm_store_ps(&x[i], _mm_add_ps(_mm_load_ps(&x[i]), _mm_mul_ps(vx, step_x4)));
+		_mm_store_ps(&y[i], _mm_add_ps(_mm_load_ps(&y[i]), _mm_mul_ps(vy, step_x4)));
+		_mm_store_ps(&dx[i], _mm_mul_ps(vx, damping_x4));
+		_mm_store_ps(&dy[i], _mm_mul_ps(_mm_add_ps(vy, fall_x4), damping_x4));
+		_mm_store_ps(&life[i], _mm_sub_ps(_mm_load_ps(&life[i]), step_x4));
+	}
+}
+
+/*
+ * #############################################
+ *  AVX2 (8 particles at a time)
+ * #############################################
+ */
+SIMD_TARGET_AVX2 static void update_kernel_avx2(float* x, float* y, float* dx, float* dy, float* life, int count, float step_ticks, float damping)
+{
+	__m256 step_x8 = _mm256_set1_ps(step_ticks);
+	__m256 fall_x8 = _mm256_set1_ps(PARTICLES_GRAVITY * step_ticks);
+	__m256 damping_x8 = _mm256_set1_ps(damping);
+
+	for (int i = 0; i < count; i += 8)
+	{
+		__m256 vx = _mm256_load_ps(&dx[i]);
+		__m256 vy = _mm256_load_ps(&dy[i]);
+
+		_mm256_store_ps(&x[i], _mm256_add_ps(_mm256_load_ps(&x[i]), _mm256_mul_ps(vx, step_x8)));
+		_mm256_store_ps(&y[i], _mm256_add_ps(_mm256_load_ps(&y[i]), _mm256_mul_ps(vy, step_x8)));
+		_mm256_store_ps(&dx[i], _mm256_mul_ps(vx, damping_x8));
+		_mm256_store_ps(&dy[i], _mm256_mul_ps(_mm256_add_ps(vy, fall_x8), damping_x8));
+		_mm256_store_ps(&life[i], _mm256_sub_ps(_mm256_load_ps(&life[i]), step_x8));
+	}
+}
+#endif
+
+int particles_get_simd_level()
+{
+	return simd_level;
+}
+
+/// <summary>
+///		Forces a kernel level (for benchmarking), falls back a level at a time if the CPU can't do it
+/// </summary>
+/// <returns>The level actually in use</returns>
+int particles_set_simd_level(int level)
+{
+	simd_level = simd_supported_level(level);
+
+	switch (simd_level) {
+#if SIMD_HAS_X86
+		case SIMD_LEVEL_AVX2:
+			update_kernel = update_kernel_avx2;
+			break;
+
+		case SIMD_LEVEL_SSE2:
+			update_kernel = update_kernel_sse2;
+			break;
+#endif
+
+		default:
+			update_kernel = update_kernel_scalar;
+			break;
+	}
+
+	return simd_level;
+}
+
+/// <summary>
+///		Allocates the whole pool (rounded up to a whole number of SIMD lanes) and picks the kernels, nothing is allocated after this
+/// </summary>
+int init_particle_system(struct particle_system* system, int capacity, Uint32 seed)
+{
+	SDL_zerop(system);
+	system->random_state = seed ? seed : 1;
+
+	if (!update_kernel)
+		particles_set_simd_level(simd_detect_level());
+
+	capacity = (capacity + PARTICLES_LANES - 1) / PARTICLES_LANES * PARTICLES_LANES;
+
+	if (capacity <= 0)
+		return TRUE;
+
+	size_t array_size = capacity * sizeof(float);
+	system->x = SDL_SIMDAlloc(array_size);
+	system->y = SDL_SIMDAlloc(array_size);
+	system->dx = SDL_SIMDAlloc(array_size);
+	system->dy = SDL_SIMDAlloc(array_size);
+	system->life = SDL_SIMDAlloc(array_size);
+
+	if (!system->x || !system->y || !system->dx || !system->dy || !system->life)
+	{
+		printf("Could not allocate a pool of %d particles.\n", capacity);
+		release_particle_system(system);
+		return FALSE;
+	}
+
+	// the padding lanes get run through the kernels too
+	SDL_memset(system->x, 0, array_size);
+	SDL_memset(system->y, 0, array_size);
+	SDL_memset(system->dx, 0, array_size);
+	SDL_memset(system->dy, 0, array_size);
+	SDL_memset(system->life, 0, array_size);
+
+	system->capacity = capacity;
+
+	return TRUE;
+}
+
+void release_particle_system(struct particle_system* system)
+{
+	SDL_SIMDFree(system->x);
+	SDL_SIMDFree(system->y);
+	SDL_SIMDFree(system->dx);
+	SDL_SIMDFree(system->dy);
+	SDL_SIMDFree(system->life);
+	SDL_zerop(system);
+}
+
+void clear_particles(struct particle_system* system)
+{
+	system->count = 0;
+	SDL_zero(system->bounds);
+}
+
+/// <summary>
+///		xorshift (same as the swarm and bots) mapped to -1 to 1
+/// </summary>
+static float next_random_signed(Uint32* random_state)
+{
+	*random_state ^= *random_state << 13;
+	*random_state ^= *random_state >> 17;
+	*random_state ^= *random_state << 5;
+
+	return ((float)(*random_state & 0xFFFF) / 32767.5f) - 1.0f;
+}
+
+/// <summary>
+///		Adds a burst of particles around a point, whatever doesn't fit in the pool is dropped
+/// </summary>
+/// <returns>How many were actually spawned</returns>
+int spawn_particle_burst(struct particle_system* system, const struct particle_burst* burst)
+{
+	int num_spawned = SDL_min(burst->count, system->capacity - system->count);
+
+	for (int i = system->count; i < system->count + num_spawned; i++)
+	{
+		float spread_x;
+		float spread_y;
+
+		// anywhere in a circle rather than a square, a square burst looks like a box going off
+		do
+		{
+			spread_x = next_random_signed(&system->random_state);
+			spread_y = next_random_signed(&system->random_state);
+		} while ((spread_x * spread_x) + (spread_y * spread_y) > 1.0f);
+
+		system->x[i] = burst->x;
+		system->y[i] = burst->y;
+		system->dx[i] = burst->dx + (spread_x * burst->spread);
+		system->dy[i] = burst->dy + (spread_y * burst->spread);
+		system->life[i] = burst->life_min + ((next_random_signed(&system->random_state) + 1.0f) * 0.5f * burst->life_range);
+	}
+
+	system->count += num_spawned;
+
+	// they're drawn before the next update works the bounds out again
+	if (num_spawned > 0)
+	{
+		SDL_Rect spawn_rect = { (int)burst->x, (int)burst->y, PARTICLES_SIZE, PARTICLES_SIZE };
+
+		if (SDL_RectEmpty(&system->bounds))
+			system->bounds = spawn_rect;
+		else
+			SDL_UnionRect(&system->bounds, &spawn_rect, &system->bounds);
+	}
+
+	return num_spawned;
+}
+
+/// <summary>
+///		Moves every particle on by step_ticks and drops the ones that have burnt out or left the screen
+/// </summary>
+void update_particles(struct particle_system* system, float step_ticks)
+{
+	if (system->count == 0)
+		return;
+
+	// a long frame shouldn't flip the velocities round
+	float damping = SDL_max(1.0f - (PARTICLES_DRAG * step_ticks), 0.0f);
+
+	// whole lanes only, the arrays are padded out to a multiple of PARTICLES_LANES
+	int lane_count = (system->count + PARTICLES_LANES - 1) / PARTICLES_LANES * PARTICLES_LANES;
+	update_kernel(system->x, system->y, system->dx, system->dy, system->life, lane_count, step_ticks, damping);
+
+	// Swap the dead out from the end so the live particles stay packed, working out their bounds on the way.
+	// Order doesn't matter, nothing here depends on which particle is drawn first.
+	int min_x = INT_MAX;
+	int min_y = INT_MAX;
+	int max_x = INT_MIN;
+	int max_y = INT_MIN;
+	int i = 0;
+
+	while (i < system->count)
+	{
+		float x = system->x[i];
+		float y = system->y[i];
+
+		// gravity brings anything that went off the top back down, the other edges it's gone for good
+		if (system->life[i] <= 0.0f || x <= -PARTICLES_SIZE || x >= WINDOW_WIDTH || y >= WINDOW_HEIGHT)
+		{
+			int last = --system->count;
+			system->x[i] = system->x[last];
+			system->y[i] = system->y[last];
+			system->dx[i] = system->dx[last];
+			system->dy[i] = system->dy[last];
+			system->life[i] = system->life[last];
+			continue;
+		}
+
+		int px = (int)x;
+		int py = (int)y;
+		min_x = SDL_min(min_x, px);
+		min_y = SDL_min(min_y, py);
+		max_x = SDL_max(max_x, px);
+		max_y = SDL_max(max_y, py);
+		i++;
+	}
+
+	SDL_zero(system->bounds);
+
+	if (system->count > 0)
+	{
+		system->bounds.x = min_x;
+		system->bounds.y = min_y;
+		system->bounds.w = max_x + PARTICLES_SIZE - min_x;
+		system->bounds.h = max_y + PARTICLES_SIZE - min_y;
+	}
+}
+
+/// <summary>
+///		Game pixels to target pixels, rounding down like the window's render scale does so the particles land inside their bounds
+/// </summary>
+static int scale_coordinate(int value, int scale_percent)
+{
+	int scaled = value * scale_percent;
+	return (scaled >= 0 ? scaled : scaled - 99) / 100;
+}
+
+void render_particles(const struct particle_system* system, SDL_Surface* target, int scale_percent)
+{
+	if (system->count == 0)
+		return;
+
+	// a particle fades from white to black over its last PARTICLES_FADE_TICKS
+	Uint32 shades[PARTICLES_SHADES_NUM];
+
+	for (int s = 0; s < PARTICLES_SHADES_NUM; s++)
+	{
+		Uint8 level = (Uint8)((s * 255) / (PARTICLES_SHADES_NUM - 1));
+		shades[s] = SDL_MapRGB(target->format, level, level, level);
+	}
+
+	const float shade_per_tick = (float)(PARTICLES_SHADES_NUM - 1) / PARTICLES_FADE_TICKS;
+	Uint8* pixels = target->pixels;
+	int pitch = target->pitch;
+
+	for (int i = 0; i < system->count; i++)
+	{
+		int px = (int)system->x[i];
+		int py = (int)system->y[i];
+		int min_x = scale_coordinate(px, scale_percent);
+		int min_y = scale_coordinate(py, scale_percent);
+		int max_x = SDL_max(scale_coordinate(px + PARTICLES_SIZE, scale_percent), min_x + 1);
+		int max_y = SDL_max(scale_coordinate(py + PARTICLES_SIZE, scale_percent), min_y + 1);
+
+		min_x = SDL_max(min_x, 0);
+		min_y = SDL_max(min_y, 0);
+		max_x = SDL_min(max_x, target->w);
+		max_y = SDL_min(max_y, target->h);
+
+		int shade = SDL_min((int)(system->life[i] * shade_per_tick), PARTICLES_SHADES_NUM - 1);
+		Uint32 colour = shades[SDL_max(shade, 0)];
+
+		for (int y = min_y; y < max_y; y++)
+		{
+			Uint32* row = (Uint32*)(pixels + (y * pitch));
+
+			for (int x = min_x; x < max_x; x++)
+				row[x] = colour;
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  PARTICLES
+ *  Sparks off paddle hits, the burst when someone scores and the trail a
+ *  ball leaves after a hit. Purely cosmetic, nothing here feeds back into
+ *  the match, so they run on the real frame time rather than the fixed
+ *  simulation ticks. The pool is allocated once up front as structure
+ *  of arrays: spawning past capacity drops particles rather than growing
+ *  it. The integrate kernel runs 4 (SSE2) or 8 (AVX2) particles at a
+ *  time like the ball swarm, dead particles are then swapped out from
+ *  the end so the live ones stay packed at the front.
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct particle_system
+{
+	int count;
+	int capacity; // always a multiple of PARTICLES_LANES, the kernels run over the padding too
+	float* x;
+	float* y;
+	float* dx; // px a 60Hz tick, same units as the ball
+	float* dy;
+	float* life; // ticks left, fades out over the last PARTICLES_FADE_TICKS
+	Uint32 random_state;
+
+	// Game pixels every live particle covers as of the last update, empty when there aren't any
+	SDL_Rect bounds;
+};
+
+struct particle_burst
+{
+	float x;
+	float y;
+	float dx; // the burst's drift, each particle gets up to spread either way on top
+	float dy;
+	float spread;
+	float life_min; // ticks
+	float life_range;
+	int count;
+};
+
+int init_particle_system(struct particle_system* system, int capacity, Uint32 seed);
+void release_particle_system(struct particle_system* system);
+void clear_particles(struct particle_system* system);
+
+int spawn_particle_burst(struct particle_system* system, const struct particle_burst* burst);
+void update_particles(struct particle_system* system, float step_ticks);
+
+/// <summary>
+///		Draws every live particle into target as PARTICLES_SIZE squares, scaled the same way the window's render scale does
+/// </summary>
+/// <param name="scale_percent">Target pixels per 100 game pixels, 100 for a surface the size of the game</param>
+void render_particles(const struct particle_system* system, SDL_Surface* target, int scale_percent);
+
+int particles_get_simd_level();
+int particles_set_simd_level(int level);
@@ -0,0 +1,358 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "constants.h"
+#include "profiler.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct profile_event
+{
+	Uint64 begin_counter;
+	Uint64 end_counter;
+	Uint32 phase;
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int is_profiler_enabled = FALSE;
+
+// Single producer ring: the loop thread writes the slot then publishes it by bumping
+// events_written, readers copy out and check the slots weren't lapped while they looked
+static struct profile_event events[PROFILER_RING_CAPACITY];
+static SDL_atomic_t events_written;
+
+static Uint64 first_counter;
+
+// Input event to present, only the loop thread touches these
+static double input_latencies_ms[PROFILER_LATENCY_SAMPLES_MAX];
+static int input_latencies_written;
+
+// How long after they were due simulation ticks ran, only whichever thread runs the ticks touches these
+static double tick_latenesses_ms[PROFILER_LATENCY_SAMPLES_MAX];
+static int tick_latenesses_written;
+
+static const char* phase_names[PROFILE_PHASE_COUNT] = {
+	"frame",
+	"pump_events",
+	"process_input",
+	"update_pacing",
+	"update_sim",
+	"update_particles",
+	"retain_input",
+	"render_clear",
+	"render_draw",
+	"render_upload",
+	"render_present",
+};
+
+// Overlay stats are only recomputed every so often, sorting each frame would show up in the profile
+static struct profile_phase_stats overlay_stats[PROFILE_PHASE_COUNT];
+static int overlay_frames_until_refresh = 0;
+
+void profiler_set_enabled(int is_enabled)
+{
+	is_profiler_enabled = is_enabled;
+
+	if (is_enabled && !first_counter)
+		first_counter = SDL_GetPerformanceCounter();
+}
+
+int profiler_is_enabled()
+{
+	return is_profiler_enabled;
+}
+
+/// <summary>
+///		Starts timing a phase, hand the result back to profiler_end
+/// </summary>
+Uint64 profiler_begin()
+{
+	return is_profiler_enabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+/// <summary>
+///		Records a phase from begin_counter to now
+/// </summary>
+void profiler_end(enum profile_phase phase, Uint64 begin_counter)
+{
+	if (!is_profiler_enabled || !begin_counter)
+		return;
+
+	int write_index = SDL_AtomicGet(&events_written);
+	struct profile_event* event = &events[write_index & (PROFILER_RING_CAPACITY - 1)];
+
+	event->begin_counter = begin_counter;
+	event->end_counter = SDL_GetPerformanceCounter();
+	event->phase = (Uint32)phase;
+
+	// publish (SDL_AtomicSet is a full barrier so the slot is visible first)
+	SDL_AtomicSet(&events_written, write_index + 1);
+}
+
+/// <summary>
+///		Records how long an input event took to make it to the screen
+/// </summary>
+void profiler_record_input_latency(double latency_ms)
+{
+	if (!is_profiler_enabled)
+		return;
+
+	input_latencies_ms[input_latencies_written % PROFILER_LATENCY_SAMPLES_MAX] = latency_ms;
+	input_latencies_written++;
+}
+
+/// <summary>
+///		Records how long after it was due a simulation tick ran, a tick held up behind a slow frame shows here
+/// </summary>
+void profiler_record_tick_lateness(double lateness_ms)
+{
+	if (!is_profiler_enabled)
+		return;
+
+	tick_latenesses_ms[tick_latenesses_written % PROFILER_LATENCY_SAMPLES_MAX] = lateness_ms;
+	tick_latenesses_written++;
+}
+
+const char* profiler_phase_name(enum profile_phase phase)
+{
+	return phase < PROFILE_PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+/// <summary>
+///		Copies out up to max_events of the newest events, oldest first
+/// </summary>
+/// <returns>How many events were copied</returns>
+static int copy_recent_events(struct profile_event* out, int max_events)
+{
+	int written_end = SDL_AtomicGet(&events_written);
+	int num_events = SDL_min(SDL_min(written_end, PROFILER_RING_CAPACITY), max_events);
+	int written_begin = written_end - num_events;
+
+	for (int i = 0; i < num_events; i++)
+		out[i] = events[(written_begin + i) & (PROFILER_RING_CAPACITY - 1)];
+
+	// anything the writer lapped while we were copying is garbage, drop it from the front
+	// (+1 for the slot it might be halfway through writing)
+	int lapped = SDL_AtomicGet(&events_written) - written_end - (PROFILER_RING_CAPACITY - num_events) + 1;
+
+	if (lapped <= 0)
+		return num_events;
+
+	if (lapped >= num_events)
+		return 0;
+
+	SDL_memmove(out, out + lapped, (num_events - lapped) * sizeof(struct profile_event));
+	return num_events - lapped;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+	double lhs = *(const double*)a;
+	double rhs = *(const double*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+/// <summary>
+///		Sorts a set of durations and fills in the percentiles
+/// </summary>
+static void compute_percentiles(double* durations_ms, int num_samples, struct profile_phase_stats* stats)
+{
+	stats->num_samples = num_samples;
+	stats->p50_ms = stats->p95_ms = stats->p99_ms = stats->max_ms = 0.0;
+
+	if (num_samples == 0)
+		return;
+
+	qsort(durations_ms, num_samples, sizeof(double), compare_doubles);
+	stats->p50_ms = durations_ms[(num_samples * 50) / 100];
+	stats->p95_ms = durations_ms[(num_samples * 95) / 100];
+	stats->p99_ms = durations_ms[(num_samples * 99) / 100];
+	stats->max_ms = durations_ms[num_samples - 1];
+}
+
+/// <summary>
+///		Works out p50/p95/p99/max per phase over the most recent window of events
+/// </summary>
+void profiler_compute_stats(struct profile_phase_stats* stats)
+{
+	static struct profile_event recent_events[PROFILER_STATS_WINDOW];
+	static double durations_ms[PROFILER_STATS_WINDOW];
+
+	int num_events = copy_recent_events(recent_events, PROFILER_STATS_WINDOW);
+	double ms_per_count = 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+	for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++)
+	{
+		struct profile_phase_stats* phase_stats = &stats[phase];
+		int num_samples = 0;
+
+		for (int i = 0; i < num_events; i++)
+		{
+			if (recent_events[i].phase == (Uint32)phase)
+				durations_ms[num_samples++] = (double)(recent_events[i].end_counter - recent_events[i].begin_counter) * ms_per_count;
+		}
+
+		compute_percentiles(durations_ms, num_samples, phase_stats);
+	}
+}
+
+void profiler_compute_input_latency_stats(struct profile_phase_stats* stats)
+{
+	static double sorted_latencies_ms[PROFILER_LATENCY_SAMPLES_MAX];
+	int num_samples = SDL_min(input_latencies_written, PROFILER_LATENCY_SAMPLES_MAX);
+
+	SDL_memcpy(sorted_latencies_ms, input_latencies_ms, num_samples * sizeof(double));
+	compute_percentiles(sorted_latencies_ms, num_samples, stats);
+}
+
+void profiler_compute_tick_lateness_stats(struct profile_phase_stats* stats)
+{
+	static double sorted_latenesses_ms[PROFILER_LATENCY_SAMPLES_MAX];
+	int num_samples = SDL_min(tick_latenesses_written, PROFILER_LATENCY_SAMPLES_MAX);
+
+	SDL_memcpy(sorted_latenesses_ms, tick_latenesses_ms, num_samples * sizeof(double));
+	compute_percentiles(sorted_latenesses_ms, num_samples, stats);
+}
+
+void profiler_print_stats()
+{
+	struct profile_phase_stats stats[PROFILE_PHASE_COUNT];
+	struct profile_phase_stats latency_stats;
+	struct profile_phase_stats lateness_stats;
+	profiler_compute_stats(stats);
+	profiler_compute_input_latency_stats(&latency_stats);
+	profiler_compute_tick_lateness_stats(&lateness_stats);
+
+	printf("%-16s %8s %9s %9s %9s %9s\n", "phase", "samples", "p50 ms", "p95 ms", "p99 ms", "max ms");
+
+	for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++)
+	{
+		printf("%-16s %8d %9.3f %9.3f %9.3f %9.3f\n",
+			phase_names[phase],
+			stats[phase].num_samples,
+			stats[phase].p50_ms,
+			stats[phase].p95_ms,
+			stats[phase].p99_ms,
+			stats[phase].max_ms);
+	}
+
+	printf("%-16s %8d %9.3f %9.3f %9.3f %9.3f\n",
+		"input_to_present",
+		latency_stats.num_samples,
+		latency_stats.p50_ms,
+		latency_stats.p95_ms,
+		latency_stats.p99_ms,
+		latency_stats.max_ms);
+
+	printf("%-16s %8d %9.3f %9.3f %9.3f %9.3f\n",
+		"tick_lateness",
+		lateness_stats.num_samples,
+		lateness_stats.p50_ms,
+		lateness_stats.p95_ms,
+		lateness_stats.p99_ms,
+		lateness_stats.max_ms);
+}
+
+/// <summary>
+///		Draws a bar per phase (p50 green, p95 yellow, p99 red) straight through the renderer,
+///		a full width bar is the whole frame budget
+/// </summary>
+void profiler_render_overlay(SDL_Renderer* renderer, double frame_budget_ms)
+{
+	if (overlay_frames_until_refresh-- <= 0)
+	{
+		profiler_compute_stats(overlay_stats);
+		overlay_frames_until_refresh = PROFILER_OVERLAY_REFRESH_FRAMES;
+	}
+
+	const SDL_Color percentile_colours[] = {
+		{ 0, 200, 0, 255 },
+		{ 230, 200, 0, 255 },
+		{ 220, 0, 0, 255 },
+	};
+
+	SDL_Rect background = {
+		PROFILER_OVERLAY_X - PROFILER_OVERLAY_PADDING,
+		PROFILER_OVERLAY_Y - PROFILER_OVERLAY_PADDING,
+		PROFILER_OVERLAY_BAR_WIDTH_MAX + (PROFILER_OVERLAY_PADDING * 2),
+		(PROFILE_PHASE_COUNT * PROFILER_OVERLAY_ROW_HEIGHT) + (PROFILER_OVERLAY_PADDING * 2)
+	};
+
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(renderer, 40, 40, 40, 200);
+	SDL_RenderFillRect(renderer, &background);
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+	// Widest bar first so the shorter ones stay visible on top
+	for (int percentile = 2; percentile >= 0; percentile--)
+	{
+		SDL_Rect bars[PROFILE_PHASE_COUNT];
+
+		for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++)
+		{
+			const struct profile_phase_stats* phase_stats = &overlay_stats[phase];
+			double ms = percentile == 0 ? phase_stats->p50_ms : percentile == 1 ? phase_stats->p95_ms : phase_stats->p99_ms;
+			int width = (int)((ms / frame_budget_ms) * PROFILER_OVERLAY_BAR_WIDTH_MAX);
+
+			bars[phase].x = PROFILER_OVERLAY_X;
+			bars[phase].y = PROFILER_OVERLAY_Y + (phase * PROFILER_OVERLAY_ROW_HEIGHT);
+			bars[phase].w = SDL_clamp(width, 1, PROFILER_OVERLAY_BAR_WIDTH_MAX);
+			bars[phase].h = PROFILER_OVERLAY_ROW_HEIGHT - 2;
+		}
+
+		const SDL_Color* colour = &percentile_colours[percentile];
+		SDL_SetRenderDrawColor(renderer, colour->r, colour->g, colour->b, colour->a);
+		SDL_RenderFillRects(renderer, bars, PROFILE_PHASE_COUNT);
+	}
+}
+
+/// <summary>
+///		Writes everything still in the ring as Chrome trace_event JSON ("X" complete events, microseconds)
+/// </summary>
+/// <returns>TRUE if the file was written</returns>
+int profiler_write_chrome_trace(const char* path)
+{
+	struct profile_event* trace_events = malloc(PROFILER_RING_CAPACITY * sizeof(struct profile_event));
+
+	if (!trace_events)
+		return FALSE;
+
+	FILE* file = fopen(path, "w");
+
+	if (!file)
+	{
+		printf("Could not open %s to write the trace.\n", path);
+		free(trace_events);
+		return FALSE;
+	}
+
+	int num_events = copy_recent_events(trace_events, PROFILER_RING_CAPACITY);
+	double us_per_count = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	for (int i = 0; i < num_events; i++)
+	{
+		const struct profile_event* event = &trace_events[i];
+
+		fprintf(file, "{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+			phase_names[event->phase],
+			(double)(event->begin_counter - first_counter) * us_per_count,
+			(double)(event->end_counter - event->begin_counter) * us_per_count,
+			i + 1 < num_events ? "," : "");
+	}
+
+	fprintf(file, "]}\n");
+	fclose(file);
+	free(trace_events);
+
+	printf("Wrote %d trace events to %s\n", num_events, path);
+	return TRUE;
+}
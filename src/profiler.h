@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  FRAME PROFILER
+ *  Timestamps each phase of the main loop with the performance counter into
+ *  a lock-free ring buffer, gives p50/p95/p99 per phase for the on-screen
+ *  overlay and dumps Chrome trace_event JSON (chrome://tracing, Perfetto).
+ *  Also keeps input event to present latencies, and how late each
+ *  simulation tick ran (--threaded runs them on their own thread).
+ * #############################################
+ */
+
+enum profile_phase
+{
+	PROFILE_PHASE_FRAME,
+	PROFILE_PHASE_PUMP_EVENTS,
+	PROFILE_PHASE_PROCESS_INPUT,
+	PROFILE_PHASE_UPDATE_PACING,
+	PROFILE_PHASE_UPDATE_SIM,
+	PROFILE_PHASE_UPDATE_PARTICLES,
+	PROFILE_PHASE_RETAIN_INPUT,
+	PROFILE_PHASE_RENDER_CLEAR,
+	PROFILE_PHASE_RENDER_DRAW,
+	PROFILE_PHASE_RENDER_UPLOAD,
+	PROFILE_PHASE_RENDER_PRESENT,
+
+	// NOTE: All phases must be added above this line
+	PROFILE_PHASE_COUNT
+};
+
+struct profile_phase_stats
+{
+	int num_samples;
+	double p50_ms;
+	double p95_ms;
+	double p99_ms;
+	double max_ms;
+};
+
+void profiler_set_enabled(int is_enabled);
+int profiler_is_enabled();
+
+Uint64 profiler_begin();
+void profiler_end(enum profile_phase phase, Uint64 begin_counter);
+
+void profiler_record_input_latency(double latency_ms);
+void profiler_record_tick_lateness(double lateness_ms);
+
+const char* profiler_phase_name(enum profile_phase phase);
+void profiler_compute_stats(struct profile_phase_stats* stats);
+void profiler_compute_input_latency_stats(struct profile_phase_stats* stats);
+void profiler_compute_tick_lateness_stats(struct profile_phase_stats* stats);
+void profiler_print_stats();
+void profiler_render_overlay(SDL_Renderer* renderer, double frame_budget_ms);
+int profiler_write_chrome_trace(const char* path);
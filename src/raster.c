@@ -0,0 +1,289 @@
+#include <string.h>
+#include <SDL.h>
+#include "constants.h"
+#include "simd.h"
+#include "raster.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+typedef void (*fill_span_func)(Uint32* dest, int count, Uint32 colour);
+typedef void (*keyed_span_func)(Uint32* dest, const Uint32* src, int count, Uint32 colour_key, Uint32 key_mask);
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static int simd_level = RASTER_SIMD_SCALAR;
+static fill_span_func fill_span;
+static keyed_span_func keyed_span;
+
+/*
+ * #############################################
+ *  SCALAR
+ * #############################################
+ */
+static void fill_span_scalar(Uint32* dest, int count, Uint32 colour)
+{
+	for (int i = 0; i < count; i++)
+		dest[i] = colour;
+}
+
+static void keyed_span_scalar(Uint32* dest, const Uint32* src, int count, Uint32 colour_key, Uint32 key_mask)
+{
+	colour_key &= key_mask;
+
+	for (int i = 0; i < count; i++)
+	{
+		if ((src[i] & key_mask) != colour_key)
+			dest[i] = src[i];
+	}
+}
+
+#if SIMD_HAS_X86
+/*
+ * #############################################
+ *  SSE2 (4 pixels at a time)
+ * #############################################
+ */
+SIMD_TARGET_SSE2 static void fill_span_sse2(Uint32* dest, int count, Uint32 colour)
+{
+	__m128i colour_x4 = _mm_set1_epi32((int)colour);
+	int i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*)(dest + i), colour_x4);
+
+	for (; i < count; i++)
+		dest[i] = colour;
+}
+
+SIMD_TARGET_SSE2 static void keyed_span_sse2(Uint32* dest, const Uint32* src, int count, Uint32 colour_key, Uint32 key_mask)
+{
+	__m128i key_x4 = _mm_set1_epi32((int)(colour_key & key_mask));
+	__m128i mask_x4 = _mm_set1_epi32((int)key_mask);
+	int i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i src_x4 = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i dest_x4 = _mm_loadu_si128((const __m128i*)(dest + i));
+
+		// all ones where the source pixel is the key, i.e. keep the dest pixel there
+		__m128i is_key = _mm_cmpeq_epi32(_mm_and_si128(src_x4, mask_x4), key_x4);
+		__m128i blended = _mm_or_si128(_mm_and_si128(is_key, dest_x4), _mm_andnot_si128(is_key, src_x4));
+
+		_mm_storeu_si128((__m128i*)(dest + i), blended);
+	}
+
+	keyed_span_scalar(dest + i, src + i, count - i, colour_key, key_mask);
+}
+
+/*
+ * #############################################
+ *  AVX2 (8 pixels at a time)
+ * #############################################
+ */
+SIMD_TARGET_AVX2 static void fill_span_avx2(Uint32* dest, int count, Uint32 colour)
+{
+	__m256i colour_x8 = _mm256_set1_epi32((int)colour);
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_si256((__m256i*)(dest + i), colour_x8);
+
+	for (; i < count; i++)
+		dest[i] = colour;
+}
+
+SIMD_TARGET_AVX2 static void keyed_span_avx2(Uint32* dest, const Uint32* src, int count, Uint32 colour_key, Uint32 key_mask)
+{
+	__m256i key_x8 = _mm256_set1_epi32((int)(colour_key & key_mask));
+	__m256i mask_x8 = _mm256_set1_epi32((int)key_mask);
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i src_x8 = _mm256_loadu_si256((const __m256i*)(src + i));
+		__m256i dest_x8 = _mm256_loadu_si256((const __m256i*)(dest + i));
+
+		// keep the dest pixel wherever the source pixel is the key
+		__m256i is_key = _mm256_cmpeq_epi32(_mm256_and_si256(src_x8, mask_x8), key_x8);
+		_mm256_storeu_si256((__m256i*)(dest + i), _mm256_blendv_epi8(src_x8, dest_x8, is_key));
+	}
+
+	keyed_span_scalar(dest + i, src + i, count - i, colour_key, key_mask);
+}
+#endif
+
+/// <summary>
+///		Picks the best kernels this CPU supports
+/// </summary>
+void init_raster()
+{
+	raster_set_simd_level(simd_detect_level());
+}
+
+int raster_get_simd_level()
+{
+	return simd_level;
+}
+
+/// <summary>
+///		Forces a kernel level (for benchmarking), falls back a level at a time if the CPU can't do it
+/// </summary>
+/// <returns>The level actually in use</returns>
+int raster_set_simd_level(int level)
+{
+	simd_level = simd_supported_level(level);
+
+	switch (simd_level) {
+#if SIMD_HAS_X86
+		case RASTER_SIMD_AVX2:
+			fill_span = fill_span_avx2;
+			keyed_span = keyed_span_avx2;
+			break;
+
+		case RASTER_SIMD_SSE2:
+			fill_span = fill_span_sse2;
+			keyed_span = keyed_span_sse2;
+			break;
+#endif
+
+		default:
+			fill_span = fill_span_scalar;
+			keyed_span = keyed_span_scalar;
+			break;
+	}
+
+	return simd_level;
+}
+
+const char* raster_simd_level_name(int level)
+{
+	return simd_level_name(level);
+}
+
+static Uint32* get_pixel_row(SDL_Surface* surface, int x, int y)
+{
+	return (Uint32*)((Uint8*)surface->pixels + (y * surface->pitch)) + x;
+}
+
+/// <summary>
+///		Clips a src rect and dest position against both surfaces the way SDL_BlitSurface does
+/// </summary>
+/// <returns>FALSE if there's nothing left to draw</returns>
+static int clip_blit(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dest, int* dest_x, int* dest_y, SDL_Rect* clipped_src)
+{
+	SDL_Rect src_bounds = { 0, 0, src->w, src->h };
+	SDL_Rect requested = src_rect ? *src_rect : src_bounds;
+
+	if (!SDL_IntersectRect(&requested, &src_bounds, clipped_src))
+		return FALSE;
+
+	*dest_x += clipped_src->x - requested.x;
+	*dest_y += clipped_src->y - requested.y;
+
+	SDL_Rect dest_rect = { *dest_x, *dest_y, clipped_src->w, clipped_src->h };
+	SDL_Rect clipped_dest;
+
+	if (!SDL_IntersectRect(&dest_rect, &dest->clip_rect, &clipped_dest))
+		return FALSE;
+
+	clipped_src->x += clipped_dest.x - dest_rect.x;
+	clipped_src->y += clipped_dest.y - dest_rect.y;
+	clipped_src->w = clipped_dest.w;
+	clipped_src->h = clipped_dest.h;
+	*dest_x = clipped_dest.x;
+	*dest_y = clipped_dest.y;
+
+	return TRUE;
+}
+
+/// <summary>
+///		Fills a rect (NULL for the whole surface), clipped to the surface
+/// </summary>
+void raster_fill_rect(SDL_Surface* dest, const SDL_Rect* rect, Uint32 colour)
+{
+	SDL_Rect clipped;
+
+	if (!rect)
+		clipped = dest->clip_rect;
+	else if (!SDL_IntersectRect(rect, &dest->clip_rect, &clipped))
+		return;
+
+	for (int y = 0; y < clipped.h; y++)
+		fill_span(get_pixel_row(dest, clipped.x, clipped.y + y), clipped.w, colour);
+}
+
+/// <summary>
+///		Straight copy, no keying or blending
+/// </summary>
+void raster_copy(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dest, int dest_x, int dest_y)
+{
+	SDL_Rect clipped;
+
+	if (!clip_blit(src, src_rect, dest, &dest_x, &dest_y, &clipped))
+		return;
+
+	for (int y = 0; y < clipped.h; y++)
+		memcpy(get_pixel_row(dest, dest_x, dest_y + y), get_pixel_row(src, clipped.x, clipped.y + y), clipped.w * sizeof(Uint32));
+}
+
+/// <summary>
+///		Copies every pixel that isn't the colour key
+/// </summary>
+void raster_blit_keyed(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dest, int dest_x, int dest_y, Uint32 colour_key)
+{
+	SDL_Rect clipped;
+
+	if (!clip_blit(src, src_rect, dest, &dest_x, &dest_y, &clipped))
+		return;
+
+	// the key only compares colour, alpha can be anything in a bitmap (and which bits that is depends on the format)
+	Uint32 key_mask = ~src->format->Amask;
+
+	for (int y = 0; y < clipped.h; y++)
+		keyed_span(get_pixel_row(dest, dest_x, dest_y + y), get_pixel_row(src, clipped.x, clipped.y + y), clipped.w, colour_key, key_mask);
+}
+
+/// <summary>
+///		Nearest neighbour copy of src_rect stretched over dest_rect, clipped to dest. Scalar only, it's for sprites
+///		at a render scale that isn't 1:1 and sizes that match go straight to raster_copy.
+/// </summary>
+/// <param name="src_rect">Has to be inside src</param>
+void raster_copy_scaled(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dest, const SDL_Rect* dest_rect)
+{
+	if (src_rect->w == dest_rect->w && src_rect->h == dest_rect->h)
+	{
+		raster_copy(src, src_rect, dest, dest_rect->x, dest_rect->y);
+		return;
+	}
+
+	SDL_Rect clipped;
+
+	if (src_rect->w <= 0 || src_rect->h <= 0 || !SDL_IntersectRect(dest_rect, &dest->clip_rect, &clipped))
+		return;
+
+	// 16.16 fixed point steps through src a dest pixel, each dest pixel samples src under its centre
+	Uint32 step_x = ((Uint32)src_rect->w << 16) / (Uint32)dest_rect->w;
+	Uint32 step_y = ((Uint32)src_rect->h << 16) / (Uint32)dest_rect->h;
+	Uint32 first_src_x = ((Uint32)(clipped.x - dest_rect->x) * step_x) + (step_x / 2);
+
+	for (int y = 0; y < clipped.h; y++)
+	{
+		Uint32 src_y = (((Uint32)(clipped.y + y - dest_rect->y) * step_y) + (step_y / 2)) >> 16;
+		const Uint32* src_row = get_pixel_row(src, src_rect->x, src_rect->y + (int)src_y);
+		Uint32* dest_row = get_pixel_row(dest, clipped.x, clipped.y + y);
+		Uint32 src_x = first_src_x;
+
+		for (int x = 0; x < clipped.w; x++)
+		{
+			dest_row[x] = src_row[src_x >> 16];
+			src_x += step_x;
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SDL.h>
+#include "simd.h"
+
+/*
+ * #############################################
+ *  SOFTWARE RASTER KERNELS
+ *  Span fills, straight copies, colour keyed blits and nearest neighbour
+ *  scaled copies for 32bpp surfaces (src and dest in the same pixel
+ *  format), picked at runtime from AVX2/SSE2/scalar depending on what
+ *  the CPU has
+ * #############################################
+ */
+
+#define RASTER_SIMD_SCALAR SIMD_LEVEL_SCALAR
+#define RASTER_SIMD_SSE2 SIMD_LEVEL_SSE2
+#define RASTER_SIMD_AVX2 SIMD_LEVEL_AVX2
+
+void init_raster();
+int raster_get_simd_level();
+int raster_set_simd_level(int level);
+const char* raster_simd_level_name(int level);
+
+void raster_fill_rect(SDL_Surface* dest, const SDL_Rect* rect, Uint32 colour);
+void raster_copy(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dest, int dest_x, int dest_y);
+void raster_blit_keyed(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dest, int dest_x, int dest_y, Uint32 colour_key);
+void raster_copy_scaled(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dest, const SDL_Rect* dest_rect);
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+#include "render_hw.h"
+#include "hud.h"
+#include "baked_assets.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct hw_draw_list
+{
+	SDL_Vertex vertices[HW_DRAW_LIST_QUADS_MAX * 4];
+	int indices[HW_DRAW_LIST_QUADS_MAX * 6];
+	int num_quads;
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static SDL_Texture* atlas_texture;
+
+static struct hw_draw_list draw_list;
+
+// Static layer (title, net, game over) kept in a render target, only redrawn when the screen changes
+static SDL_Texture* static_layer_texture;
+static Uint8 static_layer_screen_index = GAME_SCREEN_NONE_INDEX;
+static int static_layer_points[PADDLES_NUM_MAX];
+
+/// <summary>
+///		Uploads the baked sprite atlas (title, number map, game over and a white block for solid shapes)
+/// </summary>
+int init_hw_renderer(SDL_Renderer* renderer, SDL_Surface* atlas)
+{
+	// keyed pixels were baked fully clear, so blending does the colour keying
+	atlas_texture = SDL_CreateTextureFromSurface(renderer, atlas);
+
+	if (!atlas_texture)
+	{
+		printf("Could not create atlas_texture. SDL Err: %s\n", SDL_GetError());
+		return FALSE;
+	}
+
+	SDL_SetTextureBlendMode(atlas_texture, SDL_BLENDMODE_BLEND);
+
+	// Not every renderer does render targets, without one we just draw the static bits every frame
+	static_layer_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	if (static_layer_texture)
+		SDL_SetTextureBlendMode(static_layer_texture, SDL_BLENDMODE_NONE);
+
+	invalidate_hw_static_layer();
+
+	// Every quad is two triangles over the same four corners so the indices never change
+	for (int i = 0; i < HW_DRAW_LIST_QUADS_MAX; i++)
+	{
+		int* quad_indices = &draw_list.indices[i * 6];
+		int first_vertex = i * 4;
+
+		quad_indices[0] = first_vertex + 0;
+		quad_indices[1] = first_vertex + 1;
+		quad_indices[2] = first_vertex + 2;
+		quad_indices[3] = first_vertex + 2;
+		quad_indices[4] = first_vertex + 3;
+		quad_indices[5] = first_vertex + 0;
+	}
+
+	return TRUE;
+}
+
+void release_hw_renderer()
+{
+	if (atlas_texture)
+		SDL_DestroyTexture(atlas_texture);
+
+	if (static_layer_texture)
+		SDL_DestroyTexture(static_layer_texture);
+
+	atlas_texture = NULL;
+	static_layer_texture = NULL;
+}
+
+/// <summary>
+///		Forces the static layer to be redrawn next frame (e.g. the renderer lost its render targets)
+/// </summary>
+void invalidate_hw_static_layer()
+{
+	static_layer_screen_index = GAME_SCREEN_NONE_INDEX;
+}
+
+/// <summary>
+///		Queues a textured quad, src is in atlas pixels and dest in screen pixels
+/// </summary>
+static void push_quad(const SDL_Rect* src, float dest_x, float dest_y, float dest_w, float dest_h)
+{
+	if (draw_list.num_quads >= HW_DRAW_LIST_QUADS_MAX)
+		return;
+
+	SDL_Vertex* quad = &draw_list.vertices[draw_list.num_quads * 4];
+	SDL_Color white = { 255, 255, 255, 255 };
+
+	float u0 = (float)src->x / baked_atlas_width;
+	float v0 = (float)src->y / baked_atlas_height;
+	float u1 = (float)(src->x + src->w) / baked_atlas_width;
+	float v1 = (float)(src->y + src->h) / baked_atlas_height;
+
+	quad[0].position.x = dest_x;          quad[0].position.y = dest_y;          quad[0].tex_coord.x = u0; quad[0].tex_coord.y = v0;
+	quad[1].position.x = dest_x + dest_w; quad[1].position.y = dest_y;          quad[1].tex_coord.x = u1; quad[1].tex_coord.y = v0;
+	quad[2].position.x = dest_x + dest_w; quad[2].position.y = dest_y + dest_h; quad[2].tex_coord.x = u1; quad[2].tex_coord.y = v1;
+	quad[3].position.x = dest_x;          quad[3].position.y = dest_y + dest_h; quad[3].tex_coord.x = u0; quad[3].tex_coord.y = v1;
+
+	for (int i = 0; i < 4; i++)
+		quad[i].color = white;
+
+	draw_list.num_quads++;
+}
+
+/// <summary>
+///		Queues a solid white quad by sampling the middle of the atlas' white block
+/// </summary>
+static void push_solid_quad(float dest_x, float dest_y, float dest_w, float dest_h)
+{
+	SDL_Rect white_texel = { baked_white_rect.x + (baked_white_rect.w / 2), baked_white_rect.y + (baked_white_rect.h / 2), 0, 0 };
+	push_quad(&white_texel, dest_x, dest_y, dest_w, dest_h);
+}
+
+static void push_net(int screen_w, int screen_h)
+{
+	int num_dashes_and_gaps = (NET_NUM_DASHES * 2);
+	int dash_h = screen_h / num_dashes_and_gaps;
+	int dash_y = dash_h;
+
+	for (int i = 0; i < NET_NUM_DASHES; i++)
+	{
+		push_solid_quad((float)(screen_w / 2), (float)dash_y, NET_DASH_WIDTH, (float)dash_h);
+		dash_y += dash_h * 2;
+	}
+}
+
+/// <summary>
+///		Queues the HUD glyphs, they go in the same draw call as the moving objects
+/// </summary>
+static void push_hud(const struct hud_glyph* glyphs, int num_glyphs)
+{
+	for (int i = 0; i < num_glyphs; i++)
+		push_quad(&glyphs[i].src, (float)glyphs[i].x, (float)glyphs[i].y, (float)glyphs[i].src.w, (float)glyphs[i].src.h);
+}
+
+static void push_game_objects(const struct ball* ball, const struct paddle* paddles)
+{
+	push_solid_quad(ball->x, ball->y, ball->width, ball->height);
+
+	for (int i = 0; i < PADDLES_NUM_MAX; i++)
+		push_solid_quad(paddles[i].x, paddles[i].y, paddles[i].width, paddles[i].height);
+}
+
+static void push_game_screen_static(int screen_w, int screen_h)
+{
+	push_net(screen_w, screen_h);
+}
+
+static void push_title_screen(int screen_w, int screen_h)
+{
+	push_quad(
+		&baked_title_rect,
+		(float)((screen_w / 2) - (baked_title_rect.w / 2)),
+		(float)((screen_h / 2) - (baked_title_rect.h / 2)),
+		(float)baked_title_rect.w,
+		(float)baked_title_rect.h
+	);
+}
+
+static void push_game_over_screen(int screen_w, int screen_h, const struct round* round)
+{
+	const int winning_player_index = round->players[0].score.points > round->players[1].score.points ? 0 : 1;
+
+	SDL_Rect msg = baked_game_over_rect;
+	msg.h = GAME_SCREEN_GAME_OVER_MSG_HEIGHT;
+	msg.y += winning_player_index * GAME_SCREEN_GAME_OVER_MSG_OFFSET;
+
+	push_quad(
+		&msg,
+		(float)((screen_w / 2) - (msg.w / 2)),
+		(float)((screen_h / 2) - (GAME_SCREEN_GAME_OVER_MSG_HEIGHT / 2)),
+		(float)msg.w,
+		(float)msg.h
+	);
+}
+
+/// <summary>
+///		Queues everything on the current screen that doesn't move
+/// </summary>
+static void push_static_screen(const struct game_screen* screen, const struct round* round)
+{
+	switch (screen->index) {
+		case GAME_SCREEN_TITLE_INDEX:
+			push_title_screen(WINDOW_WIDTH, WINDOW_HEIGHT);
+			break;
+
+		case GAME_SCREEN_GAME_INDEX:
+			push_game_screen_static(WINDOW_WIDTH, WINDOW_HEIGHT);
+			break;
+
+		case GAME_SCREEN_GAME_OVER_INDEX:
+			push_game_over_screen(WINDOW_WIDTH, WINDOW_HEIGHT, round);
+			break;
+	}
+}
+
+/// <summary>
+///		Submits the queued quads as one draw call and empties the list
+/// </summary>
+static void flush_draw_list(SDL_Renderer* renderer)
+{
+	if (draw_list.num_quads > 0)
+		SDL_RenderGeometry(renderer, atlas_texture, draw_list.vertices, draw_list.num_quads * 4, draw_list.indices, draw_list.num_quads * 6);
+
+	draw_list.num_quads = 0;
+}
+
+/// <summary>
+///		Queues the chaos mode balls, flushing whenever the list fills up (one draw call per HW_DRAW_LIST_QUADS_MAX balls)
+/// </summary>
+static void push_ball_swarm(SDL_Renderer* renderer, const struct ball_swarm* swarm)
+{
+	for (int i = 0; i < swarm->count; i++)
+	{
+		if (draw_list.num_quads >= HW_DRAW_LIST_QUADS_MAX)
+			flush_draw_list(renderer);
+
+		push_solid_quad(swarm->x[i], swarm->y[i], BALL_SIZE, BALL_SIZE);
+	}
+}
+
+/// <summary>
+///		Redraws the static layer render target if the screen has changed since it was drawn
+/// </summary>
+static void refresh_static_layer(SDL_Renderer* renderer, const struct game_screen* screen, const struct round* round)
+{
+	int is_stale = static_layer_screen_index != screen->index;
+
+	// the game over screen says who won, nothing else in the layer depends on the score
+	if (screen->index == GAME_SCREEN_GAME_OVER_INDEX)
+	{
+		for (int i = 0; i < PADDLES_NUM_MAX; i++)
+			is_stale |= static_layer_points[i] != round->players[i].score.points;
+	}
+
+	if (!is_stale)
+		return;
+
+	SDL_SetRenderTarget(renderer, static_layer_texture);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+	SDL_RenderClear(renderer);
+
+	push_static_screen(screen, round);
+	flush_draw_list(renderer);
+
+	SDL_SetRenderTarget(renderer, NULL);
+
+	static_layer_screen_index = screen->index;
+
+	for (int i = 0; i < PADDLES_NUM_MAX; i++)
+		static_layer_points[i] = round->players[i].score.points;
+}
+
+/// <summary>
+///		Copies the static layer over the screen then submits the HUD and moving objects in one go
+/// </summary>
+void render_hw_frame(
+	SDL_Renderer* renderer,
+	const struct game_screen* screen,
+	const struct round* round,
+	const struct ball* ball,
+	const struct paddle* paddles,
+	const struct ball_swarm* swarm,
+	const struct hud_glyph* hud_glyphs,
+	int num_hud_glyphs
+)
+{
+	draw_list.num_quads = 0;
+
+	if (static_layer_texture)
+	{
+		refresh_static_layer(renderer, screen, round);
+		SDL_RenderCopy(renderer, static_layer_texture, NULL, NULL);
+	}
+	else
+	{
+		push_static_screen(screen, round);
+	}
+
+	push_hud(hud_glyphs, num_hud_glyphs);
+
+	if (screen->index == GAME_SCREEN_GAME_INDEX)
+	{
+		push_game_objects(ball, paddles);
+
+		// the net has always gone over the ball and paddles, so it's queued again on top of the static layer's copy
+		push_net(WINDOW_WIDTH, WINDOW_HEIGHT);
+		push_ball_swarm(renderer, swarm);
+	}
+
+	flush_draw_list(renderer);
+}
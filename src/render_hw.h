@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL.h>
+#include "types.h"
+#include "ball_swarm.h"
+#include "hud.h"
+
+/*
+ * #############################################
+ *  HARDWARE RENDERER
+ *  Draws straight through SDL_Renderer from one sprite atlas texture,
+ *  each frame is a copy of the cached static layer plus a single
+ *  SDL_RenderGeometry call for the HUD and moving objects
+ * #############################################
+ */
+
+int init_hw_renderer(SDL_Renderer* renderer, SDL_Surface* atlas);
+void release_hw_renderer();
+void invalidate_hw_static_layer();
+
+void render_hw_frame(
+	SDL_Renderer* renderer,
+	const struct game_screen* screen,
+	const struct round* round,
+	const struct ball* ball,
+	const struct paddle* paddles,
+	const struct ball_swarm* swarm,
+	const struct hud_glyph* hud_glyphs,
+	int num_hud_glyphs
+);
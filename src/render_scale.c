@@ -0,0 +1,62 @@
+#include <SDL.h>
+#include "constants.h"
+#include "render_scale.h"
+
+void init_render_scale_controller(struct render_scale_controller* controller, int percent, int min_percent, int max_percent)
+{
+	SDL_zerop(controller);
+	controller->min_percent = min_percent;
+	controller->max_percent = SDL_max(max_percent, min_percent);
+	controller->percent = SDL_clamp(percent, controller->min_percent, controller->max_percent);
+}
+
+/// <summary>
+///		Feeds in how long the last frame took to draw and upload
+/// </summary>
+/// <param name="frame_budget_ms">The whole frame at the target rate, drawing gets RENDER_SCALE_BUDGET_FRACTION of it</param>
+/// <returns>TRUE if the percentage changed</returns>
+int update_render_scale_controller(struct render_scale_controller* controller, double render_ms, double frame_budget_ms)
+{
+	controller->num_samples++;
+
+	// the first frames at a new size redraw everything, they say nothing about the frames after
+	if (controller->num_samples <= RENDER_SCALE_SKIP_FRAMES)
+		return FALSE;
+
+	if (controller->num_samples == RENDER_SCALE_SKIP_FRAMES + 1)
+		controller->smoothed_ms = render_ms;
+	else
+		controller->smoothed_ms += (render_ms - controller->smoothed_ms) * RENDER_SCALE_SMOOTHING;
+
+	if (controller->num_samples < RENDER_SCALE_SETTLE_FRAMES || controller->smoothed_ms <= 0.0)
+		return FALSE;
+
+	double target_ms = frame_budget_ms * RENDER_SCALE_BUDGET_FRACTION;
+	int percent = controller->percent;
+
+	if (controller->smoothed_ms > target_ms)
+	{
+		// cost goes with the pixel count, so the side length that fits goes with the square root
+		int fitting_percent = (int)(percent * SDL_sqrt(target_ms / controller->smoothed_ms));
+		fitting_percent = (fitting_percent / RENDER_SCALE_PERCENT_STEP) * RENDER_SCALE_PERCENT_STEP;
+		percent = SDL_min(fitting_percent, percent - RENDER_SCALE_PERCENT_STEP);
+	}
+	else if (percent < controller->max_percent)
+	{
+		int next_percent = SDL_min(percent + RENDER_SCALE_PERCENT_STEP, controller->max_percent);
+		double growth = (double)next_percent / (double)percent;
+
+		if (controller->smoothed_ms * growth * growth < target_ms * RENDER_SCALE_RAISE_FRACTION)
+			percent = next_percent;
+	}
+
+	percent = SDL_clamp(percent, controller->min_percent, controller->max_percent);
+
+	if (percent == controller->percent)
+		return FALSE;
+
+	controller->percent = percent;
+	controller->num_samples = 0;
+
+	return TRUE;
+}
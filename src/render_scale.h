@@ -0,0 +1,33 @@
+#pragma once
+
+/*
+ * #############################################
+ *  DYNAMIC RENDER SCALE
+ *  Picks the resolution the software renderer draws at, as a percentage
+ *  of the game's WINDOW_WIDTH x WINDOW_HEIGHT, from how long drawing and
+ *  uploading a frame has been taking. Drawing costs roughly the number of
+ *  pixels, so the percentage goes as the square root of the cost. Over
+ *  the budget it drops straight to the percentage that should fit. Under
+ *  it, it only climbs a step at a time, and only once the next step up
+ *  should still fit comfortably, so it doesn't bounce between two sizes.
+ *  After every change it waits a few frames: the first frame at a new
+ *  size redraws everything and would look far slower than the rest.
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct render_scale_controller
+{
+	int percent;
+	int min_percent;
+	int max_percent;
+	double smoothed_ms; // render time moving average since the last change
+	int num_samples; // frames since the last change
+};
+
+void init_render_scale_controller(struct render_scale_controller* controller, int percent, int min_percent, int max_percent);
+int update_render_scale_controller(struct render_scale_controller* controller, double render_ms, double frame_budget_ms);
@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "constants.h"
+#include "types.h"
+#include "replay.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+
+// NOTE: num_ticks and final_state_hash are patched in when the recording ends,
+// a log from a crashed session has is_finished = FALSE and replays up to the last tick on disk
+struct replay_file_header
+{
+	char magic[8];
+	Uint32 version;
+	Uint32 snapshot_size;
+	Uint32 ticks_per_second;
+	Uint32 is_finished;
+	Uint32 num_ticks;
+	Uint32 final_state_hash;
+	struct game_snapshot initial_state;
+};
+
+// One byte per controller then one for the commands, two buttons a byte:
+// bit 0 = ended_down, bits 1-3 = half_transition_count (clamped)
+struct replay_tick
+{
+	Uint8 controllers[GAME_CONTROLLERS_MAX];
+	Uint8 commands;
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static FILE* record_file = NULL;
+static struct replay_file_header record_header;
+
+static FILE* playback_file = NULL;
+static struct replay_file_header playback_header;
+static Uint32 playback_ticks_read;
+
+/// <summary>
+///		Packs a button into 4 bits
+/// </summary>
+static Uint8 pack_button(const struct game_button_state* button)
+{
+	int transitions = button->half_transition_count;
+
+	if (transitions > REPLAY_BUTTON_TRANSITIONS_MAX)
+		transitions = REPLAY_BUTTON_TRANSITIONS_MAX;
+
+	return (Uint8)((button->ended_down ? 1 : 0) | (transitions << 1));
+}
+
+static void unpack_button(Uint8 bits, struct game_button_state* button)
+{
+	button->ended_down = bits & 1;
+	button->half_transition_count = (bits >> 1) & REPLAY_BUTTON_TRANSITIONS_MAX;
+}
+
+/// <summary>
+///		FNV-1a over the snapshot, padding is zeroed by whoever captured it so it hashes the same every time
+/// </summary>
+Uint32 replay_hash_snapshot(const struct game_snapshot* snapshot)
+{
+	const Uint8* bytes = (const Uint8*)snapshot;
+	Uint32 hash = 2166136261u;
+
+	for (size_t i = 0; i < sizeof(*snapshot); i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+int replay_begin_recording(const char* path, const struct game_snapshot* initial_state)
+{
+	record_file = fopen(path, "wb");
+
+	if (!record_file)
+	{
+		printf("Could not open %s to record the input.\n", path);
+		return FALSE;
+	}
+
+	SDL_zero(record_header);
+	memcpy(record_header.magic, REPLAY_FILE_MAGIC, sizeof(REPLAY_FILE_MAGIC));
+	record_header.version = REPLAY_FILE_VERSION;
+	record_header.snapshot_size = sizeof(struct game_snapshot);
+	record_header.ticks_per_second = SIM_TICKS_PER_SECOND;
+	record_header.initial_state = *initial_state;
+
+	fwrite(&record_header, sizeof(record_header), 1, record_file);
+
+	return TRUE;
+}
+
+int replay_is_recording()
+{
+	return record_file != NULL;
+}
+
+/// <summary>
+///		Appends the input one simulation tick is about to consume, does nothing if we aren't recording
+/// </summary>
+void replay_record_tick(const struct game_input* input)
+{
+	if (!record_file)
+		return;
+
+	struct replay_tick tick;
+
+	for (size_t i = 0; i < GAME_CONTROLLERS_MAX; i++)
+	{
+		const struct game_controller_input* controller = &input->controllers[i];
+		tick.controllers[i] = pack_button(&controller->move_up) | (pack_button(&controller->move_down) << 4);
+	}
+
+	tick.commands = pack_button(&input->start) | (pack_button(&input->reset) << 4);
+
+	fwrite(&tick, sizeof(tick), 1, record_file);
+	record_header.num_ticks++;
+}
+
+void replay_end_recording(const struct game_snapshot* final_state)
+{
+	if (!record_file)
+		return;
+
+	record_header.is_finished = TRUE;
+	record_header.final_state_hash = replay_hash_snapshot(final_state);
+
+	// the header is fixed size so we can just write the finished one over the top
+	fseek(record_file, 0, SEEK_SET);
+	fwrite(&record_header, sizeof(record_header), 1, record_file);
+	fclose(record_file);
+	record_file = NULL;
+
+	printf("Recorded %u ticks.\n", record_header.num_ticks);
+}
+
+int replay_open(const char* path, struct game_snapshot* initial_state)
+{
+	playback_file = fopen(path, "rb");
+
+	if (!playback_file)
+	{
+		printf("Could not open replay %s.\n", path);
+		return FALSE;
+	}
+
+	if (fread(&playback_header, sizeof(playback_header), 1, playback_file) != 1 ||
+		memcmp(playback_header.magic, REPLAY_FILE_MAGIC, sizeof(REPLAY_FILE_MAGIC)) != 0 ||
+		playback_header.version != REPLAY_FILE_VERSION)
+	{
+		printf("%s is not a replay from this version of the game.\n", path);
+		replay_close();
+		return FALSE;
+	}
+
+	if (playback_header.snapshot_size != sizeof(struct game_snapshot) || playback_header.ticks_per_second != SIM_TICKS_PER_SECOND)
+	{
+		printf("%s was recorded by a different build (snapshot size %u, %u ticks/sec).\n", path, playback_header.snapshot_size, playback_header.ticks_per_second);
+		replay_close();
+		return FALSE;
+	}
+
+	*initial_state = playback_header.initial_state;
+	playback_ticks_read = 0;
+
+	return TRUE;
+}
+
+/// <summary>
+///		Fills in the input for the next recorded tick
+/// </summary>
+/// <returns>FALSE once there are no ticks left</returns>
+int replay_read_tick(struct game_input* input)
+{
+	if (!playback_file)
+		return FALSE;
+
+	if (playback_header.is_finished && playback_ticks_read >= playback_header.num_ticks)
+		return FALSE;
+
+	struct replay_tick tick;
+
+	if (fread(&tick, sizeof(tick), 1, playback_file) != 1)
+		return FALSE;
+
+	for (size_t i = 0; i < GAME_CONTROLLERS_MAX; i++)
+	{
+		struct game_controller_input* controller = &input->controllers[i];
+		controller->is_connected = TRUE;
+		controller->is_analogue = FALSE;
+		unpack_button(tick.controllers[i] & 0x0F, &controller->move_up);
+		unpack_button(tick.controllers[i] >> 4, &controller->move_down);
+	}
+
+	unpack_button(tick.commands & 0x0F, &input->start);
+	unpack_button(tick.commands >> 4, &input->reset);
+
+	input->dt_for_frame = SIM_DT_S;
+	playback_ticks_read++;
+
+	return TRUE;
+}
+
+/// <summary>
+///		Compares where the replay ended up with where the recorded session ended up
+/// </summary>
+/// <returns>TRUE if they match, FALSE if the replay diverged, -1 if the recording never finished</returns>
+int replay_check_final_state(const struct game_snapshot* final_state)
+{
+	if (!playback_header.is_finished)
+		return -1;
+
+	return replay_hash_snapshot(final_state) == playback_header.final_state_hash;
+}
+
+void replay_close()
+{
+	if (playback_file)
+		fclose(playback_file);
+
+	playback_file = NULL;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <SDL.h>
+#include "types.h"
+
+/*
+ * #############################################
+ *  INPUT RECORDING / REPLAY
+ *  Logs the starting game state and the input every simulation tick consumed,
+ *  playing the log back through update_match() rebuilds the match bit for bit.
+ *  The log is raw structs so it only replays on the same build it came from
+ *  (the header checks the snapshot size and tick rate as a sanity check).
+ * #############################################
+ */
+
+int replay_begin_recording(const char* path, const struct game_snapshot* initial_state);
+int replay_is_recording();
+void replay_record_tick(const struct game_input* input);
+void replay_end_recording(const struct game_snapshot* final_state);
+
+int replay_open(const char* path, struct game_snapshot* initial_state);
+int replay_read_tick(struct game_input* input);
+int replay_check_final_state(const struct game_snapshot* final_state);
+void replay_close();
+
+Uint32 replay_hash_snapshot(const struct game_snapshot* snapshot);
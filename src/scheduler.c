@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <SDL.h>
+#include "constants.h"
+#include "scheduler.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct scheduler_range
+{
+	int begin;
+	int end;
+};
+
+// Each worker has its own deque of ranges: it pushes and pops at the bottom, idle workers steal from the top.
+// A range bigger than the grain gets split in half with the top half pushed back, so the oldest
+// (biggest) ranges are the ones stolen and a deque never holds more than log2(count) of them
+struct scheduler_worker
+{
+	int index;
+	SDL_Thread* thread;
+	SDL_SpinLock lock;
+	int top;
+	int bottom;
+	struct scheduler_range ranges[SCHEDULER_DEQUE_CAPACITY]; // also keeps neighbouring workers' locks off the same cache line
+	Uint64 num_steals;
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static struct scheduler_worker workers[SCHEDULER_THREADS_MAX];
+static int num_workers = 1;
+static SDL_sem* start_semaphore;
+static SDL_sem* done_semaphore;
+static int is_quitting = FALSE;
+
+// The job in flight, written before the workers are woken so they see it after SDL_SemWait
+static scheduler_job_func job_func;
+static void* job_user_data;
+static int job_grain = 1;
+static SDL_atomic_t num_items_left;
+
+static int push_range(struct scheduler_worker* worker, struct scheduler_range range)
+{
+	int is_pushed = FALSE;
+	SDL_AtomicLock(&worker->lock);
+
+	if (worker->bottom - worker->top < SCHEDULER_DEQUE_CAPACITY)
+	{
+		worker->ranges[worker->bottom++ & (SCHEDULER_DEQUE_CAPACITY - 1)] = range;
+		is_pushed = TRUE;
+	}
+
+	SDL_AtomicUnlock(&worker->lock);
+
+	return is_pushed;
+}
+
+static int pop_range(struct scheduler_worker* worker, struct scheduler_range* range)
+{
+	int is_popped = FALSE;
+	SDL_AtomicLock(&worker->lock);
+
+	if (worker->bottom > worker->top)
+	{
+		*range = worker->ranges[--worker->bottom & (SCHEDULER_DEQUE_CAPACITY - 1)];
+		is_popped = TRUE;
+	}
+
+	SDL_AtomicUnlock(&worker->lock);
+
+	return is_popped;
+}
+
+/// <summary>
+///		Takes the oldest range off the first other worker that has one
+/// </summary>
+static int steal_range(struct scheduler_worker* thief, struct scheduler_range* range)
+{
+	for (int offset = 1; offset < num_workers; offset++)
+	{
+		struct scheduler_worker* victim = &workers[(thief->index + offset) % num_workers];
+		int is_stolen = FALSE;
+		SDL_AtomicLock(&victim->lock);
+
+		if (victim->bottom > victim->top)
+		{
+			*range = victim->ranges[victim->top++ & (SCHEDULER_DEQUE_CAPACITY - 1)];
+			is_stolen = TRUE;
+		}
+
+		SDL_AtomicUnlock(&victim->lock);
+
+		if (is_stolen)
+		{
+			thief->num_steals++;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/// <summary>
+///		Works through this worker's ranges then everyone else's until every item has been run
+/// </summary>
+static void run_worker(struct scheduler_worker* worker)
+{
+	for (;;)
+	{
+		struct scheduler_range range;
+
+		if (!pop_range(worker, &range) && !steal_range(worker, &range))
+		{
+			if (SDL_AtomicGet(&num_items_left) == 0)
+				return;
+
+			// the last ranges are still being run somewhere, let that thread have the core if we're sharing one
+			SDL_Delay(0);
+			continue;
+		}
+
+		// split down to the grain, the halves we push back are what the other workers steal
+		while (range.end - range.begin > job_grain)
+		{
+			struct scheduler_range top_half = { range.begin + ((range.end - range.begin) / 2), range.end };
+
+			if (!push_range(worker, top_half))
+				break;
+
+			range.end = top_half.begin;
+		}
+
+		job_func(range.begin, range.end, job_user_data);
+		SDL_AtomicAdd(&num_items_left, -(range.end - range.begin));
+	}
+}
+
+static int run_worker_thread(void* data)
+{
+	struct scheduler_worker* worker = data;
+
+	for (;;)
+	{
+		SDL_SemWait(start_semaphore);
+
+		if (is_quitting)
+			return 0;
+
+		run_worker(worker);
+		SDL_SemPost(done_semaphore);
+	}
+}
+
+/// <summary>
+///		Starts the worker threads, num_threads counts the calling thread (0 for one per core)
+/// </summary>
+int init_scheduler(int num_threads)
+{
+	if (num_threads <= 0)
+		num_threads = SDL_GetCPUCount();
+
+	num_workers = SDL_max(1, SDL_min(num_threads, SCHEDULER_THREADS_MAX));
+	is_quitting = FALSE;
+	SDL_memset(workers, 0, sizeof(workers));
+
+	for (int i = 0; i < num_workers; i++)
+		workers[i].index = i;
+
+	if (num_workers == 1)
+		return TRUE;
+
+	start_semaphore = SDL_CreateSemaphore(0);
+	done_semaphore = SDL_CreateSemaphore(0);
+
+	if (!start_semaphore || !done_semaphore)
+	{
+		printf("Could not create the scheduler semaphores: %s\n", SDL_GetError());
+		release_scheduler();
+		return FALSE;
+	}
+
+	// worker 0 is whoever calls scheduler_parallel_for
+	for (int i = 1; i < num_workers; i++)
+	{
+		workers[i].thread = SDL_CreateThread(run_worker_thread, "pong worker", &workers[i]);
+
+		if (!workers[i].thread)
+		{
+			printf("Could not start scheduler worker %d: %s\n", i, SDL_GetError());
+			num_workers = i;
+			release_scheduler();
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+void release_scheduler()
+{
+	is_quitting = TRUE;
+
+	for (int i = 1; i < num_workers; i++)
+		SDL_SemPost(start_semaphore);
+
+	for (int i = 1; i < num_workers; i++)
+		SDL_WaitThread(workers[i].thread, NULL);
+
+	if (start_semaphore)
+		SDL_DestroySemaphore(start_semaphore);
+
+	if (done_semaphore)
+		SDL_DestroySemaphore(done_semaphore);
+
+	start_semaphore = done_semaphore = NULL;
+	num_workers = 1;
+}
+
+int scheduler_get_num_threads()
+{
+	return num_workers;
+}
+
+/// <summary>
+///		How many ranges have been run by a worker other than the one they were handed to, since init
+/// </summary>
+Uint64 scheduler_get_num_steals()
+{
+	Uint64 num_steals = 0;
+
+	for (int i = 0; i < num_workers; i++)
+		num_steals += workers[i].num_steals;
+
+	return num_steals;
+}
+
+/// <summary>
+///		Runs job over items [0, count) in ranges of at most grain items spread across every worker, returns once they've all run
+/// </summary>
+void scheduler_parallel_for(int count, int grain, scheduler_job_func job, void* user_data)
+{
+	if (count <= 0)
+		return;
+
+	job_func = job;
+	job_user_data = user_data;
+	job_grain = SDL_max(grain, 1);
+	SDL_AtomicSet(&num_items_left, count);
+
+	// everyone starts with an even slice, stealing evens out whatever the slices end up costing
+	for (int i = 0; i < num_workers; i++)
+	{
+		struct scheduler_range range = { (int)((Sint64)count * i / num_workers), (int)((Sint64)count * (i + 1) / num_workers) };
+		workers[i].top = workers[i].bottom = 0;
+
+		if (range.end > range.begin)
+			push_range(&workers[i], range);
+	}
+
+	for (int i = 1; i < num_workers; i++)
+		SDL_SemPost(start_semaphore);
+
+	run_worker(&workers[0]);
+
+	// the deques get reset next time round so every worker has to be out of run_worker first
+	for (int i = 1; i < num_workers; i++)
+		SDL_SemWait(done_semaphore);
+}
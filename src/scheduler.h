@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  SCHEDULER
+ *  Work stealing thread pool for running the same job over lots of
+ *  independent items (matches) across every core. The calling thread
+ *  works too, so with 1 thread everything just runs inline.
+ * #############################################
+ */
+
+// Runs items [begin, end), called from whichever thread picked the range up
+typedef void (*scheduler_job_func)(int begin, int end, void* user_data);
+
+int init_scheduler(int num_threads);
+void release_scheduler();
+
+int scheduler_get_num_threads();
+Uint64 scheduler_get_num_steals();
+
+void scheduler_parallel_for(int count, int grain, scheduler_job_func job, void* user_data);
@@ -0,0 +1,39 @@
+#include <SDL.h>
+#include "simd.h"
+
+/// <summary>
+///		The best level this CPU can run
+/// </summary>
+int simd_detect_level()
+{
+	return simd_supported_level(SIMD_LEVEL_AVX2);
+}
+
+/// <summary>
+///		Falls back a level at a time until the CPU can run it
+/// </summary>
+int simd_supported_level(int level)
+{
+#if SIMD_HAS_X86
+	if (level >= SIMD_LEVEL_AVX2 && SDL_HasAVX2())
+		return SIMD_LEVEL_AVX2;
+
+	if (level >= SIMD_LEVEL_SSE2 && SDL_HasSSE2())
+		return SIMD_LEVEL_SSE2;
+#endif
+
+	return SIMD_LEVEL_SCALAR;
+}
+
+const char* simd_level_name(int level)
+{
+	switch (level) {
+		case SIMD_LEVEL_AVX2:
+			return "avx2";
+
+		case SIMD_LEVEL_SSE2:
+			return "sse2";
+	}
+
+	return "scalar";
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  SIMD SUPPORT
+ *  Shared by the kernel files: whether we're building for x86 at all,
+ *  the per function target attributes and the runtime levels the
+ *  kernels get picked from
+ * #############################################
+ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_HAS_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_HAS_X86 0
+#endif
+
+// We don't build the whole programme for AVX2 (the CPU might not have it),
+// GCC/Clang need telling per function, MSVC lets us use the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX2
+#endif
+
+#define SIMD_LEVEL_SCALAR 0
+#define SIMD_LEVEL_SSE2 1
+#define SIMD_LEVEL_AVX2 2
+
+int simd_detect_level();
+int simd_supported_level(int level);
+const char* simd_level_name(int level);
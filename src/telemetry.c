@@ -0,0 +1,172 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // ftruncate
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "constants.h"
+#include "telemetry.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+SDL_COMPILE_TIME_ASSERT(telemetry_record_size, sizeof(struct telemetry_record) == 32);
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static Uint8* mapping = NULL;
+static size_t mapping_size;
+static struct telemetry_file_header* file_header;
+static struct telemetry_record* records;
+static Uint32 capacity_mask; // capacity is a power of 2 so a slot is a mask rather than a divide
+static Uint64 num_written; // our copy of the header's, so a write doesn't have to read the mapping back
+static const char* file_path;
+
+#ifdef _WIN32
+static HANDLE file_handle = INVALID_HANDLE_VALUE;
+static HANDLE mapping_handle = NULL;
+#endif
+
+/// <summary>
+///		Creates (or truncates) path at size bytes and maps all of it read/write
+/// </summary>
+static Uint8* map_file(const char* path, size_t size)
+{
+#ifdef _WIN32
+	file_handle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file_handle == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	// the mapping grows the file to size
+	mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READWRITE, (DWORD)((Uint64)size >> 32), (DWORD)size, NULL);
+
+	if (!mapping_handle)
+		return NULL;
+
+	return MapViewOfFile(mapping_handle, FILE_MAP_WRITE, 0, 0, size);
+#else
+	int file_descriptor = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (file_descriptor < 0)
+		return NULL;
+
+	void* view = MAP_FAILED;
+
+	if (ftruncate(file_descriptor, (off_t)size) == 0)
+		view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+
+	// the mapping keeps the file open
+	close(file_descriptor);
+
+	return view != MAP_FAILED ? view : NULL;
+#endif
+}
+
+static void unmap_file()
+{
+#ifdef _WIN32
+	if (mapping)
+		UnmapViewOfFile(mapping);
+
+	if (mapping_handle)
+		CloseHandle(mapping_handle);
+
+	if (file_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(file_handle);
+
+	mapping_handle = NULL;
+	file_handle = INVALID_HANDLE_VALUE;
+#else
+	if (mapping)
+		munmap(mapping, mapping_size);
+#endif
+
+	mapping = NULL;
+}
+
+/// <summary>
+///		Starts a new telemetry file at path with room for capacity records (rounded up to a power of 2)
+/// </summary>
+int telemetry_open(const char* path, int capacity)
+{
+	telemetry_close();
+
+	Uint32 ring_capacity = 1;
+
+	while (ring_capacity < (Uint32)SDL_max(capacity, 1) && ring_capacity < TELEMETRY_CAPACITY_MAX)
+		ring_capacity <<= 1;
+
+	mapping_size = sizeof(struct telemetry_file_header) + ((size_t)ring_capacity * sizeof(struct telemetry_record));
+	mapping = map_file(path, mapping_size);
+
+	if (!mapping)
+	{
+		printf("Could not map %s for telemetry.\n", path);
+		unmap_file();
+		return FALSE;
+	}
+
+	// touching every page now means a write never has to wait on a page fault
+	memset(mapping, 0, mapping_size);
+
+	file_header = (struct telemetry_file_header*)mapping;
+	records = (struct telemetry_record*)(mapping + sizeof(struct telemetry_file_header));
+	capacity_mask = ring_capacity - 1;
+	file_path = path;
+
+	memcpy(file_header->magic, TELEMETRY_FILE_MAGIC, sizeof(TELEMETRY_FILE_MAGIC));
+	file_header->version = TELEMETRY_FILE_VERSION;
+	file_header->record_size = sizeof(struct telemetry_record);
+	file_header->capacity = ring_capacity;
+	file_header->ticks_per_second = SIM_TICKS_PER_SECOND;
+	file_header->num_written = 0;
+	num_written = 0;
+
+	return TRUE;
+}
+
+int telemetry_is_open()
+{
+	return mapping != NULL;
+}
+
+/// <summary>
+///		Copies a record into the next slot of the ring, overwriting the oldest once it's full. Does nothing if telemetry is off.
+/// </summary>
+void telemetry_write(const struct telemetry_record* record)
+{
+	if (!mapping)
+		return;
+
+	records[num_written & capacity_mask] = *record;
+
+	// anyone reading the file while we're running sees the new count only once the record is in
+	SDL_MemoryBarrierRelease();
+	file_header->num_written = ++num_written;
+}
+
+void telemetry_close()
+{
+	if (!mapping)
+		return;
+
+	Uint64 num_overwritten = num_written > file_header->capacity ? num_written - file_header->capacity : 0;
+
+	printf("Telemetry: %llu records in %s (%llu overwritten)\n", (unsigned long long)num_written, file_path, (unsigned long long)num_overwritten);
+
+	// the OS writes back whatever is still dirty after we let go of it
+	unmap_file();
+	file_header = NULL;
+	records = NULL;
+}
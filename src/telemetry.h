@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL.h>
+#include "constants.h"
+
+/*
+ * #############################################
+ *  MATCH TELEMETRY
+ *  Fixed size binary records (paddle hits, goals, ball samples, match
+ *  start/end) appended to a ring in a memory mapped file. A write is a
+ *  32 byte copy into the mapping and a bump of the header's count, the
+ *  OS gets the pages to disk in its own time so the game loop never
+ *  waits on I/O. The whole file is touched when it's opened so the
+ *  first lap round the ring doesn't page fault either. Once the ring
+ *  is full the oldest records are overwritten. tools/telemetry_report.c
+ *  reads it back offline.
+ *
+ *  Records are written native endian with no packing, like the replay
+ *  logs they're meant to be read back on the same machine.
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct telemetry_file_header
+{
+	char magic[8];
+	Uint32 version;
+	Uint32 record_size;
+	Uint32 capacity; // records in the ring after the header
+	Uint32 ticks_per_second;
+	Uint64 num_written; // ever, record n is in slot n % capacity (the writer only bumps it once the record is in)
+};
+
+struct telemetry_record
+{
+	Uint32 tick; // simulation ticks since the file was opened
+	Uint32 elapsed_ms; // round clock
+	Uint8 type; // TELEMETRY_RECORD_*
+	Uint8 paddle_index; // the paddle that was hit, or the player who scored
+	Uint8 round_num;
+	Uint8 points[PADDLES_NUM_MAX]; // after the event
+	Uint8 reserved;
+	Sint16 hit_pos; // paddle hits, paddle bottom - ball top
+	float ball_x; // middle of the ball
+	float ball_y;
+	float ball_dx; // px a tick
+	float ball_dy;
+};
+
+int telemetry_open(const char* path, int capacity);
+int telemetry_is_open();
+void telemetry_write(const struct telemetry_record* record);
+void telemetry_close();
@@ -0,0 +1,68 @@
+#include <SDL.h>
+#include "constants.h"
+#include "triple_buffer.h"
+
+/// <summary>
+///		Starts the writer on slot 0 and the reader on slot 2, with nothing new in the middle
+/// </summary>
+void init_triple_buffer(struct triple_buffer* buffer, void* slot_0, void* slot_1, void* slot_2)
+{
+	buffer->slots[0] = slot_0;
+	buffer->slots[1] = slot_1;
+	buffer->slots[2] = slot_2;
+	buffer->back_index = 0;
+	buffer->front_index = 2;
+	SDL_AtomicSet(&buffer->middle, 1);
+}
+
+/// <summary>
+///		The slot the writer fills next, it's the writer's until triple_buffer_publish()
+/// </summary>
+void* triple_buffer_get_back(struct triple_buffer* buffer)
+{
+	return buffer->slots[buffer->back_index];
+}
+
+/// <summary>
+///		Makes the back slot the newest value and gives the writer the old middle slot to fill next
+/// </summary>
+/// <returns>TRUE if the reader took the value published before this one, FALSE if it was skipped</returns>
+int triple_buffer_publish(struct triple_buffer* buffer)
+{
+	// SDL_AtomicSet is only an acquire barrier on some compilers, everything written to the slot has to land first
+	SDL_MemoryBarrierRelease();
+
+	int old_middle = SDL_AtomicSet(&buffer->middle, buffer->back_index | TRIPLE_BUFFER_FRESH);
+	buffer->back_index = old_middle & TRIPLE_BUFFER_INDEX_MASK;
+
+	return !(old_middle & TRIPLE_BUFFER_FRESH);
+}
+
+/// <summary>
+///		Swaps the front slot for the middle one if the writer has published since we last did
+/// </summary>
+/// <returns>TRUE if the front slot now has a newer value</returns>
+int triple_buffer_acquire(struct triple_buffer* buffer)
+{
+	// only the writer sets the flag and only we clear it, so once it's set it stays set until the swap below
+	if (!(SDL_AtomicGet(&buffer->middle) & TRIPLE_BUFFER_FRESH))
+		return FALSE;
+
+	// done reading the old front before the writer can have it back
+	SDL_MemoryBarrierRelease();
+
+	int old_middle = SDL_AtomicSet(&buffer->middle, buffer->front_index);
+	buffer->front_index = old_middle & TRIPLE_BUFFER_INDEX_MASK;
+
+	SDL_MemoryBarrierAcquire();
+
+	return TRUE;
+}
+
+/// <summary>
+///		The newest value we've acquired, it stays put until the next triple_buffer_acquire()
+/// </summary>
+void* triple_buffer_get_front(struct triple_buffer* buffer)
+{
+	return buffer->slots[buffer->front_index];
+}
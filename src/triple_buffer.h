@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  TRIPLE BUFFER
+ *  Hands the newest of a stream of values from one writer thread to one
+ *  reader thread without either of them ever waiting on the other. The
+ *  caller owns three slots: the writer fills its back slot and swaps it
+ *  for the middle one, the reader swaps its front slot for the middle
+ *  one whenever the writer has put something newer there. Each side has
+ *  its slot to itself until it swaps it away, the only thing they share
+ *  is one atomic int (the middle slot and whether it's new).
+ *
+ *  The reader only ever gets the newest value, anything the writer
+ *  published in between is skipped (publish says when that happened).
+ * #############################################
+ */
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct triple_buffer
+{
+	void* slots[3];
+	SDL_atomic_t middle; // the middle slot's index, plus TRIPLE_BUFFER_FRESH if the reader hasn't taken it yet
+	int back_index; // only the writer touches this
+	int front_index; // only the reader touches this
+};
+
+void init_triple_buffer(struct triple_buffer* buffer, void* slot_0, void* slot_1, void* slot_2);
+
+void* triple_buffer_get_back(struct triple_buffer* buffer);
+int triple_buffer_publish(struct triple_buffer* buffer);
+
+int triple_buffer_acquire(struct triple_buffer* buffer);
+void* triple_buffer_get_front(struct triple_buffer* buffer);
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <SDL.h>
+#include "constants.h"
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct game_button_state
+{
+	int half_transition_count; // transition as in multiple taps of a button for dash actions
+	int ended_down;
+	Uint32 transition_timestamp_ms; // SDL event timestamp of the latest transition
+};
+
+struct game_controller_input
+{
+	int is_connected;
+	int is_analogue; // e.g - true for gamepads, false for keyboards
+
+	// Stick averages used to determine if there
+	// was a trigger on our movement buttons
+	float stick_average_x;
+	float stick_average_y;
+
+	union
+	{
+		struct game_button_state buttons[2]; // array size same as num struct members below (minus terminator)
+
+		struct {
+			struct game_button_state move_up;
+			struct game_button_state move_down;
+
+			// NOTE: All buttons must be added above this line 
+			// (allows to Assert the Buttons array size is equal to num members above terminator)
+			struct game_button_state terminator;
+		};
+	};
+};
+
+struct game_input 
+{
+	struct game_button_state mouse_buttons[5];
+	int mouse_x, mouse_y, mouse_z;
+
+	float dt_for_frame;
+
+	struct game_controller_input controllers[GAME_CONTROLLERS_MAX]; // includes keyboard "controllers"
+
+	// Game commands, these go through the input like the paddles so a tick only depends on state + input
+	struct game_button_state start;
+	struct game_button_state reset;
+};
+
+struct game_screen
+{
+	Uint8 index;
+	Uint8 should_run_game;
+};
+
+struct ball
+{
+	float width;
+	float height;
+	float x;
+	float y;
+	int dx; // movement vector
+	int dy; // movement vector
+};
+
+struct paddle
+{
+	float width;
+	float height;
+	float x;
+	float y;
+	int dx; // movement vector
+	int dy; // movement vector
+	int controller_index;
+};
+
+struct score 
+{
+	int points;
+};
+
+struct player
+{
+	struct score score;
+};
+
+struct round
+{
+	int round_num;
+	int elapsed_ms;
+	struct player players[PADDLES_NUM_MAX];
+};
+
+// Everything the simulation reads and writes, enough to restart a match from this exact point
+struct game_snapshot
+{
+	struct game_screen screen;
+	struct round round;
+	struct ball ball;
+	struct paddle paddles[PADDLES_NUM_MAX];
+};
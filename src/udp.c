@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "constants.h"
+#include "udp.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET udp_socket;
+#define UDP_INVALID_SOCKET INVALID_SOCKET
+#define close_udp_socket closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+typedef int udp_socket;
+#define UDP_INVALID_SOCKET -1
+#define close_udp_socket close
+#endif
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+
+// A packet the simulated network is sitting on until due_ms
+struct udp_delayed_packet
+{
+	int size; // 0 = free slot
+	Uint32 due_ms;
+	Uint8 data[UDP_PACKET_SIZE_MAX];
+};
+
+/*
+ * #############################################
+ *  GLOBALS
+ * #############################################
+ */
+static udp_socket socket_handle = UDP_INVALID_SOCKET;
+static struct sockaddr_in peer_address;
+
+static int latency_ms = 0;
+static int jitter_ms = 0;
+static int loss_percent = 0;
+static Uint32 random_state = 1;
+
+static struct udp_delayed_packet delayed_packets[UDP_DELAY_QUEUE_MAX];
+static struct udp_stats stats;
+
+/// <summary>
+///		Same xorshift as the bots, so a seed gives the same pattern of drops and delays
+/// </summary>
+static Uint32 next_random()
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/// <summary>
+///		Opens a socket on 127.0.0.1:local_port that sends to 127.0.0.1:peer_port
+/// </summary>
+int udp_open(Uint16 local_port, Uint16 peer_port)
+{
+#ifdef _WIN32
+	WSADATA wsa_data;
+
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+	{
+		printf("Could not start Winsock.\n");
+		return FALSE;
+	}
+#endif
+
+	socket_handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (socket_handle == UDP_INVALID_SOCKET)
+	{
+		printf("Could not create a UDP socket.\n");
+		udp_close();
+		return FALSE;
+	}
+
+	struct sockaddr_in local_address;
+	SDL_zero(local_address);
+	local_address.sin_family = AF_INET;
+	local_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	local_address.sin_port = htons(local_port);
+
+	if (bind(socket_handle, (const struct sockaddr*)&local_address, sizeof(local_address)) != 0)
+	{
+		printf("Could not bind UDP port %d (is another instance using it?)\n", local_port);
+		udp_close();
+		return FALSE;
+	}
+
+	// the game loop polls every tick, it can never wait on the network
+#ifdef _WIN32
+	u_long is_non_blocking = 1;
+	int is_mode_set = ioctlsocket(socket_handle, FIONBIO, &is_non_blocking) == 0;
+#else
+	int is_mode_set = fcntl(socket_handle, F_SETFL, fcntl(socket_handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+
+	if (!is_mode_set)
+	{
+		printf("Could not make the UDP socket non-blocking.\n");
+		udp_close();
+		return FALSE;
+	}
+
+	SDL_zero(peer_address);
+	peer_address.sin_family = AF_INET;
+	peer_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	peer_address.sin_port = htons(peer_port);
+
+	SDL_zero(delayed_packets);
+	SDL_zero(stats);
+
+	return TRUE;
+}
+
+void udp_close()
+{
+	if (socket_handle != UDP_INVALID_SOCKET)
+		close_udp_socket(socket_handle);
+
+	socket_handle = UDP_INVALID_SOCKET;
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+/// <summary>
+///		Sets how bad the simulated network is for everything we send from now on
+/// </summary>
+void udp_set_conditions(int new_latency_ms, int new_jitter_ms, int new_loss_percent, Uint32 seed)
+{
+	latency_ms = SDL_max(new_latency_ms, 0);
+	jitter_ms = SDL_max(new_jitter_ms, 0);
+	loss_percent = SDL_max(0, SDL_min(new_loss_percent, 100));
+	random_state = seed ? seed : 1;
+}
+
+static void send_now(const void* data, int size)
+{
+	sendto(socket_handle, (const char*)data, size, 0, (const struct sockaddr*)&peer_address, sizeof(peer_address));
+}
+
+/// <summary>
+///		Sends a packet to the peer through the simulated network
+/// </summary>
+/// <returns>FALSE if the packet is too big to send</returns>
+int udp_send(const void* data, int size)
+{
+	if (size <= 0 || size > UDP_PACKET_SIZE_MAX)
+		return FALSE;
+
+	stats.num_sent++;
+
+	if (loss_percent > 0 && (int)(next_random() % 100) < loss_percent)
+	{
+		stats.num_dropped++;
+		return TRUE;
+	}
+
+	Uint32 delay_ms = latency_ms + (jitter_ms > 0 ? next_random() % (jitter_ms + 1) : 0);
+
+	if (delay_ms == 0)
+	{
+		send_now(data, size);
+		return TRUE;
+	}
+
+	for (int i = 0; i < UDP_DELAY_QUEUE_MAX; i++)
+	{
+		struct udp_delayed_packet* packet = &delayed_packets[i];
+
+		if (packet->size != 0)
+			continue;
+
+		packet->size = size;
+		packet->due_ms = SDL_GetTicks() + delay_ms;
+		SDL_memcpy(packet->data, data, size);
+		return TRUE;
+	}
+
+	// a real network would have dropped it too
+	stats.num_dropped++;
+	return TRUE;
+}
+
+/// <summary>
+///		Sends whatever the simulated network has held back long enough, call it every tick
+/// </summary>
+void udp_flush()
+{
+	Uint32 now_ms = SDL_GetTicks();
+
+	for (int i = 0; i < UDP_DELAY_QUEUE_MAX; i++)
+	{
+		struct udp_delayed_packet* packet = &delayed_packets[i];
+
+		if (packet->size == 0 || !SDL_TICKS_PASSED(now_ms, packet->due_ms))
+			continue;
+
+		send_now(packet->data, packet->size);
+		packet->size = 0;
+	}
+}
+
+/// <summary>
+///		Takes the next packet off the socket if there is one (only packets from the peer's port count)
+/// </summary>
+/// <returns>The packet size, 0 if nothing was waiting</returns>
+int udp_receive(void* data, int size_max)
+{
+	for (;;)
+	{
+		struct sockaddr_in from_address;
+		socklen_t from_size = sizeof(from_address);
+		int size = (int)recvfrom(socket_handle, (char*)data, size_max, 0, (struct sockaddr*)&from_address, &from_size);
+
+		if (size <= 0)
+			return 0;
+
+		if (from_address.sin_port != peer_address.sin_port)
+			continue;
+
+		stats.num_received++;
+		return size;
+	}
+}
+
+void udp_get_stats(struct udp_stats* out_stats)
+{
+	*out_stats = stats;
+}
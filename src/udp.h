@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL.h>
+
+/*
+ * #############################################
+ *  UDP LOOPBACK
+ *  One non-blocking UDP socket on 127.0.0.1 talking to one peer port, with
+ *  a fake bad network in front of it: every packet we send can be held back
+ *  (latency + random jitter, so they can arrive out of order) or dropped.
+ *  Lets two local instances be tested against each other on one machine.
+ * #############################################
+ */
+
+struct udp_stats
+{
+	Uint64 num_sent;
+	Uint64 num_dropped; // by the simulated loss (or the delay queue being full)
+	Uint64 num_received;
+};
+
+int udp_open(Uint16 local_port, Uint16 peer_port);
+void udp_close();
+void udp_set_conditions(int latency_ms, int jitter_ms, int loss_percent, Uint32 seed);
+
+int udp_send(const void* data, int size);
+int udp_receive(void* data, int size_max);
+void udp_flush();
+
+void udp_get_stats(struct udp_stats* stats);
@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/constants.h"
+
+/*
+ * Build step that bakes the bitmaps in assets/ into src/baked_assets.c, see
+ * src/baked_assets.h for what comes out the other end.
+ *
+ *   bake_assets <assets dir> <output .c>
+ *
+ * No SDL in here on purpose so it builds with nothing but a C compiler
+ * before the game does (the Makefile and the Visual Studio pre-build event
+ * both compile and run it). It only has to read the BMPs GIMP exports,
+ * uncompressed 24 or 32 bit with or without channel masks.
+ */
+
+#define BAKE_SPRITES_NUM 5
+#define BAKE_PIXELS_PER_LINE 12
+
+// 5x7 HUD font from ' ' to '_', a row of 5 bits a byte with the leftmost pixel in bit 4
+static const unsigned char hud_font_rows[HUD_FONT_GLYPHS_NUM][HUD_FONT_GLYPH_HEIGHT] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+	{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // !
+	{ 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+	{ 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A }, // #
+	{ 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 }, // $
+	{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+	{ 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D }, // &
+	{ 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+	{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+	{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+	{ 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 }, // *
+	{ 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // +
+	{ 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, // ,
+	{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // .
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+	{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+	{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+	{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+	{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+	{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+	{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+	{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+	{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 }, // ;
+	{ 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // <
+	{ 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 }, // =
+	{ 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // >
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+	{ 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E }, // @
+	{ 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // A
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // B
+	{ 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // C
+	{ 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // D
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // E
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // F
+	{ 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // G
+	{ 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // H
+	{ 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // I
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // J
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // L
+	{ 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+	{ 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // O
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // P
+	{ 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // Q
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // R
+	{ 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // S
+	{ 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // U
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // V
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // W
+	{ 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // X
+	{ 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // Y
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // Z
+	{ 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E }, // [
+	{ 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // backslash
+	{ 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E }, // ]
+	{ 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 }, // ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F }, // _
+};
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct bake_sprite
+{
+	const char* name; // baked_<name>_rect
+	const char* file_name; // NULL if generate draws it instead
+	void (*generate)(struct bake_sprite* sprite);
+	int width;
+	int height;
+	unsigned int* pixels; // ABGR8888, keyed pixels already cleared
+	int atlas_x;
+	int atlas_y;
+};
+
+static unsigned int read_u16(const unsigned char* bytes)
+{
+	return bytes[0] | (bytes[1] << 8);
+}
+
+static unsigned int read_u32(const unsigned char* bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+/// <summary>
+///		Pulls one channel out of a pixel with its mask and scales it to 8 bits
+/// </summary>
+static unsigned int extract_channel(unsigned int pixel, unsigned int mask)
+{
+	if (mask == 0)
+		return 0xFF; // no alpha mask means opaque
+
+	int shift = 0;
+
+	while (!((mask >> shift) & 1))
+		shift++;
+
+	unsigned int max_value = mask >> shift;
+	return (((pixel & mask) >> shift) * 0xFF) / max_value;
+}
+
+/// <summary>
+///		Loads a BMP into ABGR8888 with the colour key (255, 0, 255) cleared to 0
+/// </summary>
+static int load_sprite(const char* assets_dir, struct bake_sprite* sprite)
+{
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%s", assets_dir, sprite->file_name);
+
+	FILE* file = fopen(path, "rb");
+
+	if (!file)
+	{
+		printf("Could not open %s.\n", path);
+		return FALSE;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	unsigned char* bytes = malloc(file_size);
+	int is_read = bytes && fread(bytes, 1, file_size, file) == (size_t)file_size;
+	fclose(file);
+
+	if (!is_read || file_size < 54 || bytes[0] != 'B' || bytes[1] != 'M')
+	{
+		printf("%s isn't a BMP.\n", path);
+		free(bytes);
+		return FALSE;
+	}
+
+	unsigned int pixels_offset = read_u32(bytes + 10);
+	unsigned int header_size = read_u32(bytes + 14);
+	int width = (int)read_u32(bytes + 18);
+	int height = (int)read_u32(bytes + 22);
+	unsigned int bits_per_pixel = read_u16(bytes + 28);
+	unsigned int compression = read_u32(bytes + 30);
+
+	// BI_RGB is BGR(A) in memory, BI_BITFIELDS says where each channel is
+	unsigned int red_mask = 0x00FF0000, green_mask = 0x0000FF00, blue_mask = 0x000000FF;
+	unsigned int alpha_mask = bits_per_pixel == 32 && header_size > 40 ? 0xFF000000 : 0;
+
+	if (compression == 3 && 14 + header_size + (header_size == 40 ? 12 : 0) <= (unsigned int)file_size)
+	{
+		red_mask = read_u32(bytes + 54);
+		green_mask = read_u32(bytes + 58);
+		blue_mask = read_u32(bytes + 62);
+		alpha_mask = header_size > 40 ? read_u32(bytes + 66) : 0;
+	}
+
+	int is_top_down = height < 0;
+	height = abs(height);
+	int stride = ((width * (int)bits_per_pixel / 8) + 3) & ~3;
+
+	if ((bits_per_pixel != 24 && bits_per_pixel != 32) || (compression != 0 && compression != 3) || pixels_offset + (long)stride * height > file_size)
+	{
+		printf("%s needs to be an uncompressed 24 or 32 bit BMP.\n", path);
+		free(bytes);
+		return FALSE;
+	}
+
+	sprite->width = width;
+	sprite->height = height;
+	sprite->pixels = malloc(sizeof(unsigned int) * width * height);
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = bytes + pixels_offset + (long)stride * (is_top_down ? y : height - 1 - y);
+
+		for (int x = 0; x < width; x++)
+		{
+			const unsigned char* source = row + (x * bits_per_pixel / 8);
+			unsigned int pixel = bits_per_pixel == 32 ? read_u32(source) : (unsigned int)(source[0] | (source[1] << 8) | (source[2] << 16));
+
+			unsigned int r = extract_channel(pixel, red_mask);
+			unsigned int g = extract_channel(pixel, green_mask);
+			unsigned int b = extract_channel(pixel, blue_mask);
+			unsigned int a = extract_channel(pixel, alpha_mask);
+
+			// keyed pixels go fully clear, a straight copy onto the cleared static layer is then the same as a keyed blit
+			int is_keyed = r == 0xFF && g == 0x00 && b == 0xFF;
+			sprite->pixels[(y * width) + x] = is_keyed ? 0 : (a << 24) | (b << 16) | (g << 8) | r;
+		}
+	}
+
+	free(bytes);
+	return TRUE;
+}
+
+static void generate_white_block(struct bake_sprite* sprite)
+{
+	for (int p = 0; p < sprite->width * sprite->height; p++)
+		sprite->pixels[p] = 0xFFFFFFFF;
+}
+
+/// <summary>
+///		Draws the HUD font into a grid of HUD_FONT_GLYPHS_PER_ROW cells, already scaled up
+///		by HUD_FONT_SCALE so both renderers draw a glyph as a straight 1:1 copy
+/// </summary>
+static void generate_hud_font(struct bake_sprite* sprite)
+{
+	memset(sprite->pixels, 0, sizeof(unsigned int) * sprite->width * sprite->height);
+
+	for (int glyph = 0; glyph < HUD_FONT_GLYPHS_NUM; glyph++)
+	{
+		int cell_x = (glyph % HUD_FONT_GLYPHS_PER_ROW) * HUD_FONT_CELL_WIDTH;
+		int cell_y = (glyph / HUD_FONT_GLYPHS_PER_ROW) * HUD_FONT_CELL_HEIGHT;
+
+		for (int y = 0; y < HUD_FONT_GLYPH_HEIGHT * HUD_FONT_SCALE; y++)
+		{
+			for (int x = 0; x < HUD_FONT_GLYPH_WIDTH * HUD_FONT_SCALE; x++)
+			{
+				int bit = (HUD_FONT_GLYPH_WIDTH - 1) - (x / HUD_FONT_SCALE);
+
+				if ((hud_font_rows[glyph][y / HUD_FONT_SCALE] >> bit) & 1)
+					sprite->pixels[((cell_y + y) * sprite->width) + cell_x + x] = 0xFFFFFFFF;
+			}
+		}
+	}
+}
+
+static int compare_sprite_heights(const void* a, const void* b)
+{
+	const struct bake_sprite* lhs = *(const struct bake_sprite* const*)a;
+	const struct bake_sprite* rhs = *(const struct bake_sprite* const*)b;
+	return rhs->height - lhs->height;
+}
+
+/// <summary>
+///		Shelf packs the sprites tallest first into an atlas as wide as the widest one,
+///		each goes on the first shelf with room left for it
+/// </summary>
+static void pack_sprites(struct bake_sprite* sprites, int* atlas_width, int* atlas_height)
+{
+	struct bake_sprite* sorted[BAKE_SPRITES_NUM];
+	int shelf_x[BAKE_SPRITES_NUM], shelf_y[BAKE_SPRITES_NUM];
+	int num_shelves = 0;
+	*atlas_width = 0;
+
+	for (int i = 0; i < BAKE_SPRITES_NUM; i++)
+	{
+		sorted[i] = &sprites[i];
+
+		if (sprites[i].width > *atlas_width)
+			*atlas_width = sprites[i].width;
+	}
+
+	qsort(sorted, BAKE_SPRITES_NUM, sizeof(sorted[0]), compare_sprite_heights);
+
+	*atlas_height = 0;
+
+	for (int i = 0; i < BAKE_SPRITES_NUM; i++)
+	{
+		struct bake_sprite* sprite = sorted[i];
+		int shelf = 0;
+
+		// tallest first, so every shelf is already tall enough for whatever comes after
+		while (shelf < num_shelves && shelf_x[shelf] + sprite->width > *atlas_width)
+			shelf++;
+
+		if (shelf == num_shelves)
+		{
+			shelf_x[shelf] = 0;
+			shelf_y[shelf] = *atlas_height;
+			*atlas_height += sprite->height;
+			num_shelves++;
+		}
+
+		sprite->atlas_x = shelf_x[shelf];
+		sprite->atlas_y = shelf_y[shelf];
+		shelf_x[shelf] += sprite->width;
+	}
+}
+
+static int write_baked_assets(const char* path, const struct bake_sprite* sprites, int atlas_width, int atlas_height)
+{
+	unsigned int* atlas = calloc((size_t)atlas_width * atlas_height, sizeof(unsigned int));
+	FILE* file = fopen(path, "w");
+
+	if (!atlas || !file)
+	{
+		printf("Could not write %s.\n", path);
+		free(atlas);
+
+		if (file)
+			fclose(file);
+
+		return FALSE;
+	}
+
+	for (int i = 0; i < BAKE_SPRITES_NUM; i++)
+	{
+		const struct bake_sprite* sprite = &sprites[i];
+
+		for (int y = 0; y < sprite->height; y++)
+			memcpy(&atlas[((sprite->atlas_y + y) * atlas_width) + sprite->atlas_x], &sprite->pixels[y * sprite->width], sizeof(unsigned int) * sprite->width);
+	}
+
+	fprintf(file, "// Generated by tools/bake_assets.c from the bitmaps in assets/, don't edit it (the build bakes it again)\n");
+	fprintf(file, "#include <SDL.h>\n#include \"baked_assets.h\"\n\n");
+	fprintf(file, "const int baked_atlas_width = %d;\n", atlas_width);
+	fprintf(file, "const int baked_atlas_height = %d;\n\n", atlas_height);
+
+	for (int i = 0; i < BAKE_SPRITES_NUM; i++)
+		fprintf(file, "const SDL_Rect baked_%s_rect = { %d, %d, %d, %d };\n", sprites[i].name, sprites[i].atlas_x, sprites[i].atlas_y, sprites[i].width, sprites[i].height);
+
+	fprintf(file, "\nconst Uint32 baked_atlas_pixels[%d] = {\n", atlas_width * atlas_height);
+
+	for (int i = 0; i < atlas_width * atlas_height; i++)
+	{
+		if (i % BAKE_PIXELS_PER_LINE == 0)
+			fprintf(file, "\t");
+
+		// most of it is cleared key, keep the file down
+		if (atlas[i] == 0)
+			fprintf(file, "0,");
+		else
+			fprintf(file, "0x%08X,", atlas[i]);
+
+		fprintf(file, (i % BAKE_PIXELS_PER_LINE == BAKE_PIXELS_PER_LINE - 1) ? "\n" : " ");
+	}
+
+	fprintf(file, "\n};\n");
+
+	int is_written = !ferror(file);
+	fclose(file);
+	free(atlas);
+
+	return is_written;
+}
+
+int main(int argc, char* args[])
+{
+	if (argc != 3)
+	{
+		printf("Usage: bake_assets <assets dir> <output .c>\n");
+		return 1;
+	}
+
+	struct bake_sprite sprites[BAKE_SPRITES_NUM] = {
+		{ "title", "title_screen.bmp" },
+		{ "num_map", "num_sprite_map.bmp" },
+		{ "game_over", "game_over_screen.bmp" },
+		{ "white", NULL, generate_white_block, HW_ATLAS_WHITE_SIZE, HW_ATLAS_WHITE_SIZE },
+		{ "hud_font", NULL, generate_hud_font, HUD_FONT_GLYPHS_PER_ROW * HUD_FONT_CELL_WIDTH, (HUD_FONT_GLYPHS_NUM / HUD_FONT_GLYPHS_PER_ROW) * HUD_FONT_CELL_HEIGHT },
+	};
+
+	for (int i = 0; i < BAKE_SPRITES_NUM; i++)
+	{
+		struct bake_sprite* sprite = &sprites[i];
+
+		if (sprite->file_name)
+		{
+			if (!load_sprite(args[1], sprite))
+				return 1;
+
+			continue;
+		}
+
+		sprite->pixels = malloc(sizeof(unsigned int) * sprite->width * sprite->height);
+		sprite->generate(sprite);
+	}
+
+	int atlas_width, atlas_height;
+	pack_sprites(sprites, &atlas_width, &atlas_height);
+
+	if (!write_baked_assets(args[2], sprites, atlas_width, atlas_height))
+		return 1;
+
+	printf("Baked %dx%d sprite atlas into %s\n", atlas_width, atlas_height, args[2]);
+
+	for (int i = 0; i < BAKE_SPRITES_NUM; i++)
+		free(sprites[i].pixels);
+
+	return 0;
+}
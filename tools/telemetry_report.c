@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL.h>
+#include "../src/constants.h"
+#include "../src/telemetry.h"
+
+/*
+ * Offline reader for the ring files `pong --telemetry` writes (see
+ * src/telemetry.h), built by `make telemetry`.
+ *
+ *   telemetry_report <file.tlm>
+ *
+ * Walks the records oldest first and prints per match totals, rally
+ * lengths, where on the paddles the ball hits, how the ball speeds up
+ * through a rally and how long points take. It can be run on a file the
+ * game still has open, it only counts up to the records the writer had
+ * finished.
+ */
+
+#define REPORT_RALLY_HITS_MAX 64 // longer rallies all go in the last bucket
+#define REPORT_HIT_BAND_HEIGHT 9
+#define REPORT_HIT_BANDS_NUM (((PADDLE_HEIGHT + BALL_SIZE) / REPORT_HIT_BAND_HEIGHT) + 1) // the last one is anything off the ends
+#define REPORT_SPEED_BUCKET_S 5
+#define REPORT_SPEED_BUCKETS_NUM 12
+#define REPORT_BAR_WIDTH_MAX 40
+
+/*
+ * #############################################
+ *  TYPE DEFS
+ * #############################################
+ */
+struct report
+{
+	int num_matches;
+	int num_matches_finished; // started and won, not reset part way
+	int num_hits;
+	int num_goals;
+	int goals_by_player[PADDLES_NUM_MAX];
+	int hits_by_paddle[PADDLES_NUM_MAX];
+
+	// Rallies, serve to goal
+	int num_rallies;
+	int rally_hits[REPORT_RALLY_HITS_MAX + 1];
+	double rally_seconds_total;
+	double rally_seconds_max;
+	double* rally_seconds; // every rally, for the median
+	int rally_seconds_capacity;
+
+	// Hit bands, 0 is where the ball's top is level with the bottom of the paddle
+	int hit_bands[PADDLES_NUM_MAX][REPORT_HIT_BANDS_NUM];
+
+	// Ball speed by time into the rally
+	double speed_totals[REPORT_SPEED_BUCKETS_NUM];
+	int speed_samples[REPORT_SPEED_BUCKETS_NUM];
+	double speed_max;
+};
+
+static int compare_doubles(const void* a, const void* b)
+{
+	double lhs = *(const double*)a;
+	double rhs = *(const double*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+static void print_bar(int value, int max_value)
+{
+	int width = max_value > 0 ? (value * REPORT_BAR_WIDTH_MAX + max_value - 1) / max_value : 0;
+
+	for (int i = 0; i < width; i++)
+		putchar('#');
+
+	putchar('\n');
+}
+
+static void add_rally(struct report* report, int num_hits, double seconds)
+{
+	if (report->num_rallies == report->rally_seconds_capacity)
+	{
+		report->rally_seconds_capacity = SDL_max(report->rally_seconds_capacity * 2, 256);
+		report->rally_seconds = realloc(report->rally_seconds, report->rally_seconds_capacity * sizeof(double));
+	}
+
+	report->rally_seconds[report->num_rallies++] = seconds;
+	report->rally_hits[SDL_min(num_hits, REPORT_RALLY_HITS_MAX)]++;
+	report->rally_seconds_total += seconds;
+	report->rally_seconds_max = SDL_max(report->rally_seconds_max, seconds);
+}
+
+/// <summary>
+///		Runs every record through the report in the order they were written
+/// </summary>
+static void aggregate(struct report* report, const struct telemetry_record* records, Uint64 num_records, Uint32 ticks_per_second)
+{
+	int is_in_match = FALSE;
+	Uint32 serve_tick = 0;
+	int rally_hits = 0;
+
+	for (Uint64 i = 0; i < num_records; i++)
+	{
+		const struct telemetry_record* record = &records[i];
+		double seconds_into_rally = (double)(record->tick - serve_tick) / ticks_per_second;
+
+		switch (record->type) {
+			case TELEMETRY_RECORD_MATCH_START:
+				is_in_match = TRUE;
+				serve_tick = record->tick;
+				rally_hits = 0;
+				report->num_matches++;
+				break;
+
+			case TELEMETRY_RECORD_PADDLE_HIT:
+			{
+				int paddle_index = SDL_min(record->paddle_index, PADDLES_NUM_MAX - 1);
+				int band = record->hit_pos < 0 ? REPORT_HIT_BANDS_NUM - 1 : SDL_min(record->hit_pos / REPORT_HIT_BAND_HEIGHT, REPORT_HIT_BANDS_NUM - 1);
+
+				report->num_hits++;
+				report->hits_by_paddle[paddle_index]++;
+				report->hit_bands[paddle_index][band]++;
+				rally_hits++;
+				break;
+			}
+
+			case TELEMETRY_RECORD_GOAL:
+				report->num_goals++;
+				report->goals_by_player[SDL_min(record->paddle_index, PADDLES_NUM_MAX - 1)]++;
+
+				// the ring can start part way through a rally, only count the ones we saw served
+				if (is_in_match)
+					add_rally(report, rally_hits, seconds_into_rally);
+
+				serve_tick = record->tick;
+				rally_hits = 0;
+				break;
+
+			case TELEMETRY_RECORD_BALL_SAMPLE:
+			{
+				if (!is_in_match)
+					break;
+
+				double speed = sqrt((double)(record->ball_dx * record->ball_dx) + (double)(record->ball_dy * record->ball_dy));
+				int bucket = SDL_min((int)(seconds_into_rally / REPORT_SPEED_BUCKET_S), REPORT_SPEED_BUCKETS_NUM - 1);
+
+				report->speed_totals[bucket] += speed;
+				report->speed_samples[bucket]++;
+				report->speed_max = SDL_max(report->speed_max, speed);
+				break;
+			}
+
+			case TELEMETRY_RECORD_MATCH_END:
+				if (is_in_match && (record->points[0] == SCORE_MAX || record->points[1] == SCORE_MAX))
+					report->num_matches_finished++;
+
+				is_in_match = FALSE;
+				break;
+		}
+	}
+}
+
+static void print_report(const struct report* report, Uint64 num_records, Uint64 num_written)
+{
+	printf("Records: %llu (%llu written, the oldest %llu were overwritten)\n",
+		(unsigned long long)num_records, (unsigned long long)num_written, (unsigned long long)(num_written - num_records));
+	printf("Matches: %d started, %d played to %d\n", report->num_matches, report->num_matches_finished, SCORE_MAX);
+	printf("Paddle hits: %d (left %d, right %d)\n", report->num_hits, report->hits_by_paddle[0], report->hits_by_paddle[1]);
+	printf("Goals: %d (left player %d, right player %d)\n", report->num_goals, report->goals_by_player[0], report->goals_by_player[1]);
+
+	if (report->num_rallies > 0)
+	{
+		double* sorted_seconds = malloc(report->num_rallies * sizeof(double));
+		memcpy(sorted_seconds, report->rally_seconds, report->num_rallies * sizeof(double));
+		qsort(sorted_seconds, report->num_rallies, sizeof(double), compare_doubles);
+
+		int total_hits = 0;
+		int max_count = 0;
+		int longest_hits = 0;
+
+		for (int hits = 0; hits <= REPORT_RALLY_HITS_MAX; hits++)
+		{
+			total_hits += hits * report->rally_hits[hits];
+			max_count = SDL_max(max_count, report->rally_hits[hits]);
+			longest_hits = report->rally_hits[hits] > 0 ? hits : longest_hits;
+		}
+
+		printf("\nRallies (serve to goal): %d\n", report->num_rallies);
+		printf("  hits   mean %.1f, longest %d%s\n", (double)total_hits / report->num_rallies, longest_hits, longest_hits == REPORT_RALLY_HITS_MAX ? "+" : "");
+		printf("  time   mean %.1f s, p50 %.1f s, longest %.1f s\n",
+			report->rally_seconds_total / report->num_rallies, sorted_seconds[report->num_rallies / 2], report->rally_seconds_max);
+
+		for (int hits = 0; hits <= longest_hits; hits++)
+		{
+			printf("  %3d%s hits %5d  ", hits, hits == REPORT_RALLY_HITS_MAX ? "+" : " ", report->rally_hits[hits]);
+			print_bar(report->rally_hits[hits], max_count);
+		}
+
+		free(sorted_seconds);
+	}
+
+	if (report->num_hits > 0)
+	{
+		printf("\nWhere the ball hits the paddle, px from the paddle's bottom edge up to the ball's top (top of the paddle first)\n");
+
+		for (int paddle_index = 0; paddle_index < PADDLES_NUM_MAX; paddle_index++)
+		{
+			int max_count = 0;
+
+			for (int band = 0; band < REPORT_HIT_BANDS_NUM; band++)
+				max_count = SDL_max(max_count, report->hit_bands[paddle_index][band]);
+
+			printf("  %s paddle\n", paddle_index == 0 ? "left" : "right");
+
+			// hit_pos counts up from the bottom edge, the last band is anything that clipped an end
+			for (int band = REPORT_HIT_BANDS_NUM - 2; band >= 0; band--)
+			{
+				printf("    %3d-%3dpx %5d  ", band * REPORT_HIT_BAND_HEIGHT, (band + 1) * REPORT_HIT_BAND_HEIGHT - 1, report->hit_bands[paddle_index][band]);
+				print_bar(report->hit_bands[paddle_index][band], max_count);
+			}
+
+			printf("    ends      %5d\n", report->hit_bands[paddle_index][REPORT_HIT_BANDS_NUM - 1]);
+		}
+	}
+
+	printf("\nBall speed by time into the rally (px a tick, fastest %.1f)\n", report->speed_max);
+
+	for (int bucket = 0; bucket < REPORT_SPEED_BUCKETS_NUM; bucket++)
+	{
+		if (report->speed_samples[bucket] == 0)
+			continue;
+
+		printf("  %3d-%3ds%s %6.2f  (%d samples)\n",
+			bucket * REPORT_SPEED_BUCKET_S,
+			(bucket + 1) * REPORT_SPEED_BUCKET_S,
+			bucket == REPORT_SPEED_BUCKETS_NUM - 1 ? "+" : " ",
+			report->speed_totals[bucket] / report->speed_samples[bucket],
+			report->speed_samples[bucket]);
+	}
+}
+
+int main(int argc, char* args[])
+{
+	if (argc < 2)
+	{
+		printf("Usage: telemetry_report <file.tlm>\n");
+		return 1;
+	}
+
+	FILE* file = fopen(args[1], "rb");
+
+	if (!file)
+	{
+		printf("Could not open %s.\n", args[1]);
+		return 1;
+	}
+
+	struct telemetry_file_header header;
+
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+		memcmp(header.magic, TELEMETRY_FILE_MAGIC, sizeof(TELEMETRY_FILE_MAGIC)) != 0 ||
+		header.version != TELEMETRY_FILE_VERSION ||
+		header.record_size != sizeof(struct telemetry_record) ||
+		header.capacity == 0 || (header.capacity & (header.capacity - 1)) != 0)
+	{
+		printf("%s is not a telemetry file from this version of the game.\n", args[1]);
+		fclose(file);
+		return 1;
+	}
+
+	struct telemetry_record* ring = malloc((size_t)header.capacity * sizeof(struct telemetry_record));
+	struct telemetry_record* records = malloc((size_t)header.capacity * sizeof(struct telemetry_record));
+
+	if (!ring || !records || fread(ring, sizeof(struct telemetry_record), header.capacity, file) != header.capacity)
+	{
+		printf("%s is cut short.\n", args[1]);
+		fclose(file);
+		return 1;
+	}
+
+	fclose(file);
+
+	// unwrap the ring, oldest first
+	Uint64 num_records = SDL_min(header.num_written, (Uint64)header.capacity);
+	Uint64 first_index = header.num_written - num_records;
+
+	for (Uint64 i = 0; i < num_records; i++)
+		records[i] = ring[(first_index + i) & (header.capacity - 1)];
+
+	struct report report;
+	SDL_zero(report);
+	aggregate(&report, records, num_records, header.ticks_per_second);
+	print_report(&report, num_records, header.num_written);
+
+	free(report.rally_seconds);
+	free(records);
+	free(ring);
+
+	return 0;
+}